@@ -48,6 +48,12 @@ end
 -- Log what the startup project will be
 premake.info("Startup project: " .. startup)
 
+-- Optional GL call tracer (see GraphicsModule/include/GLTrace.h), enable with "premake5 vs2019 --gl-trace"
+newoption {
+	trigger = "gl-trace",
+	description = "Wrap glad's function pointers to record GL calls and detect pipeline stalls"
+}
+
 -- This is our solution name
 workspace "OTTER"
 	-- Processor architecture
@@ -62,6 +68,11 @@ workspace "OTTER"
 		"Release"
 	}
 
+	-- When the tracer is not enabled, it compiles out completely
+	filter "options:gl-trace"
+		defines { "GL_TRACE_ENABLED" }
+	filter {}
+
 -- The directory name for our output
 outputdir = "%{cfg.buildcfg}-%{cfg.system}-%{cfg.architecture}"
 
@@ -94,6 +105,14 @@ ProjIncludes = {
 	"dependencies/bullet3/include",
 }
 
+-- Modules only see their own headers and the dependencies by default, this lists any other module include
+-- directories that a module needs, keyed by the module's name
+ModuleIncludes = {
+	-- SceneSerializer uses the toolkit's cereal helpers for GLM types (CerealGLM.h), Transform uses the
+	-- GraphicsModule's TransformStore and the SystemScheduler runs on the GraphicsModule's JobSystem
+	BaseApplicationModule = { "modules/toolkit/include", "modules/GraphicsModule/include" },
+}
+
 -- These are all the default dependencies that require linking
 Dependencies = {
 	"GLFW",
@@ -175,7 +194,8 @@ function CreateDefaultModule(folderName)
 		location(relpath)
 	    kind "StaticLib"
 	    language "C++"
-	    cppdialect "C++17"
+	    -- C++20 for coroutines (see Coroutine.h), our premake doesn't know "C++20" yet so we ask for the latest
+	    cppdialect "C++latest"
 
 	    -- Sets RuntimLibrary to MultiThreaded (non DLL version for static linking)
 	    staticruntime "on"
@@ -197,9 +217,13 @@ function CreateDefaultModule(folderName)
 		ProjIncludes[1] = path.join(relpath, "include")
 		-- Defines what directories we want to include
 		includedirs(ProjIncludes)
+		if ModuleIncludes[projName] ~= nil then
+			includedirs(ModuleIncludes[projName])
+		end
 
 		configuration "vs"
-	    	buildoptions { "/bigobj" }
+	    	-- c++latest also turns on strict conformance (/permissive-), we keep the conformance mode we've always built with
+	    	buildoptions { "/bigobj", "/permissive" }
 
 	    filter "system:windows"
 	        systemversion "latest"
@@ -308,8 +332,8 @@ function AddProjects(groupName, folders)
 			kind "ConsoleApp"
 			-- Language (we are using MSVC)
 			language "C++"
-			-- C++ version (we are using the c++17 standard)
-			cppdialect "C++17"
+			-- C++ version (we are using the c++20 standard for coroutines, our premake only knows it as latest)
+			cppdialect "C++latest"
 			-- Sets RuntimLibrary to MultiThreaded (non DLL version for static linking)
 			staticruntime "on"
 
@@ -363,7 +387,7 @@ function AddProjects(groupName, folders)
 			-- Link to the dependencies and modules
 			links(ProjLinks)
 
-		    buildoptions { "/bigobj" }
+		    buildoptions { "/bigobj", "/permissive" }
 
 			-- This filters for our windows builds
 			filter "system:windows"
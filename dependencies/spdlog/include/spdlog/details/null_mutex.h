@@ -28,17 +28,17 @@ struct null_atomic_int
         : value(new_value)
     {}
 
-    int load(std::memory_order = std::memory_order::memory_order_relaxed) const
+    int load(std::memory_order = std::memory_order_relaxed) const
     {
         return value;
     }
 
-    void store(int new_value, std::memory_order = std::memory_order::memory_order_relaxed)
+    void store(int new_value, std::memory_order = std::memory_order_relaxed)
     {
         value = new_value;
     }
 
-    int exchange(int new_value, std::memory_order = std::memory_order::memory_order_relaxed)
+    int exchange(int new_value, std::memory_order = std::memory_order_relaxed)
     {
         std::swap(new_value, value);
         return new_value; // return value before the call
@@ -0,0 +1,78 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+/// <summary>
+/// Keeps track of the assets of a given type by path, so that components can refer to assets by path when they are
+/// saved, and the same asset is shared instead of being loaded again. Paths don't have to be files, anything
+/// created in code can be added under a name (ex: materials)
+///
+/// If a loader is set, assets that haven't been added yet are loaded the first time they are asked for
+/// </summary>
+/// <typeparam name="T">The type of asset to store</typeparam>
+template <typename T>
+class AssetLibrary final {
+public:
+	typedef std::function<std::shared_ptr<T>(const std::string& path)> LoadFunction;
+
+	/// <summary>
+	/// Adds an asset to the library, replacing any existing asset with the same path
+	/// </summary>
+	static void Add(const std::string& path, const std::shared_ptr<T>& asset) {
+		auto it = _assets.find(path);
+		if (it != _assets.end()) {
+			_paths.erase(it->second.get());
+		}
+		_assets[path] = asset;
+		_paths[asset.get()] = path;
+	}
+
+	/// <summary>
+	/// Gets the asset with the given path, loading it with the loader if it hasn't been added yet
+	/// </summary>
+	/// <returns>The asset, or nullptr if it could not be found or loaded</returns>
+	static std::shared_ptr<T> Load(const std::string& path) {
+		auto it = _assets.find(path);
+		if (it != _assets.end()) {
+			return it->second;
+		}
+		if (_loader) {
+			std::shared_ptr<T> result = _loader(path);
+			if (result != nullptr) {
+				Add(path, result);
+			}
+			return result;
+		}
+		return nullptr;
+	}
+
+	/// <summary>
+	/// Gets the path that an asset was added with
+	/// </summary>
+	/// <returns>The path of the asset, or an empty string if the asset is not in the library</returns>
+	static const std::string& GetPath(const std::shared_ptr<T>& asset) {
+		static const std::string empty;
+		auto it = _paths.find(asset.get());
+		return it != _paths.end() ? it->second : empty;
+	}
+
+	/// <summary>
+	/// Sets the function used to load assets that haven't been added yet
+	/// </summary>
+	static void SetLoader(const LoadFunction& loader) { _loader = loader; }
+
+	/// <summary>
+	/// Removes all of the assets from the library, releasing the library's references to them
+	/// </summary>
+	static void Clear() {
+		_assets.clear();
+		_paths.clear();
+	}
+
+private:
+	inline static std::unordered_map<std::string, std::shared_ptr<T>> _assets;
+	inline static std::unordered_map<const T*, std::string> _paths;
+	inline static LoadFunction _loader;
+};
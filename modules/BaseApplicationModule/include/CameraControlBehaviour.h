@@ -9,6 +9,13 @@ public:
 	void OnLoad(entt::handle entity) override;
 	void Update(entt::handle entity) override;
 
+	template <typename Archive>
+	void serialize(Archive& archive) {
+		// Everything else is picked up from the transform in OnLoad
+		IBehaviour::serialize(archive);
+		archive(cereal::make_nvp("MoveSpeed", _moveSpeed));
+	}
+
 protected:
 	float _moveSpeed = 1.5f;
 	double _prevMouseX, _prevMouseY;
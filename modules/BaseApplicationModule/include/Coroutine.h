@@ -0,0 +1,221 @@
+#pragma once
+#include <entt.hpp>
+#include <coroutine>
+#include <exception>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cstdint>
+
+/// <summary>
+/// Describes what a coroutine is waiting on before it should be resumed. Coroutines co_await one of NextFrame,
+/// Seconds, FixedTicks or KeyPressed, which fill this in
+/// </summary>
+struct Await {
+	enum class Type : uint8_t {
+		Done,      // The coroutine has finished and will not be resumed
+		NextFrame, // Resume on the next frame
+		Seconds,   // Resume once a number of seconds have passed
+		FixedTick, // Resume after a number of fixed updates
+		KeyPress   // Resume on the first frame a key is pressed
+	};
+
+	Type     Kind     = Type::Done;
+	float    Duration = 0.0f;
+	uint32_t Ticks    = 0;
+	int      Key      = 0;
+
+	bool await_ready() const noexcept { return false; }
+	template <typename Promise>
+	void await_suspend(std::coroutine_handle<Promise> handle) const noexcept { handle.promise().Pending = *this; }
+	void await_resume() const noexcept {}
+};
+
+/// <summary>
+/// Suspends a coroutine until the next frame
+/// </summary>
+struct NextFrame : Await {
+	NextFrame() { Kind = Type::NextFrame; }
+};
+
+/// <summary>
+/// Suspends a coroutine until a number of seconds have passed
+/// </summary>
+struct Seconds : Await {
+	explicit Seconds(float seconds) { Kind = Type::Seconds; Duration = seconds; }
+};
+
+/// <summary>
+/// Suspends a coroutine for a number of fixed updates, resuming from inside the fixed update
+/// </summary>
+struct FixedTicks : Await {
+	explicit FixedTicks(uint32_t ticks = 1) { Kind = Type::FixedTick; Ticks = ticks; }
+};
+
+/// <summary>
+/// Suspends a coroutine until the first frame that a key is pressed
+/// </summary>
+struct KeyPressed : Await {
+	explicit KeyPressed(int glfwKey) { Kind = Type::KeyPress; Key = glfwKey; }
+};
+
+/// <summary>
+/// A coroutine that can be run by a CoroutineScheduler. Any function returning a Coroutine can co_await NextFrame,
+/// Seconds, FixedTicks and KeyPressed, for instance:
+///
+///		Coroutine Blink(entt::handle entity) {
+///			while (true) {
+///				co_await Seconds(0.5f);
+///				/* do something */
+///				co_await KeyPressed(GLFW_KEY_SPACE);
+///			}
+///		}
+///
+/// Nothing runs until the coroutine is passed to CoroutineScheduler::Start (or IBehaviour::StartCoroutine). Locals
+/// survive between waits, but pointers to components don't; components can move when others of their type are added
+/// or removed, so look them up again after each co_await
+/// </summary>
+class Coroutine final {
+public:
+	struct promise_type {
+		// What the coroutine is waiting on, filled in by the awaitables as it suspends
+		Await              Pending;
+		std::exception_ptr Exception;
+
+		Coroutine get_return_object() { return Coroutine(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		// Finished coroutines stay suspended, so the scheduler can see that they are done before destroying them
+		std::suspend_always final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { Exception = std::current_exception(); }
+	};
+	typedef std::coroutine_handle<promise_type> Handle;
+
+	Coroutine(const Coroutine& other) = delete;
+	Coroutine& operator =(const Coroutine& other) = delete;
+	Coroutine(Coroutine&& other) noexcept : _handle(std::exchange(other._handle, nullptr)) {}
+	Coroutine& operator =(Coroutine&& other) noexcept {
+		if (this != &other) {
+			if (_handle) {
+				_handle.destroy();
+			}
+			_handle = std::exchange(other._handle, nullptr);
+		}
+		return *this;
+	}
+	~Coroutine() {
+		if (_handle) {
+			_handle.destroy();
+		}
+	}
+
+private:
+	friend class CoroutineScheduler;
+
+	explicit Coroutine(Handle handle) : _handle(handle) {}
+
+	Handle _handle;
+};
+
+/// <summary>
+/// Identifies a running coroutine, stays safe to use after the coroutine has finished
+/// </summary>
+struct CoroutineHandle {
+	uint32_t Index = ~0u;
+	uint32_t Generation = 0;
+};
+
+/// <summary>
+/// Runs the coroutines for a registry. Suspended coroutines are only touched when they are due: timed waits sit in
+/// a timer wheel, fixed tick waits in a second wheel keyed on fixed updates, and key waits are grouped per key so
+/// that we only check keys that something is waiting on. Thousands of idle coroutines cost close to nothing per frame
+///
+/// Coroutines are owned by an entity, and are dropped the next time they would resume if the entity has been
+/// destroyed. There is one scheduler per registry, stored in the registry's context (see Get)
+/// </summary>
+class CoroutineScheduler final {
+public:
+	// The timer wheel has WheelSize slots, each covering 1/TimerResolution seconds
+	static constexpr uint32_t WheelSize = 256;
+	static constexpr double   TimerResolution = 120.0;
+
+	CoroutineScheduler(entt::registry& registry);
+	CoroutineScheduler(const CoroutineScheduler& other) = delete;
+	CoroutineScheduler& operator =(const CoroutineScheduler& other) = delete;
+	~CoroutineScheduler();
+
+	/// <summary>
+	/// Gets the coroutine scheduler for the given registry, creating it if it does not exist yet
+	/// </summary>
+	static CoroutineScheduler& Get(entt::registry& registry);
+
+	/// <summary>
+	/// Starts a new coroutine, running it immediately until it's first wait
+	/// </summary>
+	/// <param name="entity">The entity that owns the coroutine</param>
+	/// <param name="coroutine">The coroutine to run, the scheduler takes ownership of it</param>
+	/// <returns>A handle that can be used to stop the coroutine</returns>
+	CoroutineHandle Start(entt::handle entity, Coroutine coroutine);
+	/// <summary>
+	/// Stops a coroutine, does nothing if it has already finished
+	/// </summary>
+	void Stop(CoroutineHandle handle);
+	/// <summary>
+	/// Checks whether the coroutine is still running (ie. it has not finished and has not been stopped)
+	/// </summary>
+	bool IsRunning(CoroutineHandle handle) const;
+
+	/// <summary>
+	/// Resumes any coroutines waiting on the next frame, timers that have expired, and key presses. Should be
+	/// called once per frame
+	/// </summary>
+	void Update();
+	/// <summary>
+	/// Resumes any coroutines waiting on fixed ticks. Should be called once per fixed update
+	/// </summary>
+	void FixedTick();
+
+	/// <summary>
+	/// Gets the number of coroutines that are currently suspended
+	/// </summary>
+	size_t Size() const { return _routines.size() - _freeList.size(); }
+
+private:
+	struct Routine {
+		// Null while the routine is running
+		Coroutine::Handle Handle;
+		entt::entity      Entity = entt::null;
+		uint32_t          Generation = 0;
+		bool              IsAlive = false;
+		// The tick (timer or fixed, depending on the wait) that the routine is due
+		uint64_t          DueTick = 0;
+	};
+
+	// A reference to a routine in one of the wait lists. Stopped routines are removed lazily, when
+	// the generation no longer matches
+	struct Entry {
+		uint32_t Index;
+		uint32_t Generation;
+	};
+
+	entt::registry* _registry;
+	std::vector<Routine> _routines;
+	std::vector<uint32_t> _freeList;
+
+	std::vector<Entry> _nextFrame;
+	std::vector<Entry> _timerWheel[WheelSize];
+	std::vector<Entry> _fixedWheel[WheelSize];
+	uint64_t _timerTick;
+	uint64_t _fixedTick;
+	std::unordered_map<int, std::vector<Entry>> _keyWaiters;
+
+	// Scratch space, so resuming routines can safely re-schedule into the lists we are processing
+	std::vector<Entry> _resuming;
+
+	void _Resume(Entry entry);
+	void _Schedule(uint32_t index, const Await& await);
+	void _Free(uint32_t index);
+	void _AdvanceWheel(std::vector<Entry>* wheel, uint64_t& current, uint64_t target);
+	bool _IsCurrent(Entry entry) const;
+	uint64_t _CurrentTimerTick() const;
+};
@@ -0,0 +1,424 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// <summary>
+/// The points in the frame where deferred events are delivered (see EventBus::Dispatch)
+/// </summary>
+enum class EventPhase : uint8_t {
+	FrameStart = 0, // The top of the frame, after input has been polled and before anything is updated
+	PostUpdate = 1, // After the frame's systems have run, before the frame is handed to the renderer
+	FrameEnd   = 2, // After the frame has been submitted and removed entities have been destroyed
+	Count      = 3
+};
+
+/// <summary>
+/// Identifies a subscription to the EventBus, stays safe to use after it has been removed
+/// </summary>
+struct EventSubscription {
+	uint32_t Channel = ~0u;
+	uint32_t Index = ~0u;
+	uint32_t Generation = 0;
+};
+
+/// <summary>
+/// A typed publish/subscribe event system, so that parts of the engine can notify each other without knowing about
+/// each other. Any copyable, default constructible struct can be an event, and each event type gets it's own channel
+///
+/// Events can be delivered two ways:
+///		- Publish queues the event, and it is delivered when the subscriber's phase is next dispatched. Publish can be
+///		  called from any thread (ex: a loader or a job), and is lock free
+///		- Send delivers the event right away to every subscriber, regardless of phase, on the calling thread
+///
+/// Each channel has a fixed size multi-producer, single-consumer ring that published events are written into, so in
+/// steady state publishing does not allocate. If a ring fills up between dispatches, the extra events spill into an
+/// overflow list under a lock (and are counted in the stats), so nothing is ever dropped. Events from the same thread
+/// are always delivered in the order they were published. Events should be small plain structs, since anything they
+/// own (ex: strings) is copied along with them
+///
+/// Subscribing, unsubscribing, Send and Dispatch belong to the main thread. Subscriptions can be added and removed
+/// from inside a handler, new subscriptions start receiving events from the next delivery
+/// </summary>
+class EventBus final {
+public:
+	// The number of events each channel can queue between dispatches before spilling over
+	static constexpr uint32_t QueueCapacity = 1024;
+	// The most event types that can be used
+	static constexpr uint32_t MaxChannels = 256;
+
+	/// <summary>
+	/// Totals across every channel, for tuning and display
+	/// </summary>
+	struct Stats {
+		uint64_t Published = 0;  // The number of events that have been published or sent
+		uint64_t Delivered = 0;  // The number of times a handler has been invoked
+		uint64_t Overflowed = 0; // The number of published events that didn't fit in their channel's ring
+		uint32_t Channels = 0;   // The number of event types that have been used
+	};
+
+	/// <summary>
+	/// Subscribes to an event type
+	/// </summary>
+	/// <typeparam name="T">The type of event to receive</typeparam>
+	/// <param name="handler">A callable taking the event (const T&)</param>
+	/// <param name="phase">When published events should be delivered to the handler</param>
+	/// <returns>A handle that can be used to unsubscribe</returns>
+	template <typename T, typename Func>
+	static EventSubscription Subscribe(Func&& handler, EventPhase phase = EventPhase::FrameStart) {
+		Channel<T>& channel = _GetChannel<T>();
+		return channel.Subscribe(std::function<void(const T&)>(std::forward<Func>(handler)), phase);
+	}
+	/// <summary>
+	/// Removes a subscription, does nothing if it has already been removed
+	/// </summary>
+	static void Unsubscribe(EventSubscription subscription);
+	/// <summary>
+	/// Checks whether a subscription is still active
+	/// </summary>
+	static bool IsSubscribed(EventSubscription subscription);
+
+	/// <summary>
+	/// Queues an event to be delivered when each subscriber's phase is next dispatched. Can be called from any thread
+	/// </summary>
+	template <typename T>
+	static void Publish(const T& event) {
+		_GetChannel<T>().Publish(event);
+	}
+	/// <summary>
+	/// Delivers an event to every subscriber straight away, on the calling thread
+	/// </summary>
+	template <typename T>
+	static void Send(const T& event) {
+		_GetChannel<T>().Send(event);
+	}
+
+	/// <summary>
+	/// Delivers the events that have been published since the phase was last dispatched to the subscribers for that
+	/// phase. Events published by the handlers are delivered on the next dispatch. Must not be called from a handler
+	/// </summary>
+	static void Dispatch(EventPhase phase);
+
+	/// <summary>
+	/// Removes every subscription and drops any events that are waiting, call before anything the handlers
+	/// reference goes away
+	/// </summary>
+	static void Clear();
+
+	/// <summary>
+	/// Gets the totals across every channel, can be called from any thread
+	/// </summary>
+	static Stats GetStats();
+
+private:
+	EventBus() = delete;
+
+	class IChannel {
+	public:
+		// The channel's index in the channel list, set when it is registered
+		uint32_t Id = 0;
+
+		virtual ~IChannel() = default;
+		virtual void Dispatch(EventPhase phase) = 0;
+		virtual void Unsubscribe(uint32_t index, uint32_t generation) = 0;
+		virtual bool IsSubscribed(uint32_t index, uint32_t generation) const = 0;
+		virtual void Clear() = 0;
+		virtual void AddStats(Stats& stats) const = 0;
+	};
+
+	template <typename T>
+	class Channel final : public IChannel {
+		static_assert(std::is_default_constructible<T>::value && std::is_copy_assignable<T>::value,
+			"Events must be default constructible and copyable");
+	public:
+		Channel() :
+			IChannel(),
+			_cells(std::make_unique<Cell[]>(QueueCapacity)),
+			_enqueuePos(0),
+			_dequeuePos(0),
+			_hasOverflow(false),
+			_overflow(std::vector<T>()),
+			_events(std::vector<T>()),
+			_eventBase(0),
+			_subscribers(std::deque<Subscriber>()),
+			_freeList(std::vector<uint32_t>()),
+			_deferredFree(std::vector<uint32_t>()),
+			_depth(0),
+			_serial(0),
+			_nextSerial(0),
+			_published(0),
+			_overflowed(0),
+			_delivered(0)
+		{
+			static_assert((QueueCapacity & (QueueCapacity - 1)) == 0, "QueueCapacity must be a power of 2");
+			for (uint32_t ix = 0; ix < QueueCapacity; ix++) {
+				_cells[ix].Sequence.store(ix, std::memory_order_relaxed);
+			}
+			for (size_t ix = 0; ix < (size_t)EventPhase::Count; ix++) {
+				_cursors[ix] = 0;
+				_phaseSubscribers[ix] = 0;
+			}
+		}
+
+		EventSubscription Subscribe(std::function<void(const T&)>&& handler, EventPhase phase) {
+			uint32_t index;
+			if (!_freeList.empty()) {
+				index = _freeList.back();
+				_freeList.pop_back();
+			} else {
+				index = static_cast<uint32_t>(_subscribers.size());
+				_subscribers.emplace_back();
+			}
+			Subscriber& subscriber = _subscribers[index];
+			subscriber.Handler = std::move(handler);
+			subscriber.Phase = phase;
+			subscriber.IsAlive = true;
+			// Subscribers added by a handler sit out the rest of the delivery they were added in
+			subscriber.AddedIn = _depth > 0 ? _serial : 0;
+			// Events that are still waiting on other subscribers of the phase are skipped, only the ones pulled out
+			// of the ring from now on are delivered
+			subscriber.FirstEvent = _eventBase + _events.size();
+			if (_phaseSubscribers[(size_t)phase]++ == 0) {
+				_cursors[(size_t)phase] = _events.size();
+			}
+			return EventSubscription{ Id, index, subscriber.Generation };
+		}
+
+		void Unsubscribe(uint32_t index, uint32_t generation) override {
+			if (!IsSubscribed(index, generation)) {
+				return;
+			}
+			Subscriber& subscriber = _subscribers[index];
+			subscriber.IsAlive = false;
+			_phaseSubscribers[(size_t)subscriber.Phase]--;
+			// The handler may be the one that's running, so it is only released once the delivery is over
+			if (_depth > 0) {
+				_deferredFree.push_back(index);
+			} else {
+				_Free(index);
+			}
+		}
+
+		bool IsSubscribed(uint32_t index, uint32_t generation) const override {
+			return index < _subscribers.size() && _subscribers[index].IsAlive && _subscribers[index].Generation == generation;
+		}
+
+		void Publish(const T& event) {
+			_published.fetch_add(1, std::memory_order_relaxed);
+			// Once we've spilled over, everything goes to the overflow until it's drained, so events from the same
+			// thread stay in order
+			if (_hasOverflow.load(std::memory_order_acquire) || !_TryPush(event)) {
+				std::lock_guard<std::mutex> lock(_overflowMutex);
+				_overflow.push_back(event);
+				_hasOverflow.store(true, std::memory_order_release);
+				_overflowed.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		void Send(const T& event) {
+			_published.fetch_add(1, std::memory_order_relaxed);
+			_Deliver(&event, 1, _eventBase + _events.size(), EventPhase::Count);
+		}
+
+		void Dispatch(EventPhase phase) override {
+			// Pull in everything that has been published since the last dispatch
+			T event;
+			while (_TryPop(event)) {
+				_events.push_back(std::move(event));
+			}
+			// The overflow is only newer than the ring once every slot that was claimed has been read, otherwise a
+			// producer may still be writing an older event
+			if (_hasOverflow.load(std::memory_order_acquire) && _dequeuePos == _enqueuePos.load(std::memory_order_acquire)) {
+				std::lock_guard<std::mutex> lock(_overflowMutex);
+				for (T& overflowed : _overflow) {
+					_events.push_back(std::move(overflowed));
+				}
+				_overflow.clear();
+				_hasOverflow.store(false, std::memory_order_relaxed);
+			}
+
+			// Each phase picks up where it left off, so every subscriber sees each event once. Anything the handlers
+			// publish goes through the ring, so it can't end up in this delivery
+			const size_t p = (size_t)phase;
+			const size_t end = _events.size();
+			if (_phaseSubscribers[p] > 0 && _cursors[p] < end) {
+				_Deliver(_events.data() + _cursors[p], end - _cursors[p], _eventBase + _cursors[p], phase);
+			}
+			_cursors[p] = end;
+			_Compact();
+		}
+
+		void Clear() override {
+			for (uint32_t ix = 0; ix < _subscribers.size(); ix++) {
+				Unsubscribe(ix, _subscribers[ix].Generation);
+			}
+			T event;
+			while (_TryPop(event)) {}
+			{
+				std::lock_guard<std::mutex> lock(_overflowMutex);
+				_overflow.clear();
+				_hasOverflow.store(false, std::memory_order_relaxed);
+			}
+			_eventBase += _events.size();
+			_events.clear();
+			for (size_t ix = 0; ix < (size_t)EventPhase::Count; ix++) {
+				_cursors[ix] = 0;
+			}
+		}
+
+		void AddStats(Stats& stats) const override {
+			stats.Published += _published.load(std::memory_order_relaxed);
+			stats.Overflowed += _overflowed.load(std::memory_order_relaxed);
+			stats.Delivered += _delivered.load(std::memory_order_relaxed);
+		}
+
+	private:
+		struct Cell {
+			std::atomic<uint32_t> Sequence{ 0 };
+			T Value;
+		};
+
+		struct Subscriber {
+			std::function<void(const T&)> Handler;
+			EventPhase Phase = EventPhase::FrameStart;
+			uint32_t Generation = 0;
+			bool IsAlive = false;
+			uint64_t AddedIn = 0;
+			// The index of the first event (counted from the start) the subscriber is given
+			uint64_t FirstEvent = 0;
+		};
+
+		// A bounded MPMC queue (Vyukov), only ever popped from the main thread. Each cell's sequence says whether
+		// it is ready to be written (== position) or read (== position + 1) for the lap we are on
+		bool _TryPush(const T& event) {
+			uint32_t pos = _enqueuePos.load(std::memory_order_relaxed);
+			while (true) {
+				Cell& cell = _cells[pos & (QueueCapacity - 1)];
+				const int32_t diff = static_cast<int32_t>(cell.Sequence.load(std::memory_order_acquire) - pos);
+				if (diff == 0) {
+					if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+						cell.Value = event;
+						cell.Sequence.store(pos + 1, std::memory_order_release);
+						return true;
+					}
+				} else if (diff < 0) {
+					// The consumer hasn't got to this cell on the last lap yet, so we're full
+					return false;
+				} else {
+					pos = _enqueuePos.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		bool _TryPop(T& result) {
+			Cell& cell = _cells[_dequeuePos & (QueueCapacity - 1)];
+			if (static_cast<int32_t>(cell.Sequence.load(std::memory_order_acquire) - (_dequeuePos + 1)) < 0) {
+				return false;
+			}
+			result = std::move(cell.Value);
+			cell.Sequence.store(_dequeuePos + QueueCapacity, std::memory_order_release);
+			_dequeuePos++;
+			return true;
+		}
+
+		// Invokes the handlers for the given phase (or all of them for Count) for a run of events, first is the
+		// index of the first event in the run
+		void _Deliver(const T* events, size_t count, uint64_t first, EventPhase phase) {
+			const uint64_t outerSerial = _serial;
+			_serial = ++_nextSerial;
+			_depth++;
+			uint64_t delivered = 0;
+			for (size_t ex = 0; ex < count; ex++) {
+				// Subscribers can be added while we go, a deque keeps the running handler where it is
+				for (size_t ix = 0; ix < _subscribers.size(); ix++) {
+					Subscriber& subscriber = _subscribers[ix];
+					if (!subscriber.IsAlive || subscriber.AddedIn == _serial || first + ex < subscriber.FirstEvent ||
+						(phase != EventPhase::Count && subscriber.Phase != phase)) {
+						continue;
+					}
+					subscriber.Handler(events[ex]);
+					delivered++;
+				}
+			}
+			_delivered.fetch_add(delivered, std::memory_order_relaxed);
+			_serial = outerSerial;
+			if (--_depth == 0) {
+				for (uint32_t index : _deferredFree) {
+					_Free(index);
+				}
+				_deferredFree.clear();
+			}
+		}
+
+		// Drops the events that every phase with subscribers has already seen
+		void _Compact() {
+			size_t done = _events.size();
+			for (size_t ix = 0; ix < (size_t)EventPhase::Count; ix++) {
+				if (_phaseSubscribers[ix] > 0 && _cursors[ix] < done) {
+					done = _cursors[ix];
+				}
+			}
+			if (done == 0) {
+				return;
+			}
+			_events.erase(_events.begin(), _events.begin() + done);
+			_eventBase += done;
+			for (size_t ix = 0; ix < (size_t)EventPhase::Count; ix++) {
+				_cursors[ix] = _cursors[ix] > done ? _cursors[ix] - done : 0;
+			}
+		}
+
+		void _Free(uint32_t index) {
+			Subscriber& subscriber = _subscribers[index];
+			subscriber.Handler = nullptr;
+			subscriber.Generation++;
+			_freeList.push_back(index);
+		}
+
+		// The ring that published events go into, _dequeuePos is only touched by the main thread
+		std::unique_ptr<Cell[]> _cells;
+		std::atomic<uint32_t> _enqueuePos;
+		uint32_t _dequeuePos;
+
+		// Events that didn't fit in the ring
+		std::mutex _overflowMutex;
+		std::atomic<bool> _hasOverflow;
+		std::vector<T> _overflow;
+
+		// Events that have been pulled out of the ring, but not every phase has seen yet
+		std::vector<T> _events;
+		// How many events have been dropped from the front of _events
+		uint64_t _eventBase;
+		size_t _cursors[(size_t)EventPhase::Count];
+		uint32_t _phaseSubscribers[(size_t)EventPhase::Count];
+
+		std::deque<Subscriber> _subscribers;
+		std::vector<uint32_t> _freeList;
+		std::vector<uint32_t> _deferredFree;
+		// How many deliveries are running (handlers can Send), and which one is innermost
+		uint32_t _depth;
+		uint64_t _serial;
+		uint64_t _nextSerial;
+
+		std::atomic<uint64_t> _published;
+		std::atomic<uint64_t> _overflowed;
+		std::atomic<uint64_t> _delivered;
+	};
+
+	template <typename T>
+	static Channel<T>& _GetChannel() {
+		// Function local statics are thread safe to initialize, so the first Publish can come from any thread
+		static Channel<T>* channel = static_cast<Channel<T>*>(_Register(std::make_unique<Channel<T>>()));
+		return *channel;
+	}
+
+	struct State;
+	static State& _GetState();
+	static IChannel* _Register(std::unique_ptr<IChannel>&& channel);
+};
@@ -3,20 +3,36 @@
 #include <vector>
 #include <GLM/glm.hpp>
 
+/*
+ * Moves an entity around a loop of points. The movement runs as a coroutine that steps once every Rate.Interval
+ * fixed updates, so the behaviour itself is never polled
+ */
 class FollowPathBehaviour final : public IBehaviour
 {
 public:
 	FollowPathBehaviour() :
 		Points(std::vector<glm::vec3>()),
 		Speed(1.0f),
-		_nextPointIx(0) { }
+		_nextPointIx(0),
+		_routineId(0) { }
 	~FollowPathBehaviour() override = default;
 
 	std::vector<glm::vec3> Points;
 	float                  Speed;
 
-	void Update(entt::handle entity) override;
+	void OnLoad(entt::handle entity) override;
+
+	template <typename Archive>
+	void serialize(Archive& archive) {
+		IBehaviour::serialize(archive);
+		archive(CEREAL_NVP(Points), CEREAL_NVP(Speed), cereal::make_nvp("NextPoint", _nextPointIx));
+	}
 	
 private:
 	int _nextPointIx;
+	// Identifies the coroutine that is moving us, a coroutine started for a behaviour that has since been replaced
+	// or removed sees a different id (or no behaviour) and finishes
+	uint32_t _routineId;
+
+	static Coroutine _FollowPath(entt::handle entity, uint32_t routineId);
 };
\ No newline at end of file
@@ -1,39 +1,38 @@
 #pragma once
 #include <string>
 #include <entt.hpp>
+#include "NameTable.h"
+
+class GameScene;
 
 /// <summary>
 /// Represents information associated with a game object within our scene
 /// </summary>
 struct GameObjectTag
 {
-	std::string Name;
-	uint32_t    HashedName;
-	GameObjectTag() : Name(""), HashedName(""_hs) {}
-	GameObjectTag(const GameObjectTag& other) {
-		Name = other.Name;
-		HashedName = other.HashedName;
-	}
-	GameObjectTag(GameObjectTag&& other) noexcept {
-		Name = other.Name;
-		HashedName = other.HashedName;
-	}
-	GameObjectTag& operator=(GameObjectTag&& other) noexcept{
-		Name = other.Name;
-		HashedName = other.HashedName;
-		return *this;
-	}
-	GameObjectTag& operator=(const GameObjectTag& other) noexcept {
-		Name = other.Name;
-		HashedName = other.HashedName;
-		return *this;
-	}
+	GameObjectTag() : _name(NameTable::Empty) {}
+	GameObjectTag(const std::string& name) : _name(NameTable::Intern(name)) {}
+	GameObjectTag(NameId name) : _name(name) {}
+	GameObjectTag(const GameObjectTag& other) = default;
+	GameObjectTag(GameObjectTag&& other) noexcept = default;
+	GameObjectTag& operator=(const GameObjectTag& other) = default;
+	GameObjectTag& operator=(GameObjectTag&& other) noexcept = default;
 	~GameObjectTag() = default;
-	
-	GameObjectTag(const std::string& name) {
-		Name = name;
-		HashedName = entt::hashed_string::value(name.c_str());
-	}
+
+	/// <summary>
+	/// Gets the interned name of the game object, for comparing names without touching the strings
+	/// </summary>
+	NameId GetNameId() const { return _name; }
+	/// <summary>
+	/// Gets the name of the game object
+	/// </summary>
+	const std::string& GetName() const { return NameTable::GetString(_name); }
 
 	// TODO: we could expand this in the future for properties that all game objects should have
-};
\ No newline at end of file
+
+private:
+	// The scene indexes entities by name, so renaming has to go through GameScene::SetName, or replace/patch on the
+	// registry. Assigning to a tag directly skips the update signal, and the scene won't find it by it's new name
+	friend class GameScene;
+	NameId _name;
+};
@@ -1,9 +1,43 @@
 #pragma once
 #include <memory>
+#include <vector>
+#include <algorithm>
 #include <entt.hpp>
-#include <typeindex>
+#include <cereal/cereal.hpp>
+#include "Scene.h"
+#include "Coroutine.h"
+#include "Timing.h"
+#include "Transform.h"
 struct BehaviourBinding;
 
+/*
+ * Controls how often a behaviour's Update and FixedUpdate are invoked. Behaviours that don't need to run every frame
+ * (ex: distant props) can run every Nth frame, or drop to a lower rate once they are far from the LOD origin (see
+ * BehaviourBinding::SetLodOrigin). Intervals are counted in frames for Update, and in fixed ticks for FixedUpdate
+ */
+struct UpdateRate {
+	// Invoke every Interval frames, 1 to run every frame
+	uint32_t Interval    = 1;
+	// Beyond this distance from the LOD origin, FarInterval is used instead. Set to 0 to ignore distance
+	float    FarDistance = 0.0f;
+	uint32_t FarInterval = 1;
+
+	static UpdateRate EveryFrame() { return UpdateRate(); }
+	static UpdateRate EveryNthFrame(uint32_t interval) { UpdateRate result; result.Interval = interval; return result; }
+	static UpdateRate ByDistance(float farDistance, uint32_t farInterval, uint32_t nearInterval = 1) {
+		UpdateRate result;
+		result.Interval = nearInterval;
+		result.FarDistance = farDistance;
+		result.FarInterval = farInterval;
+		return result;
+	}
+
+	template <typename Archive>
+	void serialize(Archive& archive) {
+		archive(CEREAL_NVP(Interval), CEREAL_NVP(FarDistance), CEREAL_NVP(FarInterval));
+	}
+};
+
 /*
  * Represents a behaviour that can be tied to a single GameObject
  */
@@ -13,6 +47,10 @@ public:
 	 * Whether or not this component will fire it's events
 	 */
 	bool    Enabled = true;
+	/*
+	 * How often Update and FixedUpdate are invoked, defaults to every frame
+	 */
+	UpdateRate Rate;
 	virtual ~IBehaviour() = default;
 
 	/*
@@ -27,19 +65,21 @@ public:
 	virtual void OnUnload(entt::handle entity) {}
 	/*
 	 * Invoked during the variable rate update. This is generally where we want to add our updates.
-	 * To get the time since the last update, use florp::app::Timing::DeltaTime
+	 * To get the time since the last update, use GetDeltaTime
 	 * @param entity The entity that the behaviour is bound to
 	 */
 	virtual void Update(entt::handle entity) {}
 	/*
-	 * Invoked during the fixed rate update phase.
-	 * To get the approximate time since the last fixed update, use florp::app::Timing::FixedTimeStep
+	 * Invoked during the fixed rate update phase, which may run zero or more times per frame. Movement and
+	 * gameplay simulation should go here so that it behaves the same regardless of frame rate.
+	 * To get the time since the last fixed update, use GetFixedDeltaTime
 	 * @param entity The entity that the behaviour is bound to
 	 */
 	virtual void FixedUpdate(entt::handle entity) {}
 	/*
-	 * Invoked during the variable rate update. This is called after all behaviours/layers have called Update
-	 * To get the time since the last update, use florp::app::Timing::DeltaTime
+	 * Invoked during the variable rate update. This is called after all behaviours have called Update, and after
+	 * the world transforms have been updated.
+	 * To get the time since the last update, use Timing::DeltaTime
 	 * @param entity The entity that the behaviour is bound to
 	 */
 	virtual void LateUpdate(entt::handle entity) {}
@@ -49,105 +89,320 @@ public:
 	 */
 	virtual void RenderGUI(entt::handle entity) {}
 
+	/*
+	 * Saves or loads the state that every behaviour has, for use with cereal (see SceneSerializer). Behaviours with
+	 * state of their own should provide their own serialize, and call this one from it
+	 * @param archive The archive to save to or load from
+	 */
+	template <typename Archive>
+	void serialize(Archive& archive) {
+		archive(CEREAL_NVP(Enabled), CEREAL_NVP(Rate));
+	}
+
 protected:
 	IBehaviour() = default;
+
+	/*
+	 * Gets the time since this behaviour's last Update. This is Timing::DeltaTime unless the behaviour's Rate has
+	 * skipped some frames, in which case the time from the skipped frames is included
+	 */
+	float GetDeltaTime() const { return _deltaTime[0]; }
+	/*
+	 * Gets the time since this behaviour's last FixedUpdate. This is Timing::FixedTimeStep unless the behaviour's
+	 * Rate has skipped some ticks, in which case the time from the skipped ticks is included
+	 */
+	float GetFixedDeltaTime() const { return _deltaTime[1]; }
+
+	/*
+	 * Starts a coroutine owned by the given entity, running it until it's first co_await. Coroutines that are waiting
+	 * cost nothing until they are due, so prefer them over polling in Update for behaviours that are mostly idle.
+	 * Behaviours can move around in memory, so the coroutine shouldn't be a member function that uses this after
+	 * it's first co_await, look the behaviour up from the entity instead
+	 * @param entity The entity that the behaviour is bound to
+	 * @param coroutine The coroutine to run, see Coroutine
+	 * @returns A handle that can be passed to StopCoroutine
+	 */
+	CoroutineHandle StartCoroutine(entt::handle entity, Coroutine coroutine) {
+		return CoroutineScheduler::Get(entity.registry()).Start(entity, std::move(coroutine));
+	}
+	/*
+	 * Stops a coroutine started with StartCoroutine, does nothing if it has already finished
+	 * @param entity The entity that the behaviour is bound to
+	 * @param handle The coroutine to stop
+	 */
+	void StopCoroutine(entt::handle entity, CoroutineHandle handle) {
+		CoroutineScheduler::Get(entity.registry()).Stop(handle);
+	}
+
+private:
+	friend struct BehaviourBinding;
+
+	// Offsets this behaviour's throttled updates from other behaviours with the same interval, so they don't all land on the same frame
+	uint32_t _ratePhase = 0;
+	// Time from skipped updates, and the time passed to the last update, for Update and FixedUpdate respectively
+	float    _pendingTime[2] = { 0.0f, 0.0f };
+	float    _deltaTime[2] = { 0.0f, 0.0f };
 };
 
 /*
- * The component added to an entt entity to connect a behaviour to a specific entity
+ * Binds behaviours to entities, and dispatches their events
+ *
+ * Each behaviour type is stored as it's own component type in the entity's registry, so all the behaviours of one type
+ * live together in a contiguous pool, and Has/Get are a constant time lookup. Events are dispatched one type at a time,
+ * calling the concrete type's method directly, so we pay for one indirect call per type instead of a virtual call per
+ * instance. Types that don't override an event are skipped entirely.
+ *
+ * Update and FixedUpdate respect each behaviour's Rate. Each behaviour is given a phase when it is bound, so throttled
+ * behaviours are spread evenly across frames instead of all updating on the same frame
+ *
+ * Only one behaviour of each type may be bound to an entity
  */
 struct BehaviourBinding {
-	std::vector<std::shared_ptr<IBehaviour>> Behaviours;
-
 	/*
-	 * Binds an IBehaviour interface to the given entt entity
+	 * Binds an IBehaviour interface to the given entt entity, replacing any existing behaviour of the same type
 	 * @param T The type of behaviour to add
 	 * @param TArgs The argument types to forward to the behaviour's constructor
-	 * @param registry The registry that the entity is part of
 	 * @param entity The entity to add the behaviour to
 	 * @param args The arguments to forward to the behaviour's constructor
+	 * @returns A pointer to the new behaviour. DO NOT STORE POINTER! It is invalidated when other behaviours of the same type are added or removed
 	 */
 	template <typename T, typename ... TArgs, typename = typename std::enable_if<std::is_base_of<IBehaviour, T>::value>::type>
-	static std::shared_ptr<T> Bind(entt::handle entity, TArgs&&... args) {
-		// Get the binding component
-		BehaviourBinding& binding = entity.get_or_emplace<BehaviourBinding>();
-		// Make a new behaviour, forwarding the arguments
-		const std::shared_ptr<IBehaviour> behaviour = std::make_shared<T>(std::forward<TArgs>(args)...);
-		// Append it to the binding component's storage, and invoke the OnLoad
-		binding.Behaviours.push_back(behaviour);
-		behaviour->OnLoad(entity);
-		return std::dynamic_pointer_cast<T>(behaviour);
+	static T* Bind(entt::handle entity, TArgs&&... args) {
+		PoolTable& table = _RegisterPool<T>(entity.registry());
+		// Replacing a behaviour should still fire it's unload event
+		entity.remove_if_exists<T>();
+		// Make a new behaviour in the pool for this type, forwarding the arguments, and invoke the OnLoad
+		T& behaviour = entity.emplace<T>(std::forward<TArgs>(args)...);
+		behaviour._ratePhase = table.NextPhase++;
+		behaviour.OnLoad(entity);
+		// OnLoad may have added more behaviours of this type, so we need to look it up again
+		return &entity.get<T>();
 	}
 
 	/*
 	 * Binds an IBehaviour interface to the given entt entity, setting it to disabled by default
 	 * @param T The type of behaviour to add
 	 * @param TArgs The argument types to forward to the behaviour's constructor
-	 * @param registry The registry that the entity is part of
 	 * @param entity The entity to add the behaviour to
 	 * @param args The arguments to forward to the behaviour's constructor
+	 * @returns A pointer to the new behaviour. DO NOT STORE POINTER! It is invalidated when other behaviours of the same type are added or removed
 	 */
 	template <typename T, typename ... TArgs, typename = typename std::enable_if<std::is_base_of<IBehaviour, T>::value>::type>
-	static std::shared_ptr<T> BindDisabled(entt::handle entity, TArgs&&... args) {
-		// Get the binding component
-		BehaviourBinding& binding = entity.get_or_emplace<BehaviourBinding>();
-		// Make a new behaviour, forwarding the arguments
-		const std::shared_ptr<IBehaviour> behaviour = std::make_shared<T>(std::forward<TArgs>(args)...);
-		behaviour->Enabled = false;
-		// Append it to the binding component's storage, and invoke the OnLoad
-		binding.Behaviours.push_back(behaviour);
-		behaviour->OnLoad(entity);
-		return std::dynamic_pointer_cast<T>(behaviour);
+	static T* BindDisabled(entt::handle entity, TArgs&&... args) {
+		PoolTable& table = _RegisterPool<T>(entity.registry());
+		entity.remove_if_exists<T>();
+		T& behaviour = entity.emplace<T>(std::forward<TArgs>(args)...);
+		behaviour._ratePhase = table.NextPhase++;
+		behaviour.Enabled = false;
+		behaviour.OnLoad(entity);
+		return &entity.get<T>();
+	}
+
+	/*
+	 * Binds a behaviour that was added to the entity's registry directly (ex: by SceneSerializer), rather than
+	 * through Bind, and invokes it's OnLoad
+	 * @param T The type of behaviour to bind
+	 * @param entity The entity that the behaviour was added to
+	 */
+	template <typename T, typename = typename std::enable_if<std::is_base_of<IBehaviour, T>::value>::type>
+	static void Adopt(entt::handle entity) {
+		PoolTable& table = _RegisterPool<T>(entity.registry());
+		T& behaviour = entity.get<T>();
+		behaviour._ratePhase = table.NextPhase++;
+		behaviour.OnLoad(entity);
+	}
+
+	/*
+	 * Removes the behaviour with the given type from the entity, invoking it's OnUnload
+	 * @param T The type of behaviour to remove
+	 * @param entity The entity to remove the behaviour from
+	 */
+	template <typename T, typename = typename std::enable_if<std::is_base_of<IBehaviour, T>::value>::type>
+	static void Unbind(entt::handle entity) {
+		entity.remove_if_exists<T>();
 	}
 
-	
 	/*
 	 * Checks whether the given entity has a behaviour of the given type
 	 * @param T The type of behaviour to check for
-	 * @param registry The registry that the entity is part of
 	 * @param entity The entity to check
 	 * @returns True if a behaviour of type T is attached to entity, or false if otherwise
 	 */
 	template <typename T, typename = typename std::enable_if<std::is_base_of<IBehaviour, T>::value>::type>
 	static bool Has(entt::handle entity) {
-		// Check to see if the entity has a behaviour binding attached
-		if (entity.has<BehaviourBinding>()) {
-			// Get the binding component
-			const auto& binding = entity.get<BehaviourBinding>();
-			// Iterate over all the pointers in the binding list
-			for (const auto& ptr : binding.Behaviours) {
-				// If the pointer type matches T, we return true
-				if (std::type_index(typeid(*ptr.get())) == std::type_index(typeid(T))) {
-					return true;
-				}
-			}
-			return false;
-		}
-		else return false;
+		return entity.has<T>();
 	}
 
 	/*
 	 * Gets the behaviour with the given type from the entity, or nullptr if none exists
 	 * @param T The type of behaviour to check for
-	 * @param registry The registry that the entity is part of
 	 * @param entity The entity to search
 	 * @returns The behaviour of type T that is attached to entity, or nullptr if no behaviour of that type is attached
 	 */
 	template <typename T, typename = typename std::enable_if<std::is_base_of<IBehaviour, T>::value>::type>
-	static std::shared_ptr<T> Get(entt::handle entity) {
-		// Check to see if the entity has a behaviour binding attached
-		if (entity.has<BehaviourBinding>()) {
-			// Get the binding component
-			const auto& binding = entity.get<BehaviourBinding>();
-			// Iterate over all the pointers in the binding list
-			for (const auto& ptr : binding.Behaviours) {
-				// If the pointer type matches T, we return that behaviour, making sure to cast it back to the requested type
-				if (std::type_index(typeid(*ptr.get())) == std::type_index(typeid(T))) {
-					return std::dynamic_pointer_cast<T>(ptr);
+	static T* Get(entt::handle entity) {
+		return entity.try_get<T>();
+	}
+
+	/*
+	 * Gets the compile-time identifier for a behaviour type
+	 */
+	template <typename T>
+	static constexpr entt::id_type TypeId() {
+		return entt::type_info<T>::id();
+	}
+
+	/*
+	 * Invokes Update on all enabled behaviours in the registry, one behaviour type at a time
+	 */
+	static void Update(entt::registry& registry) { _Dispatch(registry, Phase_Update); }
+	/*
+	 * Invokes FixedUpdate on all enabled behaviours in the registry, one behaviour type at a time
+	 */
+	static void FixedUpdate(entt::registry& registry) { _Dispatch(registry, Phase_FixedUpdate); }
+	/*
+	 * Invokes LateUpdate on all enabled behaviours in the registry, one behaviour type at a time
+	 */
+	static void LateUpdate(entt::registry& registry) { _Dispatch(registry, Phase_LateUpdate); }
+	/*
+	 * Invokes RenderGUI on all enabled behaviours in the registry, one behaviour type at a time
+	 */
+	static void RenderGUI(entt::registry& registry) { _Dispatch(registry, Phase_RenderGUI); }
+
+	/*
+	 * Sets the point that behaviour distances are measured from for UpdateRate::FarDistance, usually the camera
+	 * @param registry The registry to set the origin for
+	 * @param origin The position in world space
+	 */
+	static void SetLodOrigin(entt::registry& registry, const glm::vec3& origin) {
+		registry.ctx_or_set<PoolTable>().LodOrigin = origin;
+	}
+
+	/*
+	 * The number of Update and FixedUpdate calls that were made, and that were skipped by the behaviours' Rate
+	 */
+	struct RateStats {
+		uint64_t Invoked = 0;
+		uint64_t Skipped = 0;
+	};
+
+	/*
+	 * Gets the total number of updates invoked and skipped in the registry since the first behaviour was bound
+	 */
+	static RateStats GetRateStats(entt::registry& registry) {
+		const PoolTable* table = registry.try_ctx<PoolTable>();
+		return table != nullptr ? table->Stats : RateStats();
+	}
+
+private:
+	enum Phase {
+		Phase_Update,
+		Phase_FixedUpdate,
+		Phase_LateUpdate,
+		Phase_RenderGUI,
+		Phase_Count
+	};
+
+	typedef void(*PoolDispatch)(entt::registry&);
+
+	/*
+	 * Stored in each registry's context, holds the dispatch functions for every behaviour type that has been bound
+	 */
+	struct PoolTable {
+		std::vector<entt::id_type> Types;
+		// Dispatch functions for each phase, types that don't override a phase are left out
+		std::vector<PoolDispatch>  Phases[Phase_Count];
+		// The number of times each phase has been dispatched, used to decide which throttled behaviours are due
+		uint64_t                   Frames[Phase_Count] = { 0 };
+		uint32_t                   NextPhase = 0;
+		glm::vec3                  LodOrigin = glm::vec3(0.0f);
+		RateStats                  Stats;
+	};
+
+	static void _Dispatch(entt::registry& registry, Phase phase) {
+		PoolTable* table = registry.try_ctx<PoolTable>();
+		if (table != nullptr) {
+			table->Frames[phase]++;
+			for (PoolDispatch dispatch : table->Phases[phase]) {
+				dispatch(registry);
+			}
+		}
+	}
+
+	template <typename T>
+	static PoolTable& _RegisterPool(entt::registry& registry) {
+		PoolTable& table = registry.ctx_or_set<PoolTable>();
+		if (std::find(table.Types.begin(), table.Types.end(), TypeId<T>()) != table.Types.end()) {
+			return table;
+		}
+		table.Types.push_back(TypeId<T>());
+
+		// If T doesn't override a method, taking it's address gives us a pointer to a member of IBehaviour
+		typedef void(IBehaviour::* BaseEvent)(entt::handle);
+		if constexpr (!std::is_same_v<decltype(&T::Update), BaseEvent>)      table.Phases[Phase_Update].push_back(&_DispatchPool<T, Phase_Update>);
+		if constexpr (!std::is_same_v<decltype(&T::FixedUpdate), BaseEvent>) table.Phases[Phase_FixedUpdate].push_back(&_DispatchPool<T, Phase_FixedUpdate>);
+		if constexpr (!std::is_same_v<decltype(&T::LateUpdate), BaseEvent>)  table.Phases[Phase_LateUpdate].push_back(&_DispatchPool<T, Phase_LateUpdate>);
+		if constexpr (!std::is_same_v<decltype(&T::RenderGUI), BaseEvent>)   table.Phases[Phase_RenderGUI].push_back(&_DispatchPool<T, Phase_RenderGUI>);
+
+		registry.on_destroy<T>().template connect<&_OnDestroyed<T>>();
+		// Behaviours are components now, so they need to be registered to be stamped from prefabs
+		GameScene::RegisterComponentType<T>();
+		return table;
+	}
+
+	template <typename T, Phase P>
+	static void _DispatchPool(entt::registry& registry) {
+		if constexpr (P == Phase_Update || P == Phase_FixedUpdate) {
+			PoolTable& table = registry.ctx<PoolTable>();
+			const uint64_t frame = table.Frames[P];
+			const float dt = P == Phase_Update ? Timing::Instance().DeltaTime : Timing::Instance().FixedTimeStep;
+			registry.view<T>().each([&](const entt::entity entity, T& behaviour) {
+				if (!behaviour.Enabled) {
+					// Time spent disabled shouldn't be handed to the first update after being re-enabled
+					behaviour._pendingTime[P] = 0.0f;
+					return;
+				}
+				if (!_IsDue(registry, table, entity, behaviour, frame)) {
+					behaviour._pendingTime[P] += dt;
+					table.Stats.Skipped++;
+					return;
+				}
+				behaviour._deltaTime[P] = behaviour._pendingTime[P] + dt;
+				behaviour._pendingTime[P] = 0.0f;
+				table.Stats.Invoked++;
+				// Qualifying the call with T means it's resolved at compile time, instead of through the vtable
+				if constexpr (P == Phase_Update)      behaviour.T::Update(entt::handle(registry, entity));
+				if constexpr (P == Phase_FixedUpdate) behaviour.T::FixedUpdate(entt::handle(registry, entity));
+			});
+		} else {
+			registry.view<T>().each([&registry](const entt::entity entity, T& behaviour) {
+				if (behaviour.Enabled) {
+					if constexpr (P == Phase_LateUpdate)  behaviour.T::LateUpdate(entt::handle(registry, entity));
+					if constexpr (P == Phase_RenderGUI)   behaviour.T::RenderGUI(entt::handle(registry, entity));
+				}
+			});
+		}
+	}
+
+	/*
+	 * Checks whether a behaviour should be updated on the given frame (or fixed tick), given it's Rate and phase
+	 */
+	static bool _IsDue(entt::registry& registry, const PoolTable& table, const entt::entity entity, const IBehaviour& behaviour, uint64_t frame) {
+		uint32_t interval = behaviour.Rate.Interval;
+		if (behaviour.Rate.FarDistance > 0.0f) {
+			const Transform* transform = registry.try_get<Transform>(entity);
+			if (transform != nullptr) {
+				const glm::vec3 offset = glm::vec3(transform->WorldTransform()[3]) - table.LodOrigin;
+				if (glm::dot(offset, offset) > behaviour.Rate.FarDistance * behaviour.Rate.FarDistance) {
+					interval = behaviour.Rate.FarInterval;
 				}
 			}
-			return nullptr;
 		}
-		else return nullptr;
+		return interval <= 1 || (frame + behaviour._ratePhase) % interval == 0;
 	}
-};
\ No newline at end of file
+
+	template <typename T>
+	static void _OnDestroyed(entt::registry& registry, const entt::entity entity) {
+		registry.get<T>(entity).OnUnload(entt::handle(registry, entity));
+	}
+};
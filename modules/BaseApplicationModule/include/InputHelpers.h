@@ -1,28 +1,37 @@
 #pragma once
 
 #include <functional>
-
-struct GLFWwindow;
+#include <entt.hpp>
+#include "Coroutine.h"
 
 /// <summary>
-/// Helper class for watching a single key and invoking a method on the first frame that it is
-/// pressed
+/// Helper class for watching a single key and invoking a method on each frame that it is first pressed. The
+/// watcher is a coroutine waiting on the key (see CoroutineScheduler), so it costs nothing until the key is pressed
 /// </summary>
 struct KeyPressWatcher final
 {
 public:
 	/// <summary>
-	/// Creates a new key press watcher with a given key code and callback
+	/// Creates a new key press watcher with a given key code and callback, and starts watching the key
 	/// </summary>
+	/// <param name="owner">The entity that owns the watcher, it stops watching when the entity is destroyed</param>
 	/// <param name="keycode">The GLFW key to watch</param>
 	/// <param name="onPressed">The function to invoke on the first frame the key is pressed</param>
-	KeyPressWatcher(int keycode, const std::function<void()>& onPressed);
+	KeyPressWatcher(entt::handle owner, int keycode, const std::function<void()>& onPressed);
 	~KeyPressWatcher() = default;
 
-	bool Poll(GLFWwindow* window) const;
+	/// <summary>
+	/// Stops watching the key, does nothing if the watcher has already stopped
+	/// </summary>
+	void Stop();
+	/// <summary>
+	/// Checks whether the watcher is still watching it's key
+	/// </summary>
+	bool IsWatching() const;
 	
 protected:
-	int _keyCode;
-	mutable bool _isPressed;
-	std::function<void()> _onPressed;
+	entt::handle _owner;
+	CoroutineHandle _routine;
+
+	static Coroutine _Watch(int keycode, std::function<void()> onPressed);
 };
\ No newline at end of file
@@ -0,0 +1,216 @@
+#pragma once
+#include <bitset>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <GLM/glm.hpp>
+
+struct GLFWwindow;
+
+/// <summary>
+/// A single raw input event, as received from GLFW (or injected / replayed)
+/// </summary>
+struct InputEvent {
+	enum class Type : uint8_t {
+		Key,
+		MouseButton,
+		CursorMove,
+		Scroll,
+		Char
+	};
+
+	Type  Kind   = Type::Key;
+	bool  IsDown = false;
+	// The key, mouse button or unicode codepoint
+	int   Code   = 0;
+	// The cursor position or scroll offset
+	float X      = 0.0f;
+	float Y      = 0.0f;
+
+	static InputEvent Key(int key, bool isDown) { InputEvent result; result.Kind = Type::Key; result.Code = key; result.IsDown = isDown; return result; }
+	static InputEvent MouseButton(int button, bool isDown) { InputEvent result; result.Kind = Type::MouseButton; result.Code = button; result.IsDown = isDown; return result; }
+	static InputEvent CursorMove(float x, float y) { InputEvent result; result.Kind = Type::CursorMove; result.X = x; result.Y = y; return result; }
+	static InputEvent Scroll(float x, float y) { InputEvent result; result.Kind = Type::Scroll; result.X = x; result.Y = y; return result; }
+	static InputEvent Char(uint32_t codepoint) { InputEvent result; result.Kind = Type::Char; result.Code = static_cast<int>(codepoint); return result; }
+};
+
+/// <summary>
+/// Something that can trigger an action, either a key or a mouse button
+/// </summary>
+struct InputBinding {
+	enum class Device : uint8_t {
+		Key,
+		MouseButton
+	};
+
+	Device Source = Device::Key;
+	int    Code   = 0;
+
+	static InputBinding Key(int key) { return { Device::Key, key }; }
+	static InputBinding MouseButton(int button) { return { Device::MouseButton, button }; }
+};
+
+typedef uint32_t InputAction;
+
+/// <summary>
+/// The state of all the inputs for a single frame. Snapshots are built once per frame from the events that arrived
+/// since the last frame, and do not change during the frame, so every query is just a bit test
+///
+/// Presses and releases are tracked separately from the held state, so a key that is tapped within a single frame
+/// will still report as pressed (and released) that frame
+/// </summary>
+class InputSnapshot final {
+public:
+	static constexpr int KeyCount = 512;
+	static constexpr int MouseButtonCount = 8;
+
+	uint64_t  Frame = 0;
+	glm::vec2 MousePosition = glm::vec2(0.0f);
+	glm::vec2 MouseDelta = glm::vec2(0.0f);
+	glm::vec2 Scroll = glm::vec2(0.0f);
+	// Unicode codepoints typed this frame, in order
+	std::vector<uint32_t> Characters;
+
+	bool IsKeyDown(int key) const { return _IsValidKey(key) && _keysHeld[key]; }
+	bool WasKeyPressed(int key) const { return _IsValidKey(key) && _keysPressed[key]; }
+	bool WasKeyReleased(int key) const { return _IsValidKey(key) && _keysReleased[key]; }
+
+	bool IsMouseDown(int button) const { return _IsValidButton(button) && _mouseHeld[button]; }
+	bool WasMousePressed(int button) const { return _IsValidButton(button) && _mousePressed[button]; }
+	bool WasMouseReleased(int button) const { return _IsValidButton(button) && _mouseReleased[button]; }
+
+	bool IsActionDown(InputAction action) const { return action < _actions.size() && (_actions[action] & Action_Held); }
+	bool WasActionPressed(InputAction action) const { return action < _actions.size() && (_actions[action] & Action_Pressed); }
+	bool WasActionReleased(InputAction action) const { return action < _actions.size() && (_actions[action] & Action_Released); }
+
+private:
+	friend class InputSystem;
+
+	enum ActionFlags : uint8_t {
+		Action_Held     = 1 << 0,
+		Action_Pressed  = 1 << 1,
+		Action_Released = 1 << 2
+	};
+
+	std::bitset<KeyCount> _keysHeld, _keysPressed, _keysReleased;
+	std::bitset<MouseButtonCount> _mouseHeld, _mousePressed, _mouseReleased;
+	std::vector<uint8_t> _actions;
+
+	static bool _IsValidKey(int key) { return key >= 0 && key < KeyCount; }
+	static bool _IsValidButton(int button) { return button >= 0 && button < MouseButtonCount; }
+};
+
+/// <summary>
+/// A recorded stream of input, which can be replayed through the InputSystem to reproduce a session exactly.
+/// The frame times are recorded as well, so that replays step the simulation identically
+/// </summary>
+struct InputRecording {
+	struct Frame {
+		float    DeltaTime;
+		uint32_t FirstEvent;
+		uint32_t EventCount;
+	};
+
+	// The keys and buttons that were held, and where the cursor was, when recording started. The replay starts
+	// from this state without it counting as presses
+	std::vector<InputEvent> InitialState;
+	std::vector<Frame>      Frames;
+	std::vector<InputEvent> Events;
+
+	bool SaveToFile(const std::string& path) const;
+	static bool LoadFromFile(const std::string& path, InputRecording& result);
+};
+
+/// <summary>
+/// Collects input from the GLFW callbacks, and turns it into an InputSnapshot once per frame
+///
+/// Actions map names to one or more bindings, and are resolved into the snapshot so that querying an action is as
+/// cheap as querying a key. The system can also record the events it receives and replay them later, in which
+/// case live input is ignored. Events can be injected with PushEvent, which makes it possible to drive the input
+/// system without a window
+/// </summary>
+class InputSystem final {
+public:
+	static constexpr InputAction InvalidAction = ~0u;
+
+	/// <summary>
+	/// Installs the GLFW callbacks on the given window. Any callbacks that were already installed are still invoked
+	/// </summary>
+	static void Init(GLFWwindow* window);
+
+	/// <summary>
+	/// Builds the snapshot for the next frame from the events received since the last call. This should be called
+	/// once per frame, after polling GLFW events and updating Timing::DeltaTime
+	/// </summary>
+	static void BeginFrame();
+
+	/// <summary>
+	/// Gets the input state for the current frame
+	/// </summary>
+	static const InputSnapshot& Current() { return _current; }
+
+	/// <summary>
+	/// Queues an event to be included in the next snapshot
+	/// </summary>
+	static void PushEvent(const InputEvent& event);
+
+	/// <summary>
+	/// Adds a binding to the given action, creating the action if it does not exist yet
+	/// </summary>
+	/// <returns>The identifier for the action, for use with the InputSnapshot queries</returns>
+	static InputAction MapAction(const std::string& name, const InputBinding& binding);
+	/// <summary>
+	/// Gets the identifier for the action with the given name, or InvalidAction if it has not been mapped
+	/// </summary>
+	static InputAction GetAction(const std::string& name);
+	/// <summary>
+	/// Removes all the bindings from the given action
+	/// </summary>
+	static void ClearAction(InputAction action);
+
+	/// <summary>
+	/// Starts recording input. The state of any held keys and buttons is captured in the recording's InitialState
+	/// </summary>
+	static void StartRecording();
+	/// <summary>
+	/// Stops recording, returning everything that was recorded
+	/// </summary>
+	static InputRecording StopRecording();
+	static bool IsRecording() { return _isRecording; }
+
+	/// <summary>
+	/// Starts replaying a recording. While replaying, live input is ignored and Timing::DeltaTime is overridden
+	/// with the recorded frame times. Live input resumes once the recording has finished
+	/// </summary>
+	static void StartReplay(const InputRecording& recording);
+	static void StopReplay();
+	static bool IsReplaying() { return _isReplaying; }
+
+private:
+	struct Action {
+		std::string Name;
+		std::vector<InputBinding> Bindings;
+	};
+
+	static InputSnapshot _current;
+	static std::vector<InputEvent> _pending;
+	static std::vector<Action> _actions;
+	static std::unordered_map<std::string, InputAction> _actionLookup;
+
+	static bool _isRecording;
+	static InputRecording _recording;
+	static bool _isReplaying;
+	static InputRecording _replay;
+	static size_t _replayFrame;
+
+	static void _ApplyEvent(const InputEvent& event);
+	static void _RestoreState(const InputEvent& event);
+	static void _ResetState();
+
+	static void _KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+	static void _MouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
+	static void _CursorPosCallback(GLFWwindow* window, double x, double y);
+	static void _ScrollCallback(GLFWwindow* window, double x, double y);
+	static void _CharCallback(GLFWwindow* window, unsigned int codepoint);
+};
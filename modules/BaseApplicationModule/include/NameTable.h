@@ -0,0 +1,59 @@
+#pragma once
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <cstdint>
+
+/// <summary>
+/// A 32-bit identifier for an interned string. Two names are equal if and only if their IDs are equal
+/// </summary>
+typedef uint32_t NameId;
+
+/// <summary>
+/// The global string intern table. Every unique string is stored once, and is identified by a small, dense NameId,
+/// so names can be copied and compared as integers, and used to index arrays directly
+///
+/// Strings are never removed from the table, so the references returned by GetString stay valid for the lifetime
+/// of the program. The table is safe to use from multiple threads
+/// </summary>
+class NameTable final {
+public:
+	/// <summary>
+	/// The ID of the empty string, which is always interned
+	/// </summary>
+	static constexpr NameId Empty = 0;
+	/// <summary>
+	/// Returned by Find for strings that have never been interned
+	/// </summary>
+	static constexpr NameId Invalid = ~0u;
+
+	/// <summary>
+	/// Gets the ID for the given string, adding it to the table if this is the first time we have seen it
+	/// </summary>
+	static NameId Intern(std::string_view name);
+	/// <summary>
+	/// Gets the ID for the given string without adding it to the table, this never allocates
+	/// </summary>
+	/// <returns>The ID of the string, or Invalid if it has never been interned</returns>
+	static NameId Find(std::string_view name);
+	/// <summary>
+	/// Gets the string that an ID was interned from
+	/// </summary>
+	static const std::string& GetString(NameId id);
+	/// <summary>
+	/// Gets the number of unique strings in the table
+	/// </summary>
+	static size_t Size();
+
+private:
+	// A deque never moves it's elements, so the views in the lookup can point straight into it
+	std::deque<std::string> _strings;
+	std::unordered_map<std::string_view, NameId> _lookup;
+	mutable std::shared_mutex _mutex;
+
+	NameTable();
+	static NameTable& _Instance();
+};
@@ -1,6 +1,10 @@
 #pragma once
 #include "entt.hpp"
+#include <GLM/glm.hpp>
+#include <GLM/gtc/quaternion.hpp>
 #include <Macros.h>
+#include "LoggingBase.h"
+#include "NameTable.h"
 
 /// <summary>
 /// Represents a callback that may be used to customize how entity stamping works between registries
@@ -9,6 +13,24 @@ typedef void(*StampFunction)(const entt::registry& from, const entt::entity src,
 
 typedef entt::handle GameObject;
 
+/// <summary>
+/// The local transform to give an instance when stamping many copies of a prefab at once (see GameScene::StampMany)
+/// </summary>
+struct InstanceTransform {
+	glm::vec3 Position = glm::vec3(0.0f);
+	glm::quat Rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+	glm::vec3 Scale    = glm::vec3(1.0f);
+};
+
+/// <summary>
+/// Published on the EventBus for each entity that a scene destroys in Poll (entities destroyed directly through the
+/// registry are not reported). The entity is already gone by the time the event is delivered
+/// </summary>
+struct EntityDestroyedEvent {
+	const entt::registry* Registry = nullptr;
+	entt::entity Entity = entt::null;
+};
+
 class GameScene final
 {
 	SMART_MEMORY_MANAGED(GameScene)
@@ -21,21 +43,52 @@ public:
 	
 	entt::handle CreateEntity(const std::string& name = "");
 	entt::handle CreateEntity(entt::entity prefab, const std::string& name = "");
+	/// <summary>
+	/// Creates many copies of a prefab at once. Storage is reserved up front, and each component type is copied to
+	/// all of the new entities in one go, which is much faster than creating the entities one at a time
+	/// </summary>
+	/// <param name="prefab">The prefab to copy, from the Prefabs() registry</param>
+	/// <param name="count">The number of copies to make</param>
+	/// <param name="transforms">The local transforms for each copy, or nullptr to use the prefab's transform</param>
+	/// <returns>The new entities</returns>
+	std::vector<entt::entity> StampMany(entt::entity prefab, size_t count, const InstanceTransform* transforms = nullptr);
+
+	/// <summary>
+	/// Queues an entity to be destroyed the next time Poll is called. It is safe to queue an entity more than once
+	/// </summary>
 	void RemoveEntity(entt::handle handle);
+	/// <summary>
+	/// Queues a range of entities to be destroyed the next time Poll is called
+	/// </summary>
+	template <typename It>
+	void RemoveEntities(It first, It last) {
+		_deletionQueue.insert(_deletionQueue.end(), first, last);
+	}
 
+	/// <summary>
+	/// Sets the name of an entity, keeping the name index up to date
+	/// </summary>
+	void SetName(entt::handle handle, const std::string& name);
+
+	/// <summary>
+	/// Finds the first entity in FindAll, this is a constant time lookup and never allocates
+	/// </summary>
+	/// <returns>A handle to the entity, or a null handle if no entity has the name</returns>
 	entt::handle FindFirst(const std::string& name);
+	entt::handle FindFirst(NameId name);
+	/// <summary>
+	/// Gets all the entities with the given name, in no particular order. This is a constant time lookup and never
+	/// allocates. The result is invalidated when entities are created, destroyed or renamed
+	/// </summary>
+	const std::vector<entt::entity>& FindAll(const std::string& name) const;
+	const std::vector<entt::entity>& FindAll(NameId name) const;
 
 	entt::registry& Registry() { return _registry; }
 
 	/// <summary>
 	/// Perform any tasks that should happen at the end of a loop, such as deleting queued objects
 	/// </summary>
-	void Poll() {
-		for(entt::entity instance : _deletionQueue) {
-			_registry.destroy(instance);
-		}
-		_deletionQueue.clear();
-	}
+	void Poll();
 
 	/// <summary>
 	/// Creates a new entity in the <i>to</i> registry, copying the components from the <i>src</i> entity in the from registry
@@ -48,19 +101,49 @@ public:
 
 	template <typename Type>
 	static void RegisterComponentType(StampFunction stampOverride = nullptr) {
-		_stampFunctions[entt::type_info<Type>::id()] = stampOverride != nullptr ? stampOverride : &_DefaultComponentStamp<Type>;
+		// Components that can't be copied (ex: Transform) must provide their own stamp function
+		if constexpr (std::is_copy_constructible_v<Type>) {
+			_stampFunctions[entt::type_info<Type>::id()] = stampOverride != nullptr ? stampOverride : &_DefaultComponentStamp<Type>;
+			// Overrides are applied one entity at a time, so they only get a bulk stamp if they use the default
+			_stampManyFunctions[entt::type_info<Type>::id()] = stampOverride != nullptr ? nullptr : &_DefaultComponentStampMany<Type>;
+		} else {
+			LOG_ASSERT(stampOverride != nullptr, "{} can't be copied, it needs a stamp function to be registered", entt::type_info<Type>::name());
+			_stampFunctions[entt::type_info<Type>::id()] = stampOverride;
+			_stampManyFunctions[entt::type_info<Type>::id()] = nullptr;
+		}
 	}
 	static entt::registry& Prefabs() { return _prefabRegistry; }
 	
 private:
 	entt::registry _registry;
 	std::vector<entt::entity> _deletionQueue;
+	// The entities with each name, indexed by NameId. Kept up to date by the GameObjectTag construct/update/destroy signals
+	std::vector<std::vector<entt::entity>> _nameIndex;
+	// Where each entity is within it's name's bucket, indexed by entity, so removing from the index is constant time
+	std::vector<uint32_t> _nameSlots;
+	// The name each entity was indexed under, indexed by entity. The tag may already hold a new name by the time
+	// we hear about it, so we can't use it to find the entity's bucket
+	std::vector<NameId> _indexedNames;
 
 	static entt::registry _prefabRegistry;
 	static std::unordered_map<entt::id_type, StampFunction> _stampFunctions;
 
+	typedef void(*StampManyFunction)(const entt::registry& from, const entt::entity src, entt::registry& to, const entt::entity* first, const entt::entity* last);
+	static std::unordered_map<entt::id_type, StampManyFunction> _stampManyFunctions;
+
+	void _AddToIndex(NameId name, entt::entity entity);
+	void _RemoveFromIndex(entt::entity entity);
+	void _OnTagConstructed(entt::registry& registry, const entt::entity entity);
+	void _OnTagUpdated(entt::registry& registry, const entt::entity entity);
+	void _OnTagDestroyed(entt::registry& registry, const entt::entity entity);
+
 	template <typename T>
 	static void _DefaultComponentStamp(const entt::registry& from, const entt::entity src, entt::registry& to, const entt::entity dst) {
 		to.emplace_or_replace<T>(dst, from.get<T>(src));
 	}
+
+	template <typename T>
+	static void _DefaultComponentStampMany(const entt::registry& from, const entt::entity src, entt::registry& to, const entt::entity* first, const entt::entity* last) {
+		to.insert<T>(first, last, from.get<T>(src));
+	}
 };
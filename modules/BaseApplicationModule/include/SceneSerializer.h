@@ -0,0 +1,204 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cereal/cereal.hpp>
+#include <cereal/archives/binary.hpp>
+#include <cereal/archives/json.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+
+#include "CerealGLM.h"
+#include "IBehaviour.h"
+#include "Scene.h"
+
+/// <summary>
+/// The formats that a scene can be saved in
+/// </summary>
+enum class SceneFormat {
+	Binary,           // A compact cereal binary archive
+	CompressedBinary, // The binary archive, compressed with gzip
+	Json              // A text archive, for diffing and hand editing
+};
+
+/// <summary>
+/// Saves and loads GameScenes. Every entity is saved with it's name and transform (including it's parent), along
+/// with any components whose types have been registered with RegisterType or RegisterBehaviour. Components are
+/// streamed one type at a time, so saving and loading walks each component pool in order
+///
+/// Component types need to be serializable with cereal (ie. have a serialize function, or save / load functions),
+/// and default constructible. Components that refer to assets should save the asset's path (see AssetLibrary)
+///
+/// Scenes can be saved to and loaded from strings as well as files, which makes it possible to round trip a scene
+/// without a window or any files
+/// </summary>
+class SceneSerializer final {
+public:
+	/// <summary>
+	/// Invoked for each component of a type after the whole scene has been loaded
+	/// </summary>
+	typedef void(*PostLoadFunction)(entt::handle entity);
+
+	/// <summary>
+	/// Registers a component type to be saved with scenes. Types that are not registered are skipped when saving
+	/// </summary>
+	/// <typeparam name="T">The type of component to register</typeparam>
+	/// <param name="name">The name to save the type under, this must be unique, and should not change between versions</param>
+	/// <param name="postLoad">An optional callback to invoke on each loaded component once the rest of the scene has loaded</param>
+	template <typename T>
+	static void RegisterType(const std::string& name, PostLoadFunction postLoad = nullptr) {
+		TypeEntry entry;
+		entry.Name = name;
+		entry.SaveBinary = &_SaveComponents<T, cereal::BinaryOutputArchive>;
+		entry.LoadBinary = &_LoadComponents<T, cereal::BinaryInputArchive>;
+		entry.SaveJson = &_SaveComponents<T, cereal::JSONOutputArchive>;
+		entry.LoadJson = &_LoadComponents<T, cereal::JSONInputArchive>;
+		entry.PostLoad = postLoad;
+		_RegisterEntry(entry);
+	}
+
+	/// <summary>
+	/// Registers a behaviour type to be saved with scenes. Loaded behaviours are bound to their entities and have
+	/// their OnLoad invoked once the rest of the scene has loaded
+	/// </summary>
+	template <typename T, typename = typename std::enable_if<std::is_base_of<IBehaviour, T>::value>::type>
+	static void RegisterBehaviour(const std::string& name) {
+		RegisterType<T>(name, &BehaviourBinding::Adopt<T>);
+	}
+
+	/// <summary>
+	/// Saves a scene to a file
+	/// </summary>
+	/// <returns>True if the scene was saved, false if the file could not be written</returns>
+	static bool SaveToFile(GameScene& scene, const std::string& path, SceneFormat format = SceneFormat::CompressedBinary);
+	/// <summary>
+	/// Loads a scene from a file saved with SaveToFile, the format is detected automatically
+	/// </summary>
+	/// <returns>The new scene, or nullptr if the file could not be read or is not a valid scene</returns>
+	static GameScene::sptr LoadFromFile(const std::string& path);
+
+	/// <summary>
+	/// Saves a scene into a string
+	/// </summary>
+	static std::string SaveToString(GameScene& scene, SceneFormat format = SceneFormat::Binary);
+	/// <summary>
+	/// Saves some of a scene's entities into a string, as if they were a scene of their own. Children are not
+	/// included automatically, and parents that are not in the list are dropped
+	/// </summary>
+	/// <param name="entities">The entities to save, these must all be valid</param>
+	static std::string SaveToString(GameScene& scene, const std::vector<entt::entity>& entities, SceneFormat format = SceneFormat::Binary);
+	/// <summary>
+	/// Loads a scene from a string saved with SaveToString, the format is detected automatically
+	/// </summary>
+	/// <returns>The new scene, or nullptr if the data is not a valid scene</returns>
+	static GameScene::sptr LoadFromString(const std::string& data);
+	/// <summary>
+	/// Loads a scene saved with SaveToString into an existing scene, adding it's entities alongside the ones
+	/// that are already there. The name of the saved scene is ignored
+	/// </summary>
+	/// <param name="created">If not null, the entities that were loaded are appended to this list</param>
+	/// <returns>True if the data was loaded, if not anything that was partially loaded is removed from the scene</returns>
+	static bool LoadIntoScene(GameScene& scene, const std::string& data, std::vector<entt::entity>* created = nullptr);
+
+private:
+	friend struct SceneStreams;
+
+	// Maps the index part of an entity ID to the entity's position in the saved entity list
+	typedef std::vector<uint32_t> EntityIndexMap;
+
+	struct TypeEntry {
+		std::string Name;
+		void(*SaveBinary)(cereal::BinaryOutputArchive&, entt::registry&, const std::vector<entt::entity>&);
+		void(*LoadBinary)(cereal::BinaryInputArchive&, entt::registry&, const std::vector<entt::entity>&, std::vector<entt::entity>&);
+		void(*SaveJson)(cereal::JSONOutputArchive&, entt::registry&, const std::vector<entt::entity>&);
+		void(*LoadJson)(cereal::JSONInputArchive&, entt::registry&, const std::vector<entt::entity>&, std::vector<entt::entity>&);
+		PostLoadFunction PostLoad;
+	};
+
+	static std::vector<TypeEntry> _types;
+
+	static void _RegisterEntry(const TypeEntry& entry);
+	static const TypeEntry* _FindEntry(const std::string& name);
+	static uint32_t _LookupIndex(const EntityIndexMap& indices, entt::entity entity);
+
+	// Writes out a single component, along with the index of the entity that owns it
+	template <typename T>
+	struct ComponentOut {
+		uint32_t Entity;
+		const T* Component;
+
+		template <typename Archive>
+		void save(Archive& archive) const {
+			archive(cereal::make_nvp("Entity", Entity), cereal::make_nvp("Data", *Component));
+		}
+	};
+
+	// Writes out the components of a type that belong to the saved entities as an array
+	template <typename T>
+	struct PoolOut {
+		entt::registry* Registry;
+		const std::vector<entt::entity>* Entities;
+
+		template <typename Archive>
+		void save(Archive& archive) const {
+			cereal::size_type count = 0;
+			for (const entt::entity entity : *Entities) {
+				count += Registry->has<T>(entity) ? 1 : 0;
+			}
+			archive(cereal::make_size_tag(count));
+			for (size_t ix = 0; ix < Entities->size(); ix++) {
+				const T* component = Registry->try_get<T>((*Entities)[ix]);
+				if (component != nullptr) {
+					archive(ComponentOut<T>{ static_cast<uint32_t>(ix), component });
+				}
+			}
+		}
+	};
+
+	// Reads back a component written by ComponentOut
+	template <typename T>
+	struct ComponentIn {
+		uint32_t Entity = 0;
+		T        Component = T();
+
+		template <typename Archive>
+		void load(Archive& archive) {
+			archive(cereal::make_nvp("Entity", Entity), cereal::make_nvp("Data", Component));
+		}
+	};
+
+	// Reads back an array written by PoolOut, adding the components to the loaded entities
+	template <typename T>
+	struct PoolIn {
+		entt::registry* Registry;
+		const std::vector<entt::entity>* Entities;
+		std::vector<entt::entity>* Loaded;
+
+		template <typename Archive>
+		void load(Archive& archive) {
+			cereal::size_type count;
+			archive(cereal::make_size_tag(count));
+			Registry->reserve<T>(Registry->size<T>() + static_cast<size_t>(count));
+			for (cereal::size_type ix = 0; ix < count; ix++) {
+				ComponentIn<T> record;
+				archive(record);
+				if (record.Entity >= Entities->size()) {
+					throw cereal::Exception("Component refers to an entity that does not exist");
+				}
+				const entt::entity entity = (*Entities)[record.Entity];
+				Registry->emplace_or_replace<T>(entity, std::move(record.Component));
+				Loaded->push_back(entity);
+			}
+		}
+	};
+
+	template <typename T, typename Archive>
+	static void _SaveComponents(Archive& archive, entt::registry& registry, const std::vector<entt::entity>& entities) {
+		archive(cereal::make_nvp("Instances", PoolOut<T>{ &registry, &entities }));
+	}
+
+	template <typename T, typename Archive>
+	static void _LoadComponents(Archive& archive, entt::registry& registry, const std::vector<entt::entity>& entities, std::vector<entt::entity>& loaded) {
+		PoolIn<T> pool{ &registry, &entities, &loaded };
+		archive(cereal::make_nvp("Instances", pool));
+	}
+};
@@ -9,5 +9,11 @@ public:
 	SimpleMoveBehaviour() = default;
 	~SimpleMoveBehaviour() = default;
 
-	void Update(entt::handle entity) override;
+	void FixedUpdate(entt::handle entity) override;
+
+	template <typename Archive>
+	void serialize(Archive& archive) {
+		IBehaviour::serialize(archive);
+		archive(CEREAL_NVP(Relative));
+	}
 };
@@ -0,0 +1,232 @@
+#pragma once
+#include <entt.hpp>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <typeinfo>
+#include <mutex>
+#include <type_traits>
+
+// Access validation is on by default in debug builds, it can be toggled at runtime with SetValidateAccess
+#if defined(_DEBUG) && !defined(SYSTEM_SCHEDULER_VALIDATE)
+#define SYSTEM_SCHEDULER_VALIDATE 1
+#endif
+
+class SystemScheduler;
+
+/// <summary>
+/// Passed to each system when it runs, provides access to the registry and helpers for splitting work across threads
+/// </summary>
+class SystemContext final {
+public:
+	entt::registry& Registry;
+
+	/// <summary>
+	/// Gets a view of the given components, checking that the system declared access to them. Components that
+	/// are only read should be requested as const
+	/// </summary>
+	template <typename... Component>
+	auto View() {
+		(_CheckAccess<Component>(), ...);
+		return Registry.view<Component...>();
+	}
+
+	/// <summary>
+	/// Iterates over all entities with the given components, splitting the view into chunks that are processed
+	/// across the JobSystem's workers. Returns once every chunk has been processed
+	/// </summary>
+	/// <param name="func">A callable with the signature void(entt::entity, Component&...)</param>
+	/// <param name="chunkSize">The number of entities to process per job</param>
+	template <typename... Component, typename Func>
+	void ParallelEach(Func func, size_t chunkSize = 1024) {
+		auto view = View<Component...>();
+		_entities.assign(view.begin(), view.end());
+		_RunChunks(_entities.size(), chunkSize, [this, &view, &func](size_t first, size_t last) {
+			for (size_t ix = first; ix < last; ix++) {
+				const entt::entity entity = _entities[ix];
+				func(entity, view.template get<Component>(entity)...);
+			}
+		});
+	}
+
+private:
+	friend class SystemScheduler;
+
+	SystemContext(entt::registry& registry, SystemScheduler& scheduler, size_t system) :
+		Registry(registry), _scheduler(scheduler), _system(system) {}
+
+	SystemScheduler& _scheduler;
+	size_t _system;
+	std::vector<entt::entity> _entities;
+
+	template <typename Component>
+	void _CheckAccess();
+	void _RunChunks(size_t count, size_t chunkSize, const std::function<void(size_t, size_t)>& func);
+};
+
+/// <summary>
+/// Runs a set of systems each frame, in parallel where their declared component access allows it
+///
+/// Each system declares the components it reads and writes. Two systems conflict if either of them writes a
+/// component that the other accesses, and conflicting systems always run in the order they were added. Everything
+/// else is free to run at the same time on the JobSystem's workers. Systems that touch the GL context or GLFW should be marked
+/// as MainThread, they will always run on the thread that calls Run
+///
+/// When SYSTEM_SCHEDULER_VALIDATE is defined, component construction, updates and destruction (and any View
+/// requested through the SystemContext) are checked against the running system's declared access. Only component
+/// types that at least one system declares are tracked. Components whose data lives outside the registry must
+/// raise on_update themselves to be checked (TransformStore does this for Transform). Types that can't be stored
+/// in the registry (like ShaderMaterial, which lives in a ResourcePool) can still be declared to order the systems
+/// that use them, but they aren't checked
+/// </summary>
+class SystemScheduler final {
+public:
+	typedef std::function<void(SystemContext&)> SystemFunc;
+
+	/// <summary>
+	/// The timings for a single system during the last frame
+	/// </summary>
+	struct SystemTiming {
+		std::string Name;
+		float StartMs;
+		float DurationMs;
+		bool  OnMainThread;
+	};
+
+	/// <summary>
+	/// Results from the last call to Run
+	/// </summary>
+	struct FrameReport {
+		std::vector<SystemTiming> Systems;
+		// Indices into Systems, the longest chain of dependent systems that bounds the frame
+		std::vector<size_t> CriticalPath;
+		float CriticalPathMs = 0.0f;
+		float WallMs = 0.0f;
+		// Descriptions of any undeclared component access seen so far, each violation is only reported once
+		std::vector<std::string> AccessViolations;
+	};
+
+	/// <summary>
+	/// Returned by AddSystem, used to declare a system's access
+	/// </summary>
+	class SystemBuilder {
+	public:
+		template <typename... Component>
+		SystemBuilder& Reads() { (_scheduler._AddAccess<Component>(_system, false), ...); return *this; }
+		template <typename... Component>
+		SystemBuilder& Writes() { (_scheduler._AddAccess<Component>(_system, true), ...); return *this; }
+		/// <summary>
+		/// Forces the system to run on the thread that calls Run
+		/// </summary>
+		SystemBuilder& MainThread() { _scheduler._systems[_system].MainThread = true; return *this; }
+
+	private:
+		friend class SystemScheduler;
+		SystemBuilder(SystemScheduler& scheduler, size_t system) : _scheduler(scheduler), _system(system) {}
+		SystemScheduler& _scheduler;
+		size_t _system;
+	};
+
+	/// <summary>
+	/// Creates a new scheduler
+	/// </summary>
+	/// <param name="workerCount">The number of worker threads to start the JobSystem with if it isn't already running, or 0 to use one less than the number of hardware threads</param>
+	SystemScheduler(size_t workerCount = 0);
+	~SystemScheduler();
+
+	SystemScheduler(const SystemScheduler& other) = delete;
+	SystemScheduler& operator =(const SystemScheduler& other) = delete;
+
+	/// <summary>
+	/// Adds a system to the scheduler. Systems can not be added while the scheduler is running
+	/// </summary>
+	/// <param name="name">The name of the system, used in reports</param>
+	/// <param name="func">The function to invoke each frame</param>
+	SystemBuilder AddSystem(const std::string& name, const SystemFunc& func);
+
+	/// <summary>
+	/// Runs all the systems once, returning when they have all completed
+	/// </summary>
+	void Run(entt::registry& registry);
+
+	const FrameReport& GetLastReport() const { return _report; }
+
+	void SetValidateAccess(bool enabled) { _validateAccess = enabled; }
+	bool GetValidateAccess() const { return _validateAccess; }
+
+	size_t GetWorkerCount() const;
+
+private:
+	friend class SystemContext;
+	friend struct SystemSchedulerHooks;
+
+	struct Access {
+		entt::id_type Type;
+		const char*   Name;
+		bool          Write;
+		// Connects or disconnects the validation hooks for this component type, null if it can't be a component
+		void(*Hook)(entt::registry&, SystemScheduler&, bool);
+	};
+
+	struct System {
+		std::string Name;
+		SystemFunc Func;
+		bool MainThread = false;
+		std::vector<Access> Accesses;
+		std::vector<size_t> Dependents;
+		size_t DependencyCount = 0;
+	};
+
+	std::vector<System> _systems;
+	bool _isGraphDirty;
+	bool _validateAccess;
+	entt::registry* _hookedRegistry;
+	std::vector<Access> _hookedTypes;
+	FrameReport _report;
+	std::mutex _violationMutex;
+
+	template <typename Component>
+	void _AddAccess(size_t system, bool write) {
+		typedef std::decay_t<Component> Type;
+		void(*hook)(entt::registry&, SystemScheduler&, bool) = nullptr;
+		if constexpr (std::is_move_constructible_v<Type> && std::is_move_assignable_v<Type>) {
+			hook = &_HookComponent<Type>;
+		}
+		_systems[system].Accesses.push_back({ entt::type_info<Type>::id(), typeid(Type).name(), write, hook });
+		_isGraphDirty = true;
+	}
+
+	template <typename Component>
+	static void _HookComponent(entt::registry& registry, SystemScheduler& scheduler, bool connect) {
+		if (connect) {
+			registry.on_construct<Component>().template connect<&SystemScheduler::_OnWrite<Component>>(scheduler);
+			registry.on_update<Component>().template connect<&SystemScheduler::_OnWrite<Component>>(scheduler);
+			registry.on_destroy<Component>().template connect<&SystemScheduler::_OnWrite<Component>>(scheduler);
+		} else {
+			registry.on_construct<Component>().disconnect(scheduler);
+			registry.on_update<Component>().disconnect(scheduler);
+			registry.on_destroy<Component>().disconnect(scheduler);
+		}
+	}
+
+	template <typename Component>
+	void _OnWrite(entt::registry&, const entt::entity) {
+		_ValidateAccess(entt::type_info<Component>::id(), typeid(Component).name(), true);
+	}
+
+	void _BuildGraph();
+	void _InstallHooks(entt::registry& registry);
+	void _RemoveHooks();
+	void _OnRegistryDestroyed();
+	void _ValidateAccess(entt::id_type type, const char* name, bool write);
+	void _RunSystem(entt::registry& registry, size_t system, int64_t frameStart);
+	void _RunChunks(size_t system, size_t count, size_t chunkSize, const std::function<void(size_t, size_t)>& func);
+	void _ComputeCriticalPath();
+};
+
+template <typename Component>
+void SystemContext::_CheckAccess() {
+	_scheduler._ValidateAccess(entt::type_info<std::decay_t<Component>>::id(), typeid(Component).name(), !std::is_const_v<Component>);
+}
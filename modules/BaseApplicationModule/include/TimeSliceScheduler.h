@@ -0,0 +1,138 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/// <summary>
+/// What a time sliced task wants to happen after running a step
+/// </summary>
+enum class TaskStep : uint8_t {
+	Continue, // The task has more work to do
+	Done      // The task has finished and will not be run again
+};
+
+/// <summary>
+/// How urgent a time sliced task is, higher priority tasks get the budget first
+/// </summary>
+enum class TaskPriority : uint8_t {
+	Low    = 0,
+	Normal = 1,
+	High   = 2
+};
+
+/// <summary>
+/// The body of a time sliced task. Each call should do a small, bounded amount of work and return whether there is
+/// more to do, with any progress captured in the callable, for instance:
+///
+///		[state = std::make_shared<State>()]() mutable {
+///			DoSomeOfTheWork(*state);
+///			return state->IsFinished ? TaskStep::Done : TaskStep::Continue;
+///		}
+/// </summary>
+typedef std::function<TaskStep()> TaskFunc;
+
+/// <summary>
+/// Identifies a scheduled task, stays safe to use after the task has finished
+/// </summary>
+struct TaskHandle {
+	uint32_t Index = ~0u;
+	uint32_t Generation = 0;
+};
+
+/// <summary>
+/// Spreads expensive work across frames. Tasks are run a step at a time within a per-frame time budget, so
+/// that work like regenerating a level or resizing buffers doesn't hitch the frame it was started on
+///
+/// Each Update, tasks are ordered by whether they are past their deadline, then priority, then how soon their
+/// deadline is, then the order they were scheduled in. Steps are run in that order until the budget is spent.
+/// The scheduler keeps a running average of how long each task's steps take, and won't start a step that is
+/// expected to overrun the budget, with two exceptions so that work is never starved: the first step of each
+/// Update always runs, and tasks past their deadline always get at least one step per Update
+///
+/// Deadlines are only hints, nothing is ever dropped for missing one. The scheduler is not thread safe, use one
+/// per thread that needs one (ex: one for the main thread and one for the render thread)
+/// </summary>
+class TimeSliceScheduler final {
+public:
+	/// <summary>
+	/// Results from the last call to Update, for tuning and display
+	/// </summary>
+	struct Stats {
+		float    UsedMs = 0.0f;  // How much of the budget was used
+		uint32_t Steps = 0;      // The number of steps that were run
+		uint32_t Completed = 0;  // The number of tasks that finished
+		uint32_t Pending = 0;    // The number of tasks still waiting after the update
+		uint32_t Overdue = 0;    // The number of pending tasks that are past their deadline
+	};
+
+	TimeSliceScheduler();
+	TimeSliceScheduler(const TimeSliceScheduler& other) = delete;
+	TimeSliceScheduler& operator =(const TimeSliceScheduler& other) = delete;
+	~TimeSliceScheduler() = default;
+
+	/// <summary>
+	/// Schedules a task, it's first step will run during the next Update
+	/// </summary>
+	/// <param name="name">The name of the task, for debugging</param>
+	/// <param name="func">The body of the task, invoked once per step</param>
+	/// <param name="priority">How urgent the task is</param>
+	/// <param name="deadlineSeconds">How long from now the task would like to be finished by, or 0 for no deadline</param>
+	/// <returns>A handle that can be used to cancel the task</returns>
+	TaskHandle Schedule(const std::string& name, TaskFunc func, TaskPriority priority = TaskPriority::Normal, float deadlineSeconds = 0.0f);
+	/// <summary>
+	/// Cancels a task, does nothing if it has already finished. Can be called from inside a step (including the
+	/// task's own)
+	/// </summary>
+	void Cancel(TaskHandle handle);
+	/// <summary>
+	/// Checks whether the task is still pending (ie. it has not finished and has not been cancelled)
+	/// </summary>
+	bool IsPending(TaskHandle handle) const;
+	/// <summary>
+	/// Cancels every pending task
+	/// </summary>
+	void CancelAll();
+
+	/// <summary>
+	/// Runs task steps until the budget is spent or there is nothing left to do
+	/// </summary>
+	/// <param name="budgetMs">How much time the steps may take this frame, in milliseconds</param>
+	void Update(float budgetMs);
+	/// <summary>
+	/// Runs every pending task to completion, ignoring the budget (ex: before saving or shutting down)
+	/// </summary>
+	void Flush();
+
+	/// <summary>
+	/// Gets the number of tasks that are still pending
+	/// </summary>
+	size_t Size() const { return _tasks.size() - _freeList.size(); }
+	const Stats& GetStats() const { return _stats; }
+
+private:
+	struct Task {
+		std::string  Name;
+		TaskFunc     Func;
+		TaskPriority Priority = TaskPriority::Normal;
+		// Absolute time in seconds, or 0 when there is no deadline
+		double       Deadline = 0.0;
+		uint64_t     Sequence = 0;
+		uint32_t     Generation = 0;
+		bool         IsAlive = false;
+		// A running average of how long the task's steps take, in milliseconds
+		float        AverageStepMs = 0.0f;
+		uint32_t     StepCount = 0;
+	};
+
+	std::vector<Task> _tasks;
+	std::vector<uint32_t> _freeList;
+	uint64_t _nextSequence;
+	Stats _stats;
+
+	// Scratch space for ordering the tasks each update
+	std::vector<uint32_t> _order;
+
+	bool _RunStep(uint32_t index);
+	void _Free(uint32_t index);
+};
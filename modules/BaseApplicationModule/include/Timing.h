@@ -1,4 +1,6 @@
 #pragma once
+#include <cmath>
+#include <cstdint>
 
 class Timing
 {
@@ -8,10 +10,51 @@ public:
 		return instance;
 	}
 
-	double CurrentFrame;
-	double LastFrame;
-	float  DeltaTime;
+	double CurrentFrame = 0.0;
+	double LastFrame = 0.0;
+	float  DeltaTime = 0.0f;
+
+	// The time between fixed updates, in seconds
+	float  FixedTimeStep = 1.0f / 50.0f;
+	// The most fixed updates we will run in a single frame. If a frame takes longer than this many steps, the extra
+	// time is dropped so that slow frames can't snowball into even slower ones
+	int    MaxFixedStepsPerFrame = 5;
+	// Time that has passed but not been simulated yet
+	double FixedAccumulator = 0.0;
+	// How far we are between the last fixed update and the next one (0 to 1), used to interpolate rendering
+	float  FixedAlpha = 0.0f;
+	// The total number of fixed updates so far
+	uint64_t FixedStepCount = 0;
+
+	/*
+	 * Sets the fixed update rate
+	 * @param ticksPerSecond The number of fixed updates per second
+	 */
+	void SetFixedRate(float ticksPerSecond) {
+		FixedTimeStep = 1.0f / ticksPerSecond;
+	}
+
+	/*
+	 * Adds this frame's DeltaTime to the accumulator and consumes as many whole fixed steps as fit (up to
+	 * MaxFixedStepsPerFrame), updating FixedAlpha with the remainder. Should be called once per frame
+	 * @returns The number of fixed updates to run this frame
+	 */
+	int ConsumeFixedSteps() {
+		FixedAccumulator += DeltaTime;
+		int steps = static_cast<int>(FixedAccumulator / FixedTimeStep);
+		if (steps > MaxFixedStepsPerFrame) {
+			steps = MaxFixedStepsPerFrame;
+		}
+		FixedAccumulator -= steps * static_cast<double>(FixedTimeStep);
+		// Spiral of death clamp, anything we couldn't get to this frame is dropped
+		if (FixedAccumulator >= FixedTimeStep) {
+			FixedAccumulator = std::fmod(FixedAccumulator, static_cast<double>(FixedTimeStep));
+		}
+		FixedAlpha = static_cast<float>(FixedAccumulator / FixedTimeStep);
+		FixedStepCount += steps;
+		return steps;
+	}
 
 protected:
 	Timing() = default;
-};
\ No newline at end of file
+};
@@ -4,45 +4,34 @@
 #include <GLM/glm.hpp>
 #include <GLM/gtc/quaternion.hpp>
 
+#include "TransformStore.h"
+
 /// <summary>
-/// A simple transformation class, without parent/child relationships
+/// A thin facade over a slot in the registry's TransformStore, which holds the actual transform data
+/// in structure-of-arrays form
 /// </summary>
 class Transform final
 {
 public:
-	struct TransformDirtyTag { };
-	
-	Transform(entt::handle gameObject) :
-		_isLocalDirty(true),
-		_localTransform(glm::mat4(1.0f)),
-		_normalMatrix(glm::mat3(1.0f)),
-		_isWorldDirty(true),
-		_worldTransform(glm::mat4(1.0f)),
-		_worldNormalMatrix(glm::mat3(1.0f)),
-		_rotation(glm::quat(1.0f, 0.0f, 0.0f, 0.0f)),
-		_rotationEulerDeg(glm::vec3(0.0f)),
-		_position(glm::vec3(0.0f)),
-		_scale(glm::vec3(1.0f)),
-		_parent(entt::null),
-		_gameObject(gameObject),
-		_hierarchyDepth(0)
-	{}
-	Transform(const Transform& other) = default;
+	Transform(entt::handle gameObject);
+	Transform(const Transform& other) = delete;
 	Transform(Transform&& other) = default;
-	Transform& operator =(const Transform & other) = default;
-	Transform& operator =(Transform && other) = default;
-	virtual ~Transform() = default;
+	Transform& operator =(const Transform& other) = delete;
+	Transform& operator =(Transform&& other) = default;
+	~Transform() = default;
 
 	// Rotation Getters/Setters
 
 	/// <summary>
 	/// Gets the local rotation of the transform in euler degrees
 	/// </summary>
-	const glm::vec3& GetLocalRotation() const { return _rotationEulerDeg; }
+	glm::vec3 GetLocalRotation() const { return _store->_eulerDeg[_index]; }
 	/// <summary>
 	/// Returns the local rotation as a quaternion
 	/// </summary>
-	const glm::quat& GetLocalRotationQuat() const { return _rotation; }
+	glm::quat GetLocalRotationQuat() const {
+		return glm::quat(_store->_rotW[_index], _store->_rotX[_index], _store->_rotY[_index], _store->_rotZ[_index]);
+	}
 	/// <summary>
 	/// Sets the local rotation of this transform to the given value in euler degrees
 	/// </summary>
@@ -69,7 +58,9 @@ public:
 	/// <summary>
 	/// Gets the local position of this transform
 	/// </summary>
-	const glm::vec3& GetLocalPosition() const { return _position; }
+	glm::vec3 GetLocalPosition() const {
+		return glm::vec3(_store->_posX[_index], _store->_posY[_index], _store->_posZ[_index]);
+	}
 	/// <summary>
 	/// Sets this transforms translation within it's local space
 	/// </summary>
@@ -90,7 +81,9 @@ public:
 	/// <summary>
 	/// Gets the local scale for this transform, along each axis
 	/// </summary>
-	const glm::vec3& GetLocalScale() const { return _scale; }
+	glm::vec3 GetLocalScale() const {
+		return glm::vec3(_store->_scaleX[_index], _store->_scaleY[_index], _store->_scaleZ[_index]);
+	}
 	/// <summary>
 	/// Sets this transforms scale within it's local space
 	/// </summary>
@@ -188,37 +181,75 @@ public:
 	/// </summary>
 	const glm::mat3& NormalMatrix() const;
 
+	/// <summary>
+	/// Sets the parent of this transform, or makes it a root if the handle is null
+	/// </summary>
+	/// <param name="parent">The new parent, must be in the same registry</param>
 	void SetParent(entt::handle parent);
+	/// <summary>
+	/// Gets the parent of this transform, the handle will be null if this is a root
+	/// </summary>
+	entt::handle GetParent() const;
 
+	/// <summary>
+	/// Invokes a callback for each of this transform's direct children
+	/// </summary>
+	/// <typeparam name="Func">A callable with the signature void(entt::handle child)</typeparam>
+	template <typename Func>
+	void EachChild(Func func) const {
+		for (uint32_t child = _store->GetFirstChild(_index); child != TransformStore::InvalidIndex; child = _store->GetNextSibling(child)) {
+			func(entt::handle(_gameObject.registry(), _store->GetEntity(child)));
+		}
+	}
+
+	/// <summary>
+	/// Re-calculates the world matrix for just this transform, assuming the parent is up to date. To update
+	/// the whole scene, use TransformStore::UpdateWorldMatrices
+	/// </summary>
 	void UpdateWorldMatrix() const;
 
-	const glm::mat4& WorldTransform() const { return _worldTransform; }
-	const glm::mat3& WorldNormalMatrix() const { return _worldNormalMatrix; };
+	const glm::mat4& WorldTransform() const { return _store->_world[_index]; }
+	/// <summary>
+	/// Gets the normal matrix for the world transform, calculating it if the transform has moved
+	/// </summary>
+	const glm::mat3& WorldNormalMatrix() const { return _store->_GetWorldNormal(_index); };
+	/// <summary>
+	/// Gets the inverse of the world transform, calculating it if the transform has moved
+	/// </summary>
+	const glm::mat4& WorldInverse() const { return _store->_GetWorldInverse(_index); }
+
+	/// <summary>
+	/// Gets the matrix to render with, interpolated between the last two fixed ticks if the transform moved
+	/// during the last tick (see TransformStore::Interpolate)
+	/// </summary>
+	const glm::mat4& RenderTransform() const { return _store->GetRenderMatrix(_index); }
+	/// <summary>
+	/// Gets the normal matrix to go with RenderTransform
+	/// </summary>
+	const glm::mat3& RenderNormalMatrix() const { return _store->GetRenderNormalMatrix(_index); }
+
+	/// <summary>
+	/// Returns true if this transform's world matrix changed during the last TransformStore::UpdateWorldMatrices
+	/// </summary>
+	bool HasChanged() const { return _store->_flags[_index] & TransformStore::Flag_Changed; }
 
 	/// <summary>
 	/// Gets the depth of this transform within the scene hierarchy (ie. how many parents
 	/// to the root)
 	/// </summary>
 	/// <returns></returns>
-	int GetHierarchyDepth() const { return _hierarchyDepth; }
+	int GetHierarchyDepth() const { return static_cast<int>(_store->GetDepth(_index)); }
+
+	/// <summary>
+	/// Gets the index of this transform's slot within the registry's TransformStore
+	/// </summary>
+	uint32_t GetStoreIndex() const { return _index; }
 
 private:
-	mutable bool _isLocalDirty;
-	mutable glm::mat4 _localTransform;
-	mutable glm::mat3 _normalMatrix;
-
-	mutable bool _isWorldDirty;
-	mutable glm::mat4 _worldTransform;
-	mutable glm::mat3 _worldNormalMatrix;
-	
-	glm::quat _rotation;
-	glm::vec3 _rotationEulerDeg;
-	glm::vec3 _position;
-	glm::vec3 _scale;
-
-	entt::entity _parent;
-	entt::handle _gameObject;
-	int _hierarchyDepth;
+	entt::handle    _gameObject;
+	TransformStore* _store;
+	uint32_t        _index;
 
+	void _SetRotation(const glm::quat& rotation);
 	void _UpdateLocalTransformIfDirty() const;
 };
@@ -0,0 +1,159 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <GLM/glm.hpp>
+#include <entt.hpp>
+
+#include "Scene.h"
+#include "SceneSerializer.h"
+
+/// <summary>
+/// Published on the EventBus from the loader thread when a cell has been read, before it's entities are created
+/// </summary>
+struct WorldCellLoadedEvent {
+	glm::ivec2 Cell = glm::ivec2(0);
+	bool IsOk = false;
+	uint64_t Bytes = 0; // The uncompressed size of the cell's data
+};
+
+/// <summary>
+/// Splits a world into a grid of cells, where each cell is a sub-scene saved with the SceneSerializer. Cells are
+/// loaded into the scene when the focus point (usually the camera) comes within the load radius, and removed again
+/// once it moves past the unload radius. Keeping the unload radius larger than the load radius stops cells on the
+/// boundary from being loaded and unloaded over and over
+///
+/// Reading and decompressing cells happens on a background thread, creating the entities happens on the main thread
+/// in Update, limited to a budget of entities per frame. Cells are created whole, so a single cell can go over the
+/// budget, cells should be kept smaller than the budget to keep frame times even
+///
+/// Cells are laid out on the XY plane, since Z is up in our scenes
+/// </summary>
+class WorldStreamer final {
+public:
+	typedef std::unique_ptr<WorldStreamer> uptr;
+
+	struct Settings {
+		// The width and height of each cell in world units
+		float    CellSize = 32.0f;
+		// Cells that come within this distance of the focus are loaded
+		float    LoadRadius = 64.0f;
+		// Resident cells that are further than this from the focus are unloaded, must be at least LoadRadius
+		float    UnloadRadius = 96.0f;
+		// The number of entities that can be created each frame (see the remarks above)
+		uint32_t EntityBudget = 512;
+	};
+
+	/// <summary>
+	/// Residency information, for displaying or for tuning the radii and budget
+	/// </summary>
+	struct Stats {
+		uint32_t Cells = 0;             // The number of cells that are registered
+		uint32_t Resident = 0;          // The number of cells with their entities in the scene
+		uint32_t Loading = 0;           // The number of cells being read on the background thread
+		uint32_t Waiting = 0;           // The number of cells that have been read, and are waiting on the budget
+		uint32_t ResidentEntities = 0;  // The number of entities owned by resident cells
+		uint32_t CreatedThisFrame = 0;  // The number of entities created in the last Update
+		uint32_t RemovedThisFrame = 0;  // The number of entities removed in the last Update
+		uint64_t TotalLoads = 0;        // The number of times a cell has been loaded
+		uint64_t TotalUnloads = 0;      // The number of times a cell has been unloaded
+		uint64_t ResidentBytes = 0;     // The uncompressed size of the resident cells' data
+	};
+
+	WorldStreamer(const GameScene::sptr& scene);
+	WorldStreamer(const GameScene::sptr& scene, const Settings& settings);
+	~WorldStreamer();
+
+	WorldStreamer(const WorldStreamer& other) = delete;
+	WorldStreamer(WorldStreamer&& other) = delete;
+	WorldStreamer& operator=(const WorldStreamer& other) = delete;
+	WorldStreamer& operator=(WorldStreamer&& other) = delete;
+
+	/// <summary>
+	/// Adds a cell that is loaded from a file saved with SceneSerializer::SaveToFile
+	/// </summary>
+	void AddCellFile(const glm::ivec2& cell, const std::string& path);
+	/// <summary>
+	/// Adds a cell that is loaded from data saved with SceneSerializer::SaveToString. Compressed data is best here,
+	/// since it stays in memory for as long as the streamer exists
+	/// </summary>
+	void AddCellData(const glm::ivec2& cell, std::string data);
+
+	/// <summary>
+	/// Moves entities that are already in the scene into cells based on their positions. The entities are saved
+	/// into cells, then removed from the scene (at the end of the frame) to be streamed back in as needed. Children
+	/// are saved in the same cell as their root
+	/// </summary>
+	/// <param name="entities">The root entities to move into cells</param>
+	/// <param name="directory">If not empty, cells are saved as files in this directory, otherwise they are kept in memory</param>
+	/// <returns>The number of cells that were created</returns>
+	size_t BakeCells(const std::vector<entt::entity>& entities, const std::string& directory = "");
+
+	/// <summary>
+	/// Streams cells in and out around the focus point, should be called once per frame from the main thread
+	/// </summary>
+	void Update(const glm::vec3& focus);
+	/// <summary>
+	/// Removes all the resident cells from the scene, and cancels any loads that are in flight
+	/// </summary>
+	void UnloadAll();
+
+	/// <summary>
+	/// Gets the cell that a world position falls into
+	/// </summary>
+	glm::ivec2 GetCell(const glm::vec3& position) const;
+	/// <summary>
+	/// Checks whether a cell's entities are in the scene
+	/// </summary>
+	bool IsResident(const glm::ivec2& cell) const;
+
+	const Settings& GetSettings() const { return _settings; }
+	void SetSettings(const Settings& settings);
+	const Stats& GetStats() const { return _stats; }
+
+private:
+	struct Loader;
+
+	enum class CellState {
+		Unloaded,
+		Loading,  // Being read on the loader thread
+		Waiting,  // Read, waiting to be created in the scene
+		Resident
+	};
+
+	// A cell can be made up of several saved parts (ex: if it was baked more than once)
+	struct Part {
+		std::string Path;                        // The file to load from, if this part is not stored in memory
+		std::shared_ptr<const std::string> Data; // The saved part, if it is stored in memory
+	};
+
+	struct Cell {
+		glm::ivec2 Coord;
+		std::vector<Part> Parts;
+		CellState State = CellState::Unloaded;
+		bool Failed = false;             // Set if the cell could not be read, so we don't keep retrying it
+		uint32_t Request = 0;            // Identifies the latest load, so results from cancelled loads can be ignored
+		std::vector<std::string> Loaded; // The uncompressed parts, while Waiting
+		size_t Bytes = 0;                // The uncompressed size of the parts, once they have been read
+		std::vector<entt::entity> Entities;
+	};
+
+	GameScene::sptr _scene;
+	Settings _settings;
+	Stats _stats;
+	std::unordered_map<uint64_t, Cell> _cells;
+	// The cells that are not unloaded, so we don't need to look at every cell each frame
+	std::vector<uint64_t> _active;
+	std::unique_ptr<Loader> _loader;
+	uint32_t _nextRequest;
+
+	static uint64_t _Key(const glm::ivec2& cell);
+	Cell& _AddCell(const glm::ivec2& cell);
+	float _DistanceToCell(const glm::vec2& focus, const glm::ivec2& cell) const;
+	void _RequestLoad(uint64_t key, Cell& cell);
+	void _Unload(Cell& cell);
+	void _CollectLoaded();
+	void _RefreshStats();
+};
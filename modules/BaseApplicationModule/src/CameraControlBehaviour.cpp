@@ -3,6 +3,7 @@
 #include "Application.h"
 #include "Timing.h"
 #include "Transform.h"
+#include "InputSystem.h"
 
 
 void CameraControlBehaviour::OnLoad(entt::handle entity) {
@@ -11,13 +12,14 @@ void CameraControlBehaviour::OnLoad(entt::handle entity) {
 
 void CameraControlBehaviour::Update(entt::handle entity)
 {
-	float dt = Timing::Instance().DeltaTime;
+	float dt = GetDeltaTime();
 	GLFWwindow* window = Application::Instance().Window;
-	double mx, my;
-	glfwGetCursorPos(window, &mx, &my);
+	const InputSnapshot& input = InputSystem::Current();
+	const double mx = input.MousePosition.x;
+	const double my = input.MousePosition.y;
 	Transform& transform = entity.get<Transform>();
 
-	if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_2) == GLFW_PRESS) {
+	if (input.IsMouseDown(GLFW_MOUSE_BUTTON_2)) {
 		if (!_isPressed) {
 			glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 			_isPressed = true;
@@ -39,32 +41,32 @@ void CameraControlBehaviour::Update(entt::handle entity)
 	}
 
 	glm::vec3 movement = glm::vec3(0.0f);
-	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+	if (input.IsKeyDown(GLFW_KEY_A)) {
 		movement.x += -_moveSpeed * dt;
 	}
-	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+	if (input.IsKeyDown(GLFW_KEY_D)) {
 		movement.x += _moveSpeed * dt;
 	}
-	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+	if (input.IsKeyDown(GLFW_KEY_W)) {
 		movement.z += -_moveSpeed * dt;
 	}
-	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+	if (input.IsKeyDown(GLFW_KEY_S)) {
 		movement.z += _moveSpeed * dt;
 	}
-	if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
+	if (input.IsKeyDown(GLFW_KEY_SPACE)) {
 		movement.y += _moveSpeed * dt;
 	}
-	if (glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS) {
+	if (input.IsKeyDown(GLFW_KEY_LEFT_CONTROL)) {
 		movement.y += -_moveSpeed * dt;
 	}
-	if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS) {
+	if (input.IsKeyDown(GLFW_KEY_Q)) {
 		movement.y += -_moveSpeed * dt;
 	}
-	if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS) {
+	if (input.IsKeyDown(GLFW_KEY_E)) {
 		movement.y += _moveSpeed * dt;
 	}
 
-	if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT)) {
+	if (input.IsKeyDown(GLFW_KEY_LEFT_SHIFT)) {
 		movement *= 2.f;
 	}
 	transform.MoveLocal(movement);
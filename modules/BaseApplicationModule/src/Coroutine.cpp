@@ -0,0 +1,218 @@
+#include "Coroutine.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "InputSystem.h"
+#include "Timing.h"
+
+CoroutineScheduler::CoroutineScheduler(entt::registry& registry) :
+	_registry(&registry),
+	_routines(std::vector<Routine>()),
+	_freeList(std::vector<uint32_t>()),
+	_nextFrame(std::vector<Entry>()),
+	_timerTick(0),
+	_fixedTick(0),
+	_keyWaiters(std::unordered_map<int, std::vector<Entry>>()),
+	_resuming(std::vector<Entry>())
+{
+	_timerTick = _CurrentTimerTick();
+}
+
+CoroutineScheduler::~CoroutineScheduler() {
+	for (Routine& routine : _routines) {
+		if (routine.Handle) {
+			routine.Handle.destroy();
+		}
+	}
+}
+
+CoroutineScheduler& CoroutineScheduler::Get(entt::registry& registry) {
+	return registry.ctx_or_set<CoroutineScheduler>(registry);
+}
+
+CoroutineHandle CoroutineScheduler::Start(entt::handle entity, Coroutine coroutine) {
+	if (!coroutine._handle) {
+		return CoroutineHandle();
+	}
+
+	uint32_t index;
+	if (!_freeList.empty()) {
+		index = _freeList.back();
+		_freeList.pop_back();
+	} else {
+		index = static_cast<uint32_t>(_routines.size());
+		_routines.emplace_back();
+	}
+
+	Routine& routine = _routines[index];
+	routine.Handle = std::exchange(coroutine._handle, nullptr);
+	routine.Entity = entity.entity();
+	routine.IsAlive = true;
+	routine.DueTick = 0;
+
+	const CoroutineHandle result = { index, routine.Generation };
+	_Resume({ index, routine.Generation });
+	return result;
+}
+
+void CoroutineScheduler::Stop(CoroutineHandle handle) {
+	if (IsRunning(handle)) {
+		_Free(handle.Index);
+	}
+}
+
+bool CoroutineScheduler::IsRunning(CoroutineHandle handle) const {
+	return handle.Index < _routines.size() && _IsCurrent({ handle.Index, handle.Generation });
+}
+
+void CoroutineScheduler::Update() {
+	// Routines that resume now and wait on the next frame go back into _nextFrame, so swap it out first
+	_resuming.clear();
+	std::swap(_resuming, _nextFrame);
+	for (size_t ix = 0; ix < _resuming.size(); ix++) {
+		_Resume(_resuming[ix]);
+	}
+
+	_AdvanceWheel(_timerWheel, _timerTick, _CurrentTimerTick());
+
+	// We only check the keys that something is waiting on. The waiters are pulled out before resuming anything, so
+	// routines that wait on the same key again are queued for the next press, not this one
+	if (!_keyWaiters.empty()) {
+		const InputSnapshot& input = InputSystem::Current();
+		_resuming.clear();
+		for (auto it = _keyWaiters.begin(); it != _keyWaiters.end();) {
+			if (input.WasKeyPressed(it->first)) {
+				_resuming.insert(_resuming.end(), it->second.begin(), it->second.end());
+				it = _keyWaiters.erase(it);
+			} else {
+				++it;
+			}
+		}
+		for (size_t ix = 0; ix < _resuming.size(); ix++) {
+			_Resume(_resuming[ix]);
+		}
+	}
+}
+
+void CoroutineScheduler::FixedTick() {
+	_AdvanceWheel(_fixedWheel, _fixedTick, _fixedTick + 1);
+}
+
+void CoroutineScheduler::_Resume(Entry entry) {
+	if (!_IsCurrent(entry)) {
+		return;
+	}
+
+	// The owning entity may have been destroyed while we were suspended
+	const entt::entity entity = _routines[entry.Index].Entity;
+	if (!_registry->valid(entity)) {
+		_Free(entry.Index);
+		return;
+	}
+
+	// The routine may start other routines (re-allocating our storage) or stop itself, so we resume it from a local,
+	// and it's frame is only destroyed once it has suspended again
+	const Coroutine::Handle handle = _routines[entry.Index].Handle;
+	_routines[entry.Index].Handle = nullptr;
+	handle.resume();
+	if (_IsCurrent(entry) && !handle.done()) {
+		_routines[entry.Index].Handle = handle;
+		_Schedule(entry.Index, handle.promise().Pending);
+		return;
+	}
+
+	if (_IsCurrent(entry)) {
+		_Free(entry.Index);
+	}
+	const std::exception_ptr exception = handle.promise().Exception;
+	handle.destroy();
+	if (exception) {
+		std::rethrow_exception(exception);
+	}
+}
+
+void CoroutineScheduler::_Schedule(uint32_t index, const Await& await) {
+	Routine& routine = _routines[index];
+	const Entry entry = { index, routine.Generation };
+	switch (await.Kind) {
+		case Await::Type::NextFrame:
+			_nextFrame.push_back(entry);
+			break;
+		case Await::Type::Seconds:
+		{
+			// Always wait at least until the next timer tick, so a zero second wait can't resume twice in a frame
+			const double due = (Timing::Instance().CurrentFrame + static_cast<double>(await.Duration)) * TimerResolution;
+			routine.DueTick = std::max(static_cast<uint64_t>(std::ceil(due)), _timerTick + 1);
+			_timerWheel[routine.DueTick % WheelSize].push_back(entry);
+			break;
+		}
+		case Await::Type::FixedTick:
+			routine.DueTick = _fixedTick + std::max<uint32_t>(await.Ticks, 1);
+			_fixedWheel[routine.DueTick % WheelSize].push_back(entry);
+			break;
+		case Await::Type::KeyPress:
+		{
+			_keyWaiters[await.Key].push_back(entry);
+			break;
+		}
+		default:
+			_Free(index);
+			break;
+	}
+}
+
+void CoroutineScheduler::_Free(uint32_t index) {
+	Routine& routine = _routines[index];
+	const Coroutine::Handle handle = routine.Handle;
+	routine.Handle = nullptr;
+	routine.Entity = entt::null;
+	routine.IsAlive = false;
+	// Bumping the generation invalidates any handles and wait list entries that still point at this slot
+	routine.Generation++;
+	_freeList.push_back(index);
+	// Destroying the frame runs the destructors of the routine's locals, so we do it once the slot is free
+	if (handle) {
+		handle.destroy();
+	}
+}
+
+void CoroutineScheduler::_AdvanceWheel(std::vector<Entry>* wheel, uint64_t& current, uint64_t target) {
+	if (target <= current) {
+		return;
+	}
+
+	// If we jumped further than one turn of the wheel, we only need to visit each slot once
+	const uint64_t first = (target - current > WheelSize) ? target - WheelSize + 1 : current + 1;
+	current = target;
+	for (uint64_t tick = first; tick <= target; tick++) {
+		std::vector<Entry>& slot = wheel[tick % WheelSize];
+		if (slot.empty()) {
+			continue;
+		}
+
+		_resuming.clear();
+		std::swap(_resuming, slot);
+		for (size_t ix = 0; ix < _resuming.size(); ix++) {
+			const Entry entry = _resuming[ix];
+			if (!_IsCurrent(entry)) {
+				continue;
+			}
+			// Entries that are due on a later turn of the wheel stay where they are
+			if (_routines[entry.Index].DueTick > target) {
+				slot.push_back(entry);
+			} else {
+				_Resume(entry);
+			}
+		}
+	}
+}
+
+bool CoroutineScheduler::_IsCurrent(Entry entry) const {
+	const Routine& routine = _routines[entry.Index];
+	return routine.IsAlive && routine.Generation == entry.Generation;
+}
+
+uint64_t CoroutineScheduler::_CurrentTimerTick() const {
+	return static_cast<uint64_t>(Timing::Instance().CurrentFrame * TimerResolution);
+}
@@ -0,0 +1,72 @@
+#include "EventBus.h"
+
+#include "LoggingBase.h"
+
+struct EventBus::State {
+	// Guards registering channels. Channels are published to the list with Count, so it can be read without the lock
+	std::mutex Mutex;
+	std::vector<std::unique_ptr<IChannel>> Owned;
+	std::atomic<IChannel*> Channels[MaxChannels] = {};
+	std::atomic<uint32_t> Count = 0;
+
+	IChannel* Get(uint32_t id) {
+		return id < Count.load(std::memory_order_acquire) ? Channels[id].load(std::memory_order_acquire) : nullptr;
+	}
+};
+
+EventBus::State& EventBus::_GetState() {
+	static State state;
+	return state;
+}
+
+void EventBus::Unsubscribe(EventSubscription subscription) {
+	IChannel* channel = _GetState().Get(subscription.Channel);
+	if (channel != nullptr) {
+		channel->Unsubscribe(subscription.Index, subscription.Generation);
+	}
+}
+
+bool EventBus::IsSubscribed(EventSubscription subscription) {
+	IChannel* channel = _GetState().Get(subscription.Channel);
+	return channel != nullptr && channel->IsSubscribed(subscription.Index, subscription.Generation);
+}
+
+void EventBus::Dispatch(EventPhase phase) {
+	State& state = _GetState();
+	// Channels registered by the handlers have nothing to deliver yet, so we only go up to the count we started with
+	const uint32_t count = state.Count.load(std::memory_order_acquire);
+	for (uint32_t ix = 0; ix < count; ix++) {
+		state.Channels[ix].load(std::memory_order_acquire)->Dispatch(phase);
+	}
+}
+
+void EventBus::Clear() {
+	State& state = _GetState();
+	const uint32_t count = state.Count.load(std::memory_order_acquire);
+	for (uint32_t ix = 0; ix < count; ix++) {
+		state.Channels[ix].load(std::memory_order_acquire)->Clear();
+	}
+}
+
+EventBus::Stats EventBus::GetStats() {
+	State& state = _GetState();
+	Stats result;
+	result.Channels = state.Count.load(std::memory_order_acquire);
+	for (uint32_t ix = 0; ix < result.Channels; ix++) {
+		state.Channels[ix].load(std::memory_order_acquire)->AddStats(result);
+	}
+	return result;
+}
+
+EventBus::IChannel* EventBus::_Register(std::unique_ptr<IChannel>&& channel) {
+	State& state = _GetState();
+	std::lock_guard<std::mutex> lock(state.Mutex);
+	const uint32_t id = state.Count.load(std::memory_order_relaxed);
+	LOG_ASSERT(id < MaxChannels, "Too many event types, increase EventBus::MaxChannels");
+	channel->Id = id;
+	IChannel* result = channel.get();
+	state.Owned.push_back(std::move(channel));
+	state.Channels[id].store(result, std::memory_order_release);
+	state.Count.store(id + 1, std::memory_order_release);
+	return result;
+}
@@ -1,20 +1,40 @@
 #include "FollowPathBehaviour.h"
 
+#include <algorithm>
 #include "Timing.h"
 #include <Transform.h>
 
-void FollowPathBehaviour::Update(entt::handle entity) {
-	if (Points.size() >= 2) {
-		Transform& transform = entity.get<Transform>();
+void FollowPathBehaviour::OnLoad(entt::handle entity) {
+	static uint32_t nextRoutineId = 0;
+	_routineId = ++nextRoutineId;
+	StartCoroutine(entity, _FollowPath(entity, _routineId));
+}
 
-		const glm::vec3 next = Points[_nextPointIx];
+Coroutine FollowPathBehaviour::_FollowPath(entt::handle entity, uint32_t routineId) {
+	uint32_t interval = 1;
+	while (true) {
+		co_await FixedTicks(interval);
+
+		// Behaviours can move around in memory while we're waiting, so we look ourselves up after every wait
+		FollowPathBehaviour* self = BehaviourBinding::Get<FollowPathBehaviour>(entity);
+		if (self == nullptr || self->_routineId != routineId) {
+			co_return;
+		}
+		const float dt = Timing::Instance().FixedTimeStep * interval;
+		interval = std::max<uint32_t>(self->Rate.Interval, 1);
+		if (!self->Enabled || self->Points.size() < 2) {
+			continue;
+		}
+
+		Transform& transform = entity.get<Transform>();
+		const glm::vec3 next = self->Points[self->_nextPointIx];
 		const glm::vec3 direction = glm::normalize(next - transform.GetLocalPosition());
 		//transform.LookAt(next);
-		transform.MoveLocalFixed(direction * Speed * Timing::Instance().DeltaTime);
-		if (glm::distance(transform.GetLocalPosition(), next) < Speed * Timing::Instance().DeltaTime) {
-			_nextPointIx++;
-			if (_nextPointIx >= Points.size()) {
-				_nextPointIx = 0;
+		transform.MoveLocalFixed(direction * self->Speed * dt);
+		if (glm::distance(transform.GetLocalPosition(), next) < self->Speed * dt) {
+			self->_nextPointIx++;
+			if (self->_nextPointIx >= self->Points.size()) {
+				self->_nextPointIx = 0;
 			}
 		}
 	}
@@ -1,23 +1,23 @@
 #include "InputHelpers.h"
-#include <GLFW/glfw3.h>
 
-KeyPressWatcher::KeyPressWatcher(int keycode, const std::function<void()>& onPressed) {
-	_isPressed = false;
-	_keyCode = keycode;
-	_onPressed = onPressed;
+KeyPressWatcher::KeyPressWatcher(entt::handle owner, int keycode, const std::function<void()>& onPressed) :
+	_owner(owner),
+	_routine(CoroutineScheduler::Get(owner.registry()).Start(owner, _Watch(keycode, onPressed)))
+{ }
+
+void KeyPressWatcher::Stop() {
+	CoroutineScheduler::Get(_owner.registry()).Stop(_routine);
+}
+
+bool KeyPressWatcher::IsWatching() const {
+	return CoroutineScheduler::Get(_owner.registry()).IsRunning(_routine);
 }
 
-bool KeyPressWatcher::Poll(GLFWwindow* window) const {
-	if (glfwGetKey(window, _keyCode) == GLFW_PRESS) {
-		if (!_isPressed) {
-			_isPressed = true;
-			if (_onPressed) {
-				_onPressed();
-			}
+Coroutine KeyPressWatcher::_Watch(int keycode, std::function<void()> onPressed) {
+	while (true) {
+		co_await KeyPressed(keycode);
+		if (onPressed) {
+			onPressed();
 		}
-		return false;
-	} else {
-		_isPressed = false;
 	}
-	return false;
 }
@@ -0,0 +1,343 @@
+#include "InputSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <GLFW/glfw3.h>
+
+#include "Timing.h"
+
+static_assert(GLFW_KEY_LAST < InputSnapshot::KeyCount, "InputSnapshot::KeyCount is too small for GLFW's keys");
+static_assert(GLFW_MOUSE_BUTTON_LAST < InputSnapshot::MouseButtonCount, "InputSnapshot::MouseButtonCount is too small for GLFW's buttons");
+
+InputSnapshot InputSystem::_current;
+std::vector<InputEvent> InputSystem::_pending;
+std::vector<InputSystem::Action> InputSystem::_actions;
+std::unordered_map<std::string, InputAction> InputSystem::_actionLookup;
+
+bool InputSystem::_isRecording = false;
+InputRecording InputSystem::_recording;
+bool InputSystem::_isReplaying = false;
+InputRecording InputSystem::_replay;
+size_t InputSystem::_replayFrame = 0;
+
+// The callbacks that were installed before ours, we still forward events to them (ex: ImGui)
+static GLFWkeyfun         s_prevKeyCallback = nullptr;
+static GLFWmousebuttonfun s_prevMouseButtonCallback = nullptr;
+static GLFWcursorposfun   s_prevCursorPosCallback = nullptr;
+static GLFWscrollfun      s_prevScrollCallback = nullptr;
+static GLFWcharfun        s_prevCharCallback = nullptr;
+
+// Tag and version for recordings saved to disk
+static constexpr uint32_t RecordingMagic = 0x43455249; // IREC
+static constexpr uint32_t RecordingVersion = 2;
+
+void InputSystem::Init(GLFWwindow* window) {
+	s_prevKeyCallback = glfwSetKeyCallback(window, _KeyCallback);
+	s_prevMouseButtonCallback = glfwSetMouseButtonCallback(window, _MouseButtonCallback);
+	s_prevCursorPosCallback = glfwSetCursorPosCallback(window, _CursorPosCallback);
+	s_prevScrollCallback = glfwSetScrollCallback(window, _ScrollCallback);
+	s_prevCharCallback = glfwSetCharCallback(window, _CharCallback);
+
+	// Start from where the cursor actually is, so the first frame doesn't report a huge mouse delta
+	double x, y;
+	glfwGetCursorPos(window, &x, &y);
+	_current.MousePosition = glm::vec2(static_cast<float>(x), static_cast<float>(y));
+}
+
+void InputSystem::BeginFrame() {
+	InputSnapshot& state = _current;
+	state._keysPressed.reset();
+	state._keysReleased.reset();
+	state._mousePressed.reset();
+	state._mouseReleased.reset();
+	state.Characters.clear();
+	state.Scroll = glm::vec2(0.0f);
+	const glm::vec2 prevMouse = state.MousePosition;
+
+	// Live input picks up again on the frame after the replay runs out
+	if (_isReplaying && _replayFrame >= _replay.Frames.size()) {
+		StopReplay();
+	}
+
+	if (_isReplaying) {
+		// Live input is dropped while we replay
+		_pending.clear();
+		const InputRecording::Frame& frame = _replay.Frames[_replayFrame++];
+		for (uint32_t ix = 0; ix < frame.EventCount; ix++) {
+			_ApplyEvent(_replay.Events[frame.FirstEvent + ix]);
+		}
+		Timing::Instance().DeltaTime = frame.DeltaTime;
+	} else {
+		for (const InputEvent& event : _pending) {
+			_ApplyEvent(event);
+		}
+	}
+
+	if (_isRecording) {
+		InputRecording::Frame frame;
+		frame.DeltaTime = Timing::Instance().DeltaTime;
+		frame.FirstEvent = static_cast<uint32_t>(_recording.Events.size());
+		frame.EventCount = static_cast<uint32_t>(_pending.size());
+		_recording.Frames.push_back(frame);
+		_recording.Events.insert(_recording.Events.end(), _pending.begin(), _pending.end());
+	}
+	_pending.clear();
+
+	state.MouseDelta = state.MousePosition - prevMouse;
+
+	// Resolve the actions, an action is held if any of it's bindings are held
+	state._actions.resize(_actions.size(), 0);
+	for (size_t ix = 0; ix < _actions.size(); ix++) {
+		bool isHeld = false;
+		for (const InputBinding& binding : _actions[ix].Bindings) {
+			isHeld |= binding.Source == InputBinding::Device::Key ? state.IsKeyDown(binding.Code) : state.IsMouseDown(binding.Code);
+		}
+		const bool wasHeld = state._actions[ix] & InputSnapshot::Action_Held;
+		uint8_t flags = isHeld ? InputSnapshot::Action_Held : 0;
+		if (isHeld && !wasHeld) flags |= InputSnapshot::Action_Pressed;
+		if (!isHeld && wasHeld) flags |= InputSnapshot::Action_Released;
+		// A binding that was tapped within the frame never shows as held, but should still count as a press
+		for (const InputBinding& binding : _actions[ix].Bindings) {
+			if (binding.Source == InputBinding::Device::Key ? state.WasKeyPressed(binding.Code) : state.WasMousePressed(binding.Code)) {
+				flags |= InputSnapshot::Action_Pressed;
+			}
+		}
+		state._actions[ix] = flags;
+	}
+
+	state.Frame++;
+}
+
+void InputSystem::PushEvent(const InputEvent& event) {
+	_pending.push_back(event);
+}
+
+InputAction InputSystem::MapAction(const std::string& name, const InputBinding& binding) {
+	InputAction action = GetAction(name);
+	if (action == InvalidAction) {
+		action = static_cast<InputAction>(_actions.size());
+		_actions.push_back({ name, std::vector<InputBinding>() });
+		_actionLookup[name] = action;
+	}
+	_actions[action].Bindings.push_back(binding);
+	return action;
+}
+
+InputAction InputSystem::GetAction(const std::string& name) {
+	auto it = _actionLookup.find(name);
+	return it != _actionLookup.end() ? it->second : InvalidAction;
+}
+
+void InputSystem::ClearAction(InputAction action) {
+	if (action < _actions.size()) {
+		_actions[action].Bindings.clear();
+	}
+}
+
+void InputSystem::StartRecording() {
+	_recording = InputRecording();
+	_isRecording = true;
+
+	// Anything already held is where the replay starts from, it isn't part of the first frame's events since that
+	// would show up as presses that never happened
+	_recording.InitialState.push_back(InputEvent::CursorMove(_current.MousePosition.x, _current.MousePosition.y));
+	for (int key = 0; key < InputSnapshot::KeyCount; key++) {
+		if (_current._keysHeld[key]) {
+			_recording.InitialState.push_back(InputEvent::Key(key, true));
+		}
+	}
+	for (int button = 0; button < InputSnapshot::MouseButtonCount; button++) {
+		if (_current._mouseHeld[button]) {
+			_recording.InitialState.push_back(InputEvent::MouseButton(button, true));
+		}
+	}
+}
+
+InputRecording InputSystem::StopRecording() {
+	_isRecording = false;
+	InputRecording result = std::move(_recording);
+	_recording = InputRecording();
+	return result;
+}
+
+void InputSystem::StartReplay(const InputRecording& recording) {
+	_replay = recording;
+	_replayFrame = 0;
+	_isReplaying = !_replay.Frames.empty();
+	_ResetState();
+	if (!_isReplaying) {
+		return;
+	}
+
+	// Start from what was held when the recording started. Actions that were held need to stay held as well, or
+	// the first frame would see them as pressed
+	for (const InputEvent& event : _replay.InitialState) {
+		_RestoreState(event);
+	}
+	_current._actions.resize(_actions.size(), 0);
+	for (size_t ix = 0; ix < _actions.size(); ix++) {
+		bool isHeld = false;
+		for (const InputBinding& binding : _actions[ix].Bindings) {
+			isHeld |= binding.Source == InputBinding::Device::Key ? _current.IsKeyDown(binding.Code) : _current.IsMouseDown(binding.Code);
+		}
+		_current._actions[ix] = isHeld ? InputSnapshot::Action_Held : 0;
+	}
+}
+
+void InputSystem::StopReplay() {
+	if (_isReplaying) {
+		_isReplaying = false;
+		_replay = InputRecording();
+		_replayFrame = 0;
+		// Whatever the replay left held doesn't match what the user is actually doing
+		_ResetState();
+	}
+}
+
+void InputSystem::_ApplyEvent(const InputEvent& event) {
+	InputSnapshot& state = _current;
+	switch (event.Kind) {
+		case InputEvent::Type::Key:
+			if (InputSnapshot::_IsValidKey(event.Code)) {
+				if (event.IsDown && !state._keysHeld[event.Code]) {
+					state._keysPressed.set(event.Code);
+				} else if (!event.IsDown && state._keysHeld[event.Code]) {
+					state._keysReleased.set(event.Code);
+				}
+				state._keysHeld.set(event.Code, event.IsDown);
+			}
+			break;
+		case InputEvent::Type::MouseButton:
+			if (InputSnapshot::_IsValidButton(event.Code)) {
+				if (event.IsDown && !state._mouseHeld[event.Code]) {
+					state._mousePressed.set(event.Code);
+				} else if (!event.IsDown && state._mouseHeld[event.Code]) {
+					state._mouseReleased.set(event.Code);
+				}
+				state._mouseHeld.set(event.Code, event.IsDown);
+			}
+			break;
+		case InputEvent::Type::CursorMove:
+			state.MousePosition = glm::vec2(event.X, event.Y);
+			break;
+		case InputEvent::Type::Scroll:
+			state.Scroll += glm::vec2(event.X, event.Y);
+			break;
+		case InputEvent::Type::Char:
+			state.Characters.push_back(static_cast<uint32_t>(event.Code));
+			break;
+		default:
+			break;
+	}
+}
+
+void InputSystem::_RestoreState(const InputEvent& event) {
+	switch (event.Kind) {
+		case InputEvent::Type::Key:
+			if (InputSnapshot::_IsValidKey(event.Code)) {
+				_current._keysHeld.set(event.Code, event.IsDown);
+			}
+			break;
+		case InputEvent::Type::MouseButton:
+			if (InputSnapshot::_IsValidButton(event.Code)) {
+				_current._mouseHeld.set(event.Code, event.IsDown);
+			}
+			break;
+		case InputEvent::Type::CursorMove:
+			_current.MousePosition = glm::vec2(event.X, event.Y);
+			break;
+		default:
+			break;
+	}
+}
+
+void InputSystem::_ResetState() {
+	_current._keysHeld.reset();
+	_current._mouseHeld.reset();
+	std::fill(_current._actions.begin(), _current._actions.end(), 0);
+}
+
+void InputSystem::_KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+	// Repeats don't change the state of the key
+	if (action != GLFW_REPEAT) {
+		_pending.push_back(InputEvent::Key(key, action == GLFW_PRESS));
+	}
+	if (s_prevKeyCallback) {
+		s_prevKeyCallback(window, key, scancode, action, mods);
+	}
+}
+
+void InputSystem::_MouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
+	_pending.push_back(InputEvent::MouseButton(button, action == GLFW_PRESS));
+	if (s_prevMouseButtonCallback) {
+		s_prevMouseButtonCallback(window, button, action, mods);
+	}
+}
+
+void InputSystem::_CursorPosCallback(GLFWwindow* window, double x, double y) {
+	_pending.push_back(InputEvent::CursorMove(static_cast<float>(x), static_cast<float>(y)));
+	if (s_prevCursorPosCallback) {
+		s_prevCursorPosCallback(window, x, y);
+	}
+}
+
+void InputSystem::_ScrollCallback(GLFWwindow* window, double x, double y) {
+	_pending.push_back(InputEvent::Scroll(static_cast<float>(x), static_cast<float>(y)));
+	if (s_prevScrollCallback) {
+		s_prevScrollCallback(window, x, y);
+	}
+}
+
+void InputSystem::_CharCallback(GLFWwindow* window, unsigned int codepoint) {
+	_pending.push_back(InputEvent::Char(codepoint));
+	if (s_prevCharCallback) {
+		s_prevCharCallback(window, codepoint);
+	}
+}
+
+bool InputRecording::SaveToFile(const std::string& path) const {
+	FILE* file = fopen(path.c_str(), "wb");
+	if (file == nullptr) {
+		return false;
+	}
+	const uint32_t header[5] = { RecordingMagic, RecordingVersion, static_cast<uint32_t>(InitialState.size()), static_cast<uint32_t>(Frames.size()), static_cast<uint32_t>(Events.size()) };
+	bool result = fwrite(header, sizeof(header), 1, file) == 1;
+	if (!InitialState.empty()) result &= fwrite(InitialState.data(), sizeof(InputEvent), InitialState.size(), file) == InitialState.size();
+	if (!Frames.empty()) result &= fwrite(Frames.data(), sizeof(Frame), Frames.size(), file) == Frames.size();
+	if (!Events.empty()) result &= fwrite(Events.data(), sizeof(InputEvent), Events.size(), file) == Events.size();
+	fclose(file);
+	return result;
+}
+
+bool InputRecording::LoadFromFile(const std::string& path, InputRecording& result) {
+	FILE* file = fopen(path.c_str(), "rb");
+	if (file == nullptr) {
+		return false;
+	}
+	// The counts come from the file, so we make sure the file actually holds that much before allocating anything
+	const long fileSize = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+	uint32_t header[5];
+	bool success = fileSize >= 0 && fseek(file, 0, SEEK_SET) == 0 &&
+		fread(header, sizeof(header), 1, file) == 1 && header[0] == RecordingMagic && header[1] == RecordingVersion &&
+		static_cast<uint64_t>(fileSize) == sizeof(header) + (uint64_t(header[2]) + header[4]) * sizeof(InputEvent) + uint64_t(header[3]) * sizeof(Frame);
+	if (success) {
+		result.InitialState.resize(header[2]);
+		result.Frames.resize(header[3]);
+		result.Events.resize(header[4]);
+		if (!result.InitialState.empty()) success &= fread(result.InitialState.data(), sizeof(InputEvent), result.InitialState.size(), file) == result.InitialState.size();
+		if (!result.Frames.empty()) success &= fread(result.Frames.data(), sizeof(Frame), result.Frames.size(), file) == result.Frames.size();
+		if (!result.Events.empty()) success &= fread(result.Events.data(), sizeof(InputEvent), result.Events.size(), file) == result.Events.size();
+	}
+	fclose(file);
+
+	// Replaying doesn't check the frames, so every frame's events have to be in the recording
+	for (size_t ix = 0; success && ix < result.Frames.size(); ix++) {
+		const Frame& frame = result.Frames[ix];
+		success = uint64_t(frame.FirstEvent) + frame.EventCount <= result.Events.size() && std::isfinite(frame.DeltaTime) && frame.DeltaTime >= 0.0f;
+	}
+	if (!success) {
+		result = InputRecording();
+	}
+	return success;
+}
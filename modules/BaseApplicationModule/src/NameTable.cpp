@@ -0,0 +1,56 @@
+#include "NameTable.h"
+
+NameTable::NameTable() :
+	_strings(std::deque<std::string>()),
+	_lookup(std::unordered_map<std::string_view, NameId>()),
+	_mutex()
+{
+	_strings.emplace_back();
+	_lookup[_strings.back()] = Empty;
+}
+
+NameTable& NameTable::_Instance() {
+	static NameTable instance;
+	return instance;
+}
+
+NameId NameTable::Intern(std::string_view name) {
+	NameTable& table = _Instance();
+	{
+		std::shared_lock<std::shared_mutex> lock(table._mutex);
+		auto it = table._lookup.find(name);
+		if (it != table._lookup.end()) {
+			return it->second;
+		}
+	}
+
+	std::unique_lock<std::shared_mutex> lock(table._mutex);
+	// Someone else may have added it between us releasing the read lock and taking the write lock
+	auto it = table._lookup.find(name);
+	if (it != table._lookup.end()) {
+		return it->second;
+	}
+	const NameId result = static_cast<NameId>(table._strings.size());
+	table._strings.emplace_back(name);
+	table._lookup[table._strings.back()] = result;
+	return result;
+}
+
+NameId NameTable::Find(std::string_view name) {
+	NameTable& table = _Instance();
+	std::shared_lock<std::shared_mutex> lock(table._mutex);
+	auto it = table._lookup.find(name);
+	return it != table._lookup.end() ? it->second : Invalid;
+}
+
+const std::string& NameTable::GetString(NameId id) {
+	NameTable& table = _Instance();
+	std::shared_lock<std::shared_mutex> lock(table._mutex);
+	return id < table._strings.size() ? table._strings[id] : table._strings[Empty];
+}
+
+size_t NameTable::Size() {
+	NameTable& table = _Instance();
+	std::shared_lock<std::shared_mutex> lock(table._mutex);
+	return table._strings.size();
+}
@@ -1,17 +1,42 @@
 #include "Scene.h"
 
+#include <algorithm>
+
 #include "Transform.h"
 #include "GameObjectTag.h"
 #include "LoggingBase.h"
+#include "EventBus.h"
 
 entt::registry GameScene::_prefabRegistry;
 std::unordered_map<entt::id_type, StampFunction> GameScene::_stampFunctions;
+std::unordered_map<entt::id_type, GameScene::StampManyFunction> GameScene::_stampManyFunctions;
+
+// Transforms only hold a slot in their registry's transform store, so we need to copy the values, not the component
+static void StampTransform(const entt::registry& from, const entt::entity src, entt::registry& to, const entt::entity dst) {
+	const Transform& source = from.get<Transform>(src);
+	Transform& result = to.has<Transform>(dst) ? to.get<Transform>(dst) : to.emplace<Transform>(dst, entt::handle(to, dst));
+	result.SetLocalPosition(source.GetLocalPosition());
+	result.SetLocalRotation(source.GetLocalRotationQuat());
+	result.SetLocalScale(source.GetLocalScale());
+}
+
+// Gets the index part of an entity identifier, without the version
+static size_t EntityIndex(entt::entity entity) {
+	return static_cast<size_t>(entt::to_integral(entt::registry::entity(entity)));
+}
+
+// Only the empty list is ever returned for names that aren't in the index
+static const std::vector<entt::entity> EmptyEntityList;
 
 GameScene::GameScene(const std::string& name) {
 	Name = name;
 
-	RegisterComponentType<Transform>();
+	RegisterComponentType<Transform>(&StampTransform);
 	RegisterComponentType<GameObjectTag>();
+
+	_registry.on_construct<GameObjectTag>().connect<&GameScene::_OnTagConstructed>(this);
+	_registry.on_update<GameObjectTag>().connect<&GameScene::_OnTagUpdated>(this);
+	_registry.on_destroy<GameObjectTag>().connect<&GameScene::_OnTagDestroyed>(this);
 }
 
 entt::handle GameScene::CreateEntity(const std::string& name) {
@@ -27,28 +52,164 @@ entt::handle GameScene::CreateEntity(entt::entity prefab, const std::string& nam
 	LOG_ASSERT(_prefabRegistry.valid(prefab), "Entity is not a valid prefab! You may need to call CreatePrefab(entity_id) first!");
 
 	const entt::entity instance = StampEntity(_prefabRegistry, prefab, _registry);
+	if (!name.empty()) {
+		SetName(entt::handle(_registry, instance), name);
+	}
 	return entt::handle(_registry, instance);
 }
 
+std::vector<entt::entity> GameScene::StampMany(entt::entity prefab, size_t count, const InstanceTransform* transforms) {
+	LOG_ASSERT(_prefabRegistry.valid(prefab), "Entity is not a valid prefab! You may need to call CreatePrefab(entity_id) first!");
+
+	std::vector<entt::entity> result(count);
+	if (count == 0) {
+		return result;
+	}
+	_registry.reserve(_registry.size() + count);
+	_registry.create(result.begin(), result.end());
+
+	// Transforms can't be copied, each instance needs it's own slot in the transform store
+	TransformStore& store = TransformStore::Get(_registry);
+	store.Reserve(store.Size() + count);
+	_registry.reserve<Transform>(_registry.size<Transform>() + count);
+	const Transform* source = _prefabRegistry.try_get<Transform>(prefab);
+	for (size_t ix = 0; ix < count; ix++) {
+		Transform& transform = _registry.emplace<Transform>(result[ix], entt::handle(_registry, result[ix]));
+		if (transforms != nullptr) {
+			transform.SetLocalPosition(transforms[ix].Position);
+			transform.SetLocalRotation(transforms[ix].Rotation);
+			transform.SetLocalScale(transforms[ix].Scale);
+		} else if (source != nullptr) {
+			transform.SetLocalPosition(source->GetLocalPosition());
+			transform.SetLocalRotation(source->GetLocalRotationQuat());
+			transform.SetLocalScale(source->GetLocalScale());
+		}
+	}
+
+	// Everything else is copied one component type at a time
+	const entt::entity* first = result.data();
+	const entt::entity* last = result.data() + count;
+	_prefabRegistry.visit(prefab, [&](const auto typeId) {
+		if (typeId == entt::type_info<Transform>::id()) {
+			return;
+		}
+		auto bulk = _stampManyFunctions.find(typeId);
+		if (bulk != _stampManyFunctions.end() && bulk->second != nullptr) {
+			bulk->second(_prefabRegistry, prefab, _registry, first, last);
+		} else if (StampFunction stamp = _stampFunctions[typeId]) {
+			for (const entt::entity* it = first; it != last; ++it) {
+				stamp(_prefabRegistry, prefab, _registry, *it);
+			}
+		}
+	});
+	return result;
+}
+
 void GameScene::RemoveEntity(entt::handle handle)
 {
-	//Destroy entity handle
-	_registry.destroy(handle);
+	// Entities are destroyed in a batch in Poll, so nothing is destroyed out from under a system mid-frame
+	_deletionQueue.push_back(handle.entity());
+}
+
+void GameScene::Poll() {
+	if (_deletionQueue.empty()) {
+		return;
+	}
+
+	// Sorting gets rid of duplicates, and means we walk the storage in order while destroying
+	std::sort(_deletionQueue.begin(), _deletionQueue.end());
+	_deletionQueue.erase(std::unique(_deletionQueue.begin(), _deletionQueue.end()), _deletionQueue.end());
+	// Anything destroyed directly through the registry since it was queued is skipped
+	_deletionQueue.erase(std::remove_if(_deletionQueue.begin(), _deletionQueue.end(), [this](entt::entity entity) {
+		return !_registry.valid(entity);
+	}), _deletionQueue.end());
+	_registry.destroy(_deletionQueue.begin(), _deletionQueue.end());
+	for (entt::entity entity : _deletionQueue) {
+		EventBus::Publish(EntityDestroyedEvent{ &_registry, entity });
+	}
+	_deletionQueue.clear();
+}
+
+void GameScene::SetName(entt::handle handle, const std::string& name)
+{
+	GameObjectTag* tag = _registry.try_get<GameObjectTag>(handle);
+	if (tag == nullptr) {
+		_registry.emplace<GameObjectTag>(handle, name);
+		return;
+	}
+
+	const NameId id = NameTable::Intern(name);
+	if (tag->_name != id) {
+		// The update signal moves the entity to it's new bucket
+		_registry.patch<GameObjectTag>(handle, [id](GameObjectTag& value) { value._name = id; });
+	}
 }
 
 entt::handle GameScene::FindFirst(const std::string& name)
 {
-	entt::entity result = entt::null;
-	uint32_t hash = entt::hashed_string::value(name.c_str());
-	const auto view = _registry.view<GameObjectTag>();
-	
-	for(const entt::entity& entity : view) {
-		const GameObjectTag& tag = _registry.get<GameObjectTag>(entity);
-		if (tag.HashedName == hash && tag.Name == name) {
-			return entt::handle(_registry, entity);
-		}
+	return FindFirst(NameTable::Find(name));
+}
+
+entt::handle GameScene::FindFirst(NameId name)
+{
+	const std::vector<entt::entity>& entities = FindAll(name);
+	return entt::handle(_registry, entities.empty() ? entt::null : entities.front());
+}
+
+const std::vector<entt::entity>& GameScene::FindAll(const std::string& name) const
+{
+	return FindAll(NameTable::Find(name));
+}
+
+const std::vector<entt::entity>& GameScene::FindAll(NameId name) const
+{
+	return name < _nameIndex.size() ? _nameIndex[name] : EmptyEntityList;
+}
+
+void GameScene::_AddToIndex(NameId name, entt::entity entity)
+{
+	// Name IDs are dense, so the index is just an array of buckets
+	if (name >= _nameIndex.size()) {
+		_nameIndex.resize(name + 1);
 	}
-	return entt::handle(_registry, entt::null);
+	const size_t slot = EntityIndex(entity);
+	if (slot >= _nameSlots.size()) {
+		_nameSlots.resize(std::max(slot + 1, _nameSlots.size() * 2));
+		_indexedNames.resize(_nameSlots.size());
+	}
+	_nameSlots[slot] = static_cast<uint32_t>(_nameIndex[name].size());
+	_indexedNames[slot] = name;
+	_nameIndex[name].push_back(entity);
+}
+
+void GameScene::_RemoveFromIndex(entt::entity entity)
+{
+	// Stamped entities all share a name, so buckets can be huge. Swapping with the back keeps removal constant time
+	std::vector<entt::entity>& bucket = _nameIndex[_indexedNames[EntityIndex(entity)]];
+	const uint32_t pos = _nameSlots[EntityIndex(entity)];
+	bucket[pos] = bucket.back();
+	_nameSlots[EntityIndex(bucket[pos])] = pos;
+	bucket.pop_back();
+}
+
+void GameScene::_OnTagConstructed(entt::registry& registry, const entt::entity entity)
+{
+	_AddToIndex(registry.get<GameObjectTag>(entity)._name, entity);
+}
+
+void GameScene::_OnTagUpdated(entt::registry& registry, const entt::entity entity)
+{
+	// Tags that are replaced or patched (including when stamping over an existing tag) may have a new name
+	const NameId name = registry.get<GameObjectTag>(entity)._name;
+	if (name != _indexedNames[EntityIndex(entity)]) {
+		_RemoveFromIndex(entity);
+		_AddToIndex(name, entity);
+	}
+}
+
+void GameScene::_OnTagDestroyed(entt::registry& registry, const entt::entity entity)
+{
+	_RemoveFromIndex(entity);
 }
 
 entt::handle GameScene::StampEntity(const entt::registry& from, entt::entity src, entt::registry& to) {
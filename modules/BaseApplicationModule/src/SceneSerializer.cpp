@@ -0,0 +1,409 @@
+#include "SceneSerializer.h"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <gzip/compress.hpp>
+#include <gzip/decompress.hpp>
+#include <gzip/utils.hpp>
+
+#include "GameObjectTag.h"
+#include "LoggingBase.h"
+#include "Transform.h"
+
+std::vector<SceneSerializer::TypeEntry> SceneSerializer::_types;
+
+// Binary scenes start with a tag, so we can tell them apart from JSON ones when loading
+static constexpr char BinaryMagic[4] = { 'S', 'C', 'N', 'B' };
+static constexpr uint32_t SceneVersion = 1;
+static constexpr uint32_t NoParent = ~0u;
+
+// Gets the index part of an entity identifier, without the version
+static size_t EntityIndex(entt::entity entity) {
+	return static_cast<size_t>(entt::to_integral(entt::registry::entity(entity)));
+}
+
+static void LogError(const std::string& message) {
+	if (LoggerBase::GetLogger()) {
+		LOG_WARN(message);
+	}
+}
+
+/// <summary>
+/// The top level layout of a scene archive. Each section is an array, so it shows up as a list in JSON, and is
+/// prefixed with it's size in binary
+/// </summary>
+struct SceneStreams {
+	typedef SceneSerializer::TypeEntry TypeEntry;
+	typedef SceneSerializer::EntityIndexMap EntityIndexMap;
+	// The entities that each component type was loaded onto, so we can run the post load hooks at the end
+	typedef std::vector<std::pair<const TypeEntry*, std::vector<entt::entity>>> LoadedTypes;
+
+	struct EntitiesOut {
+		entt::registry* Registry;
+		const std::vector<entt::entity>* Entities;
+
+		template <typename Archive>
+		void save(Archive& archive) const {
+			static const std::string empty;
+			archive(cereal::make_size_tag(static_cast<cereal::size_type>(Entities->size())));
+			for (const entt::entity entity : *Entities) {
+				const GameObjectTag* tag = Registry->try_get<GameObjectTag>(entity);
+				archive(tag != nullptr ? tag->GetName() : empty);
+			}
+		}
+	};
+
+	struct EntitiesIn {
+		GameScene* Scene;
+		std::vector<entt::entity>* Entities;
+
+		template <typename Archive>
+		void load(Archive& archive) {
+			cereal::size_type count;
+			archive(cereal::make_size_tag(count));
+			Entities->reserve(static_cast<size_t>(count));
+			std::string name;
+			for (cereal::size_type ix = 0; ix < count; ix++) {
+				archive(name);
+				Entities->push_back(Scene->CreateEntity(name).entity());
+			}
+		}
+	};
+
+	struct TransformRecord {
+		uint32_t  Entity = 0;
+		glm::vec3 Position = glm::vec3(0.0f);
+		glm::quat Rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+		glm::vec3 Scale = glm::vec3(1.0f);
+		uint32_t  Parent = NoParent;
+
+		template <typename Archive>
+		void serialize(Archive& archive) {
+			archive(
+				cereal::make_nvp("Entity", Entity),
+				cereal::make_nvp("Position", Position),
+				cereal::make_nvp("Rotation", Rotation),
+				cereal::make_nvp("Scale", Scale),
+				cereal::make_nvp("Parent", Parent)
+			);
+		}
+	};
+
+	struct TransformsOut {
+		entt::registry* Registry;
+		const std::vector<entt::entity>* Entities;
+		const EntityIndexMap* Indices;
+
+		template <typename Archive>
+		void save(Archive& archive) const {
+			cereal::size_type count = 0;
+			for (const entt::entity entity : *Entities) {
+				count += Registry->has<Transform>(entity) ? 1 : 0;
+			}
+			archive(cereal::make_size_tag(count));
+			for (size_t ix = 0; ix < Entities->size(); ix++) {
+				const Transform* transform = Registry->try_get<Transform>((*Entities)[ix]);
+				if (transform == nullptr) {
+					continue;
+				}
+				TransformRecord record;
+				record.Entity = static_cast<uint32_t>(ix);
+				record.Position = transform->GetLocalPosition();
+				record.Rotation = transform->GetLocalRotationQuat();
+				record.Scale = transform->GetLocalScale();
+				// Parents that aren't being saved map to NoParent
+				const entt::handle parent = transform->GetParent();
+				record.Parent = parent.entity() != entt::null ? SceneSerializer::_LookupIndex(*Indices, parent.entity()) : NoParent;
+				archive(record);
+			}
+		}
+	};
+
+	struct TransformsIn {
+		entt::registry* Registry;
+		const std::vector<entt::entity>* Entities;
+
+		template <typename Archive>
+		void load(Archive& archive) {
+			cereal::size_type count;
+			archive(cereal::make_size_tag(count));
+			TransformRecord record;
+			for (cereal::size_type ix = 0; ix < count; ix++) {
+				archive(record);
+				if (record.Entity >= Entities->size() || (record.Parent != NoParent && record.Parent >= Entities->size())) {
+					throw cereal::Exception("Transform refers to an entity that does not exist");
+				}
+				// Every entity already exists, so parents can be hooked up as we go
+				Transform& transform = Registry->get<Transform>((*Entities)[record.Entity]);
+				transform.SetLocalPosition(record.Position);
+				transform.SetLocalRotation(record.Rotation);
+				transform.SetLocalScale(record.Scale);
+				if (record.Parent != NoParent) {
+					transform.SetParent(entt::handle(*Registry, (*Entities)[record.Parent]));
+				}
+			}
+		}
+	};
+
+	struct TypeOut {
+		const TypeEntry* Entry;
+		entt::registry* Registry;
+		const std::vector<entt::entity>* Entities;
+
+		template <typename Archive>
+		void save(Archive& archive) const {
+			archive(cereal::make_nvp("Type", Entry->Name));
+			if constexpr (std::is_same_v<Archive, cereal::BinaryOutputArchive>) {
+				Entry->SaveBinary(archive, *Registry, *Entities);
+			} else {
+				Entry->SaveJson(archive, *Registry, *Entities);
+			}
+		}
+	};
+
+	struct TypesOut {
+		entt::registry* Registry;
+		const std::vector<entt::entity>* Entities;
+
+		template <typename Archive>
+		void save(Archive& archive) const {
+			archive(cereal::make_size_tag(static_cast<cereal::size_type>(SceneSerializer::_types.size())));
+			for (const TypeEntry& entry : SceneSerializer::_types) {
+				archive(TypeOut{ &entry, Registry, Entities });
+			}
+		}
+	};
+
+	struct TypeIn {
+		entt::registry* Registry;
+		const std::vector<entt::entity>* Entities;
+		LoadedTypes* Loaded;
+
+		template <typename Archive>
+		void load(Archive& archive) {
+			std::string name;
+			archive(cereal::make_nvp("Type", name));
+			// Without the type we don't know how to read (or skip) the components that follow
+			const TypeEntry* entry = SceneSerializer::_FindEntry(name);
+			if (entry == nullptr) {
+				throw cereal::Exception("Unknown component type \"" + name + "\", it may need to be registered with SceneSerializer::RegisterType");
+			}
+			Loaded->emplace_back(entry, std::vector<entt::entity>());
+			if constexpr (std::is_same_v<Archive, cereal::BinaryInputArchive>) {
+				entry->LoadBinary(archive, *Registry, *Entities, Loaded->back().second);
+			} else {
+				entry->LoadJson(archive, *Registry, *Entities, Loaded->back().second);
+			}
+		}
+	};
+
+	struct TypesIn {
+		entt::registry* Registry;
+		const std::vector<entt::entity>* Entities;
+		LoadedTypes* Loaded;
+
+		template <typename Archive>
+		void load(Archive& archive) {
+			cereal::size_type count;
+			archive(cereal::make_size_tag(count));
+			for (cereal::size_type ix = 0; ix < count; ix++) {
+				TypeIn type{ Registry, Entities, Loaded };
+				archive(type);
+			}
+		}
+	};
+
+	template <typename Archive>
+	static void Save(Archive& archive, GameScene& scene, const std::vector<entt::entity>& entities) {
+		entt::registry& registry = scene.Registry();
+
+		// Entities are saved as their position in the list, so that they can be re-created in any registry
+		EntityIndexMap indices;
+		for (size_t ix = 0; ix < entities.size(); ix++) {
+			const size_t index = EntityIndex(entities[ix]);
+			if (index >= indices.size()) {
+				indices.resize(index + 1, NoParent);
+			}
+			indices[index] = static_cast<uint32_t>(ix);
+		}
+
+		archive(cereal::make_nvp("Version", SceneVersion), cereal::make_nvp("Name", scene.Name));
+		archive(cereal::make_nvp("Entities", EntitiesOut{ &registry, &entities }));
+		archive(cereal::make_nvp("Transforms", TransformsOut{ &registry, &entities, &indices }));
+		archive(cereal::make_nvp("Components", TypesOut{ &registry, &entities }));
+	}
+
+	// Reads the version and scene name, which come before anything that needs a scene to load into
+	template <typename Archive>
+	static std::string LoadHeader(Archive& archive) {
+		uint32_t version = 0;
+		std::string name;
+		archive(cereal::make_nvp("Version", version), cereal::make_nvp("Name", name));
+		if (version != SceneVersion) {
+			throw cereal::Exception("Unsupported scene version " + std::to_string(version));
+		}
+		return name;
+	}
+
+	// Reads the rest of the scene into the given scene, the created entities are added to entities as they are created
+	template <typename Archive>
+	static void LoadBody(Archive& archive, GameScene& scene, std::vector<entt::entity>& entities) {
+		entt::registry& registry = scene.Registry();
+		LoadedTypes loaded;
+		EntitiesIn entitiesIn{ &scene, &entities };
+		TransformsIn transformsIn{ &registry, &entities };
+		TypesIn typesIn{ &registry, &entities, &loaded };
+		archive(cereal::make_nvp("Entities", entitiesIn));
+		archive(cereal::make_nvp("Transforms", transformsIn));
+		archive(cereal::make_nvp("Components", typesIn));
+
+		// Post load hooks run once everything is in place, so they can look at other components and entities
+		for (const auto& [entry, loadedEntities] : loaded) {
+			if (entry->PostLoad != nullptr) {
+				for (const entt::entity entity : loadedEntities) {
+					entry->PostLoad(entt::handle(registry, entity));
+				}
+			}
+		}
+	}
+
+	template <typename Archive>
+	static GameScene::sptr Load(Archive& archive) {
+		GameScene::sptr scene = GameScene::Create(LoadHeader(archive));
+		std::vector<entt::entity> entities;
+		LoadBody(archive, *scene, entities);
+		return scene;
+	}
+
+	template <typename Archive>
+	static void LoadInto(Archive& archive, GameScene& scene, std::vector<entt::entity>& entities) {
+		LoadHeader(archive);
+		LoadBody(archive, scene, entities);
+	}
+};
+
+void SceneSerializer::_RegisterEntry(const TypeEntry& entry) {
+	for (TypeEntry& existing : _types) {
+		if (existing.Name == entry.Name) {
+			existing = entry;
+			return;
+		}
+	}
+	_types.push_back(entry);
+}
+
+const SceneSerializer::TypeEntry* SceneSerializer::_FindEntry(const std::string& name) {
+	for (const TypeEntry& entry : _types) {
+		if (entry.Name == name) {
+			return &entry;
+		}
+	}
+	return nullptr;
+}
+
+uint32_t SceneSerializer::_LookupIndex(const EntityIndexMap& indices, entt::entity entity) {
+	const size_t index = EntityIndex(entity);
+	return index < indices.size() ? indices[index] : NoParent;
+}
+
+bool SceneSerializer::SaveToFile(GameScene& scene, const std::string& path, SceneFormat format) {
+	const std::string data = SaveToString(scene, format);
+	std::ofstream file(path, std::ios::binary);
+	if (!file) {
+		LogError("Failed to open \"" + path + "\" to save the scene");
+		return false;
+	}
+	file.write(data.data(), data.size());
+	return file.good();
+}
+
+GameScene::sptr SceneSerializer::LoadFromFile(const std::string& path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		LogError("Failed to open scene file \"" + path + "\"");
+		return nullptr;
+	}
+	std::stringstream data;
+	data << file.rdbuf();
+	return LoadFromString(data.str());
+}
+
+std::string SceneSerializer::SaveToString(GameScene& scene, SceneFormat format) {
+	std::vector<entt::entity> entities;
+	entities.reserve(scene.Registry().alive());
+	scene.Registry().each([&](const entt::entity entity) { entities.push_back(entity); });
+	return SaveToString(scene, entities, format);
+}
+
+std::string SceneSerializer::SaveToString(GameScene& scene, const std::vector<entt::entity>& entities, SceneFormat format) {
+	std::ostringstream stream(std::ios::binary);
+	if (format == SceneFormat::Json) {
+		// The JSON archive only finishes writing when it is destroyed
+		{
+			cereal::JSONOutputArchive archive(stream);
+			SceneStreams::Save(archive, scene, entities);
+		}
+		return stream.str();
+	}
+
+	stream.write(BinaryMagic, sizeof(BinaryMagic));
+	{
+		cereal::BinaryOutputArchive archive(stream);
+		SceneStreams::Save(archive, scene, entities);
+	}
+	if (format == SceneFormat::CompressedBinary) {
+		const std::string raw = stream.str();
+		return gzip::compress(raw.data(), raw.size());
+	}
+	return stream.str();
+}
+
+GameScene::sptr SceneSerializer::LoadFromString(const std::string& data) {
+	try {
+		if (gzip::is_compressed(data.data(), data.size())) {
+			return LoadFromString(gzip::decompress(data.data(), data.size()));
+		}
+
+		std::istringstream stream(data, std::ios::binary);
+		if (data.size() >= sizeof(BinaryMagic) && memcmp(data.data(), BinaryMagic, sizeof(BinaryMagic)) == 0) {
+			stream.seekg(sizeof(BinaryMagic));
+			cereal::BinaryInputArchive archive(stream);
+			return SceneStreams::Load(archive);
+		} else {
+			cereal::JSONInputArchive archive(stream);
+			return SceneStreams::Load(archive);
+		}
+	} catch (const std::exception& e) {
+		LogError(std::string("Failed to load scene: ") + e.what());
+		return nullptr;
+	}
+}
+
+bool SceneSerializer::LoadIntoScene(GameScene& scene, const std::string& data, std::vector<entt::entity>* created) {
+	std::vector<entt::entity> entities;
+	try {
+		if (gzip::is_compressed(data.data(), data.size())) {
+			return LoadIntoScene(scene, gzip::decompress(data.data(), data.size()), created);
+		}
+
+		std::istringstream stream(data, std::ios::binary);
+		if (data.size() >= sizeof(BinaryMagic) && memcmp(data.data(), BinaryMagic, sizeof(BinaryMagic)) == 0) {
+			stream.seekg(sizeof(BinaryMagic));
+			cereal::BinaryInputArchive archive(stream);
+			SceneStreams::LoadInto(archive, scene, entities);
+		} else {
+			cereal::JSONInputArchive archive(stream);
+			SceneStreams::LoadInto(archive, scene, entities);
+		}
+	} catch (const std::exception& e) {
+		LogError(std::string("Failed to load scene: ") + e.what());
+		// Don't leave half of the data behind in the scene
+		scene.RemoveEntities(entities.begin(), entities.end());
+		return false;
+	}
+	if (created != nullptr) {
+		created->insert(created->end(), entities.begin(), entities.end());
+	}
+	return true;
+}
@@ -2,90 +2,91 @@
 #include "Application.h"
 #include "Timing.h"
 #include "Transform.h"
+#include "InputSystem.h"
 
 #include "GLFW/glfw3.h"
 
-void SimpleMoveBehaviour::Update(entt::handle entity)
+void SimpleMoveBehaviour::FixedUpdate(entt::handle entity)
 {
-	float dt = Timing::Instance().DeltaTime;
-	GLFWwindow* window = Application::Instance().Window;
+	float dt = GetFixedDeltaTime();
+	const InputSnapshot& input = InputSystem::Current();
 	Transform& transform = entity.get<Transform>();
 
 	if (Relative) {
-		if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+		if (input.IsKeyDown(GLFW_KEY_A)) {
 			transform.MoveLocal(0.0f, -1.0f * dt, 0.0f);
 		}
-		if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+		if (input.IsKeyDown(GLFW_KEY_D)) {
 			transform.MoveLocal(0.0f, 1.0f * dt, 0.0f);
 		}
-		if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+		if (input.IsKeyDown(GLFW_KEY_W)) {
 			transform.MoveLocal(-1.0f * dt, 0.0f, 0.0f);
 		}
-		if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+		if (input.IsKeyDown(GLFW_KEY_S)) {
 			transform.MoveLocal(1.0f * dt, 0.0f, 0.0f);
 		}
-		if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
+		if (input.IsKeyDown(GLFW_KEY_SPACE)) {
 			transform.MoveLocal(0.0f, 0.0f, 1.0f * dt);
 		}
-		if (glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS) {
+		if (input.IsKeyDown(GLFW_KEY_LEFT_CONTROL)) {
 			transform.MoveLocal(0.0f, 0.0f, -1.0f * dt);
 		}
 
-		if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) {
+		if (input.IsKeyDown(GLFW_KEY_UP)) {
 			transform.RotateLocal(0.0f, -45.0f * dt, 0.0f);
 		}
-		if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) {
+		if (input.IsKeyDown(GLFW_KEY_DOWN)) {
 			transform.RotateLocal(0.0f, 45.0f * dt, 0.0f);
 		}
-		if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS) {
+		if (input.IsKeyDown(GLFW_KEY_LEFT)) {
 			transform.RotateLocal(45.0f * dt, 0.0f, 0.0f);
 		}
-		if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS) {
+		if (input.IsKeyDown(GLFW_KEY_RIGHT)) {
 			transform.RotateLocal(-45.0f * dt, 0.0f, 0.0f);
 		}
-		if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS) {
+		if (input.IsKeyDown(GLFW_KEY_Q)) {
 			transform.RotateLocal(0.0f, 0.0f, 45.0f * dt);
 		}
-		if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS) {
+		if (input.IsKeyDown(GLFW_KEY_E)) {
 			transform.RotateLocal(0.0f, 0.0f, -45.0f * dt);
 		}
 	} else
 	{
-		if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+		if (input.IsKeyDown(GLFW_KEY_A)) {
 			transform.MoveLocalFixed(0.0f, -1.0f * dt, 0.0f);
 		}
-		if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+		if (input.IsKeyDown(GLFW_KEY_D)) {
 			transform.MoveLocalFixed(0.0f, 1.0f * dt, 0.0f);
 		}
-		if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+		if (input.IsKeyDown(GLFW_KEY_W)) {
 			transform.MoveLocalFixed(-1.0f * dt, 0.0f, 0.0f);
 		}
-		if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+		if (input.IsKeyDown(GLFW_KEY_S)) {
 			transform.MoveLocalFixed(1.0f * dt, 0.0f, 0.0f);
 		}
-		if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
+		if (input.IsKeyDown(GLFW_KEY_SPACE)) {
 			transform.MoveLocalFixed(0.0f, 0.0f, 1.0f * dt);
 		}
-		if (glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS) {
+		if (input.IsKeyDown(GLFW_KEY_LEFT_CONTROL)) {
 			transform.MoveLocalFixed(0.0f, 0.0f, -1.0f * dt);
 		}
 
-		if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) {
+		if (input.IsKeyDown(GLFW_KEY_UP)) {
 			transform.RotateLocalFixed(0.0f, -45.0f * dt, 0.0f);
 		}
-		if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) {
+		if (input.IsKeyDown(GLFW_KEY_DOWN)) {
 			transform.RotateLocalFixed(0.0f, 45.0f * dt, 0.0f);
 		}
-		if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS) {
+		if (input.IsKeyDown(GLFW_KEY_LEFT)) {
 			transform.RotateLocalFixed(45.0f * dt, 0.0f, 0.0f);
 		}
-		if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS) {
+		if (input.IsKeyDown(GLFW_KEY_RIGHT)) {
 			transform.RotateLocalFixed(-45.0f * dt, 0.0f, 0.0f);
 		}
-		if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS) {
+		if (input.IsKeyDown(GLFW_KEY_Q)) {
 			transform.RotateLocalFixed(0.0f, 0.0f, 45.0f * dt);
 		}
-		if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS) {
+		if (input.IsKeyDown(GLFW_KEY_E)) {
 			transform.RotateLocalFixed(0.0f, 0.0f, -45.0f * dt);
 		}
 	}
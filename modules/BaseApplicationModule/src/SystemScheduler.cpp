@@ -0,0 +1,304 @@
+#include "SystemScheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+
+#include "JobSystem.h"
+#include "LoggingBase.h"
+
+// The system that is running on the current thread, used to validate component access
+static thread_local SystemScheduler* s_currentScheduler = nullptr;
+static thread_local size_t s_currentSystem = 0;
+
+typedef std::chrono::high_resolution_clock Clock;
+
+// Stored in the context of any registry that a scheduler has hooked. Context variables are destroyed before the
+// pools, so this lets schedulers that outlive the registry know that they no longer need to disconnect
+struct SystemSchedulerHooks {
+	std::vector<SystemScheduler*> Schedulers;
+
+	~SystemSchedulerHooks() {
+		for (SystemScheduler* scheduler : Schedulers) {
+			scheduler->_OnRegistryDestroyed();
+		}
+	}
+};
+
+static int64_t NowNs() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+void SystemContext::_RunChunks(size_t count, size_t chunkSize, const std::function<void(size_t, size_t)>& func) {
+	_scheduler._RunChunks(_system, count, chunkSize, func);
+}
+
+SystemScheduler::SystemScheduler(size_t workerCount) :
+	_systems(std::vector<System>()),
+	_isGraphDirty(false),
+	#ifdef SYSTEM_SCHEDULER_VALIDATE
+	_validateAccess(true),
+	#else
+	_validateAccess(false),
+	#endif
+	_hookedRegistry(nullptr),
+	_hookedTypes(std::vector<Access>()),
+	_report(FrameReport())
+{
+	// The job system is shared, so this only decides the worker count if nothing else has started it yet
+	JobSystem::Init(workerCount);
+}
+
+SystemScheduler::~SystemScheduler() {
+	_RemoveHooks();
+}
+
+SystemScheduler::SystemBuilder SystemScheduler::AddSystem(const std::string& name, const SystemFunc& func) {
+	System system;
+	system.Name = name;
+	system.Func = func;
+	_systems.push_back(std::move(system));
+	_isGraphDirty = true;
+	return SystemBuilder(*this, _systems.size() - 1);
+}
+
+size_t SystemScheduler::GetWorkerCount() const {
+	return JobSystem::GetWorkerCount();
+}
+
+void SystemScheduler::_BuildGraph() {
+	for (System& system : _systems) {
+		system.Dependents.clear();
+		system.DependencyCount = 0;
+	}
+
+	// Systems that share a component where either writes it must run in the order they were added, so we only need
+	// edges from earlier systems to later ones, and the registration order is always a valid topological order
+	for (size_t ix = 0; ix < _systems.size(); ix++) {
+		for (size_t jx = ix + 1; jx < _systems.size(); jx++) {
+			bool conflicts = false;
+			for (const Access& a : _systems[ix].Accesses) {
+				for (const Access& b : _systems[jx].Accesses) {
+					if (a.Type == b.Type && (a.Write || b.Write)) {
+						conflicts = true;
+						break;
+					}
+				}
+				if (conflicts) break;
+			}
+			if (conflicts) {
+				_systems[ix].Dependents.push_back(jx);
+				_systems[jx].DependencyCount++;
+			}
+		}
+	}
+
+	_report.Systems.resize(_systems.size());
+	for (size_t ix = 0; ix < _systems.size(); ix++) {
+		_report.Systems[ix].Name = _systems[ix].Name;
+	}
+	_isGraphDirty = false;
+}
+
+void SystemScheduler::_InstallHooks(entt::registry& registry) {
+	_RemoveHooks();
+	_hookedRegistry = &registry;
+	registry.ctx_or_set<SystemSchedulerHooks>().Schedulers.push_back(this);
+	for (const System& system : _systems) {
+		for (const Access& access : system.Accesses) {
+			const bool isHooked = std::any_of(_hookedTypes.begin(), _hookedTypes.end(), [&](const Access& other) { return other.Type == access.Type; });
+			if (!isHooked && access.Hook != nullptr) {
+				access.Hook(registry, *this, true);
+				_hookedTypes.push_back(access);
+			}
+		}
+	}
+}
+
+void SystemScheduler::_RemoveHooks() {
+	if (_hookedRegistry != nullptr) {
+		for (const Access& access : _hookedTypes) {
+			access.Hook(*_hookedRegistry, *this, false);
+		}
+		std::vector<SystemScheduler*>& schedulers = _hookedRegistry->ctx<SystemSchedulerHooks>().Schedulers;
+		schedulers.erase(std::remove(schedulers.begin(), schedulers.end(), this), schedulers.end());
+	}
+	_hookedRegistry = nullptr;
+	_hookedTypes.clear();
+}
+
+void SystemScheduler::_OnRegistryDestroyed() {
+	_hookedRegistry = nullptr;
+	_hookedTypes.clear();
+}
+
+void SystemScheduler::_ValidateAccess(entt::id_type type, const char* name, bool write) {
+	if (!_validateAccess || s_currentScheduler != this) {
+		return;
+	}
+
+	const System& system = _systems[s_currentSystem];
+	for (const Access& access : system.Accesses) {
+		if (access.Type == type && (access.Write || !write)) {
+			return;
+		}
+	}
+
+	std::string message = "System '" + system.Name + "' " + (write ? "wrote" : "read") + " undeclared component " + name;
+	std::lock_guard<std::mutex> lock(_violationMutex);
+	if (std::find(_report.AccessViolations.begin(), _report.AccessViolations.end(), message) == _report.AccessViolations.end()) {
+		if (LoggerBase::GetLogger()) {
+			LOG_WARN(message);
+		}
+		_report.AccessViolations.push_back(std::move(message));
+	}
+}
+
+void SystemScheduler::_RunSystem(entt::registry& registry, size_t system, int64_t frameStart) {
+	// Threads can pick up other systems while they wait, so we need to restore whatever was running before
+	SystemScheduler* prevScheduler = s_currentScheduler;
+	const size_t prevSystem = s_currentSystem;
+	s_currentScheduler = this;
+	s_currentSystem = system;
+
+	const int64_t start = NowNs();
+	SystemContext context(registry, *this, system);
+	_systems[system].Func(context);
+	const int64_t end = NowNs();
+
+	SystemTiming& timing = _report.Systems[system];
+	timing.StartMs = (start - frameStart) / 1000000.0f;
+	timing.DurationMs = (end - start) / 1000000.0f;
+	timing.OnMainThread = _systems[system].MainThread;
+
+	s_currentScheduler = prevScheduler;
+	s_currentSystem = prevSystem;
+}
+
+void SystemScheduler::_RunChunks(size_t system, size_t count, size_t chunkSize, const std::function<void(size_t, size_t)>& func) {
+	// Chunks run as part of the calling system, so helpers take on it's identity for validation
+	SystemScheduler* scheduler = s_currentScheduler;
+	JobSystem::ParallelFor(count, chunkSize, [&func, scheduler, system](size_t first, size_t last) {
+		SystemScheduler* prevScheduler = s_currentScheduler;
+		const size_t prevSystem = s_currentSystem;
+		s_currentScheduler = scheduler;
+		s_currentSystem = system;
+		func(first, last);
+		s_currentScheduler = prevScheduler;
+		s_currentSystem = prevSystem;
+	});
+}
+
+void SystemScheduler::Run(entt::registry& registry) {
+	if (_isGraphDirty) {
+		_BuildGraph();
+	}
+	if (_validateAccess && _hookedRegistry != &registry) {
+		_InstallHooks(registry);
+	}
+	if (_systems.empty()) {
+		_report.CriticalPath.clear();
+		_report.CriticalPathMs = 0.0f;
+		_report.WallMs = 0.0f;
+		return;
+	}
+
+	const int64_t frameStart = NowNs();
+
+	std::mutex mutex;
+	std::condition_variable signal;
+	std::vector<size_t> pending(_systems.size());
+	std::deque<size_t> mainQueue;
+	size_t remaining = _systems.size();
+
+	// Dispatch is only called with the mutex held. Everything that touches our locals happens under the lock, since Run can
+	// return as soon as the last system completes
+	std::function<void(size_t)> dispatch;
+	auto complete = [&](size_t system) {
+		std::lock_guard<std::mutex> lock(mutex);
+		for (size_t dependent : _systems[system].Dependents) {
+			if (--pending[dependent] == 0) {
+				dispatch(dependent);
+			}
+		}
+		remaining--;
+		signal.notify_all();
+	};
+	dispatch = [&](size_t system) {
+		if (_systems[system].MainThread) {
+			mainQueue.push_back(system);
+			signal.notify_all();
+		} else {
+			JobSystem::Run([&, system]() {
+				_RunSystem(registry, system, frameStart);
+				complete(system);
+			});
+		}
+	};
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (size_t ix = 0; ix < _systems.size(); ix++) {
+			pending[ix] = _systems[ix].DependencyCount;
+		}
+		for (size_t ix = 0; ix < _systems.size(); ix++) {
+			if (pending[ix] == 0) {
+				dispatch(ix);
+			}
+		}
+	}
+
+	// Run the main thread systems as they become ready, and help out with pool jobs in the mean time
+	while (true) {
+		size_t system = 0;
+		bool hasSystem = false;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (remaining == 0) {
+				break;
+			}
+			if (!mainQueue.empty()) {
+				system = mainQueue.front();
+				mainQueue.pop_front();
+				hasSystem = true;
+			}
+		}
+
+		if (hasSystem) {
+			_RunSystem(registry, system, frameStart);
+			complete(system);
+		} else if (!JobSystem::TryRunOne()) {
+			std::unique_lock<std::mutex> lock(mutex);
+			signal.wait(lock, [&]() { return remaining == 0 || !mainQueue.empty(); });
+		}
+	}
+
+	_report.WallMs = (NowNs() - frameStart) / 1000000.0f;
+	_ComputeCriticalPath();
+}
+
+void SystemScheduler::_ComputeCriticalPath() {
+	// Registration order is a topological order, so one forward pass gives the longest chain ending at each system
+	const size_t count = _systems.size();
+	std::vector<float> finish(count, 0.0f);
+	std::vector<size_t> previous(count, count);
+	for (size_t ix = 0; ix < count; ix++) {
+		finish[ix] += _report.Systems[ix].DurationMs;
+		for (size_t dependent : _systems[ix].Dependents) {
+			if (finish[ix] > finish[dependent]) {
+				finish[dependent] = finish[ix];
+				previous[dependent] = ix;
+			}
+		}
+	}
+
+	size_t last = std::max_element(finish.begin(), finish.end()) - finish.begin();
+	_report.CriticalPathMs = finish[last];
+	_report.CriticalPath.clear();
+	for (size_t ix = last; ix < count; ix = previous[ix]) {
+		_report.CriticalPath.push_back(ix);
+	}
+	std::reverse(_report.CriticalPath.begin(), _report.CriticalPath.end());
+}
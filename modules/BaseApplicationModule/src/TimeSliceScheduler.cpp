@@ -0,0 +1,152 @@
+#include "TimeSliceScheduler.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+
+static double Now() {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+TimeSliceScheduler::TimeSliceScheduler() :
+	_tasks(std::vector<Task>()),
+	_freeList(std::vector<uint32_t>()),
+	_nextSequence(0),
+	_stats(Stats()),
+	_order(std::vector<uint32_t>())
+{ }
+
+TaskHandle TimeSliceScheduler::Schedule(const std::string& name, TaskFunc func, TaskPriority priority, float deadlineSeconds) {
+	uint32_t index;
+	if (!_freeList.empty()) {
+		index = _freeList.back();
+		_freeList.pop_back();
+	} else {
+		index = static_cast<uint32_t>(_tasks.size());
+		_tasks.emplace_back();
+	}
+
+	Task& task = _tasks[index];
+	task.Name = name;
+	task.Func = std::move(func);
+	task.Priority = priority;
+	task.Deadline = deadlineSeconds > 0.0f ? Now() + deadlineSeconds : 0.0;
+	task.Sequence = _nextSequence++;
+	task.IsAlive = true;
+	task.AverageStepMs = 0.0f;
+	task.StepCount = 0;
+	return { index, task.Generation };
+}
+
+void TimeSliceScheduler::Cancel(TaskHandle handle) {
+	if (IsPending(handle)) {
+		_Free(handle.Index);
+	}
+}
+
+bool TimeSliceScheduler::IsPending(TaskHandle handle) const {
+	return handle.Index < _tasks.size() && _tasks[handle.Index].IsAlive && _tasks[handle.Index].Generation == handle.Generation;
+}
+
+void TimeSliceScheduler::CancelAll() {
+	for (uint32_t ix = 0; ix < _tasks.size(); ix++) {
+		if (_tasks[ix].IsAlive) {
+			_Free(ix);
+		}
+	}
+}
+
+void TimeSliceScheduler::Update(float budgetMs) {
+	const double start = Now();
+	_stats = Stats();
+
+	_order.clear();
+	for (uint32_t ix = 0; ix < _tasks.size(); ix++) {
+		if (_tasks[ix].IsAlive) {
+			_order.push_back(ix);
+		}
+	}
+	std::sort(_order.begin(), _order.end(), [this, start](uint32_t l, uint32_t r) {
+		const Task& a = _tasks[l];
+		const Task& b = _tasks[r];
+		// Anything past it's deadline goes first, then the most urgent, then the earliest deadline
+		const bool aOverdue = a.Deadline > 0.0 && a.Deadline <= start;
+		const bool bOverdue = b.Deadline > 0.0 && b.Deadline <= start;
+		if (aOverdue != bOverdue) return aOverdue;
+		if (a.Priority != b.Priority) return a.Priority > b.Priority;
+		const double aDeadline = a.Deadline > 0.0 ? a.Deadline : DBL_MAX;
+		const double bDeadline = b.Deadline > 0.0 ? b.Deadline : DBL_MAX;
+		if (aDeadline != bDeadline) return aDeadline < bDeadline;
+		return a.Sequence < b.Sequence;
+	});
+
+	bool hasRunStep = false;
+	for (uint32_t index : _order) {
+		// Tasks scheduled by earlier steps wait for the next update, and tasks cancelled by them are skipped
+		const uint32_t generation = _tasks[index].Generation;
+		bool isGuaranteed = _tasks[index].Deadline > 0.0 && _tasks[index].Deadline <= start;
+		while (_tasks[index].IsAlive && _tasks[index].Generation == generation) {
+			const float usedMs = static_cast<float>((Now() - start) * 1000.0);
+			if (hasRunStep && !isGuaranteed && usedMs + _tasks[index].AverageStepMs > budgetMs) {
+				break;
+			}
+			hasRunStep = true;
+			isGuaranteed = false;
+			if (!_RunStep(index)) {
+				break;
+			}
+		}
+	}
+
+	const double end = Now();
+	_stats.UsedMs = static_cast<float>((end - start) * 1000.0);
+	for (const Task& task : _tasks) {
+		if (task.IsAlive) {
+			_stats.Pending++;
+			if (task.Deadline > 0.0 && task.Deadline <= end) {
+				_stats.Overdue++;
+			}
+		}
+	}
+}
+
+void TimeSliceScheduler::Flush() {
+	while (Size() > 0) {
+		Update(FLT_MAX);
+	}
+}
+
+bool TimeSliceScheduler::_RunStep(uint32_t index) {
+	// The step may schedule more tasks and move the task list around, so the body is moved out while it runs
+	const uint32_t generation = _tasks[index].Generation;
+	TaskFunc func = std::move(_tasks[index].Func);
+
+	const double start = Now();
+	const TaskStep result = func();
+	const float stepMs = static_cast<float>((Now() - start) * 1000.0);
+	_stats.Steps++;
+
+	Task& task = _tasks[index];
+	if (!task.IsAlive || task.Generation != generation) {
+		// Cancelled during it's own step
+		return false;
+	}
+	task.AverageStepMs = task.StepCount == 0 ? stepMs : task.AverageStepMs * 0.75f + stepMs * 0.25f;
+	task.StepCount++;
+	if (result == TaskStep::Done) {
+		_stats.Completed++;
+		_Free(index);
+		return false;
+	}
+	task.Func = std::move(func);
+	return true;
+}
+
+void TimeSliceScheduler::_Free(uint32_t index) {
+	Task& task = _tasks[index];
+	task.Func = nullptr;
+	task.Name.clear();
+	task.IsAlive = false;
+	task.Generation++;
+	_freeList.push_back(index);
+}
@@ -0,0 +1,402 @@
+#include "WorldStreamer.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <gzip/compress.hpp>
+#include <gzip/decompress.hpp>
+#include <gzip/utils.hpp>
+
+#include "LoggingBase.h"
+#include "EventBus.h"
+#include "Transform.h"
+
+static void LogError(const std::string& message) {
+	if (LoggerBase::GetLogger()) {
+		LOG_WARN(message);
+	}
+}
+
+/// <summary>
+/// Reads and decompresses cells on a background thread. Results are collected on the main thread, since the
+/// registry can only be touched from there
+/// </summary>
+struct WorldStreamer::Loader {
+	struct Job {
+		uint64_t Key;
+		glm::ivec2 Coord;
+		uint32_t Request;
+		std::vector<Part> Parts;
+	};
+
+	struct Result {
+		uint64_t Key;
+		uint32_t Request;
+		bool IsOk;
+		std::vector<std::string> Parts;
+	};
+
+	std::thread Worker;
+	std::deque<Job> Jobs;
+	std::vector<Result> Results;
+	std::mutex Mutex;
+	std::condition_variable Signal;
+	bool IsRunning = true;
+
+	Loader() {
+		Worker = std::thread([this]() { _WorkerLoop(); });
+	}
+
+	~Loader() {
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			IsRunning = false;
+			Jobs.clear();
+		}
+		Signal.notify_all();
+		Worker.join();
+	}
+
+	void Submit(Job&& job) {
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			Jobs.push_back(std::move(job));
+		}
+		Signal.notify_one();
+	}
+
+	// Drops a job if it hasn't been started yet, jobs that are already running are ignored when they finish
+	void Cancel(uint64_t key) {
+		std::lock_guard<std::mutex> lock(Mutex);
+		Jobs.erase(std::remove_if(Jobs.begin(), Jobs.end(), [key](const Job& job) { return job.Key == key; }), Jobs.end());
+	}
+
+	void TakeResults(std::vector<Result>& results) {
+		std::lock_guard<std::mutex> lock(Mutex);
+		results.swap(Results);
+		Results.clear();
+	}
+
+private:
+	static bool _ReadPart(const Part& part, std::string& result) {
+		std::string fileData;
+		const std::string* data = part.Data.get();
+		if (data == nullptr) {
+			std::ifstream file(part.Path, std::ios::binary);
+			if (!file) {
+				return false;
+			}
+			std::stringstream stream;
+			stream << file.rdbuf();
+			fileData = stream.str();
+			data = &fileData;
+		}
+		// Decompressing here keeps the biggest cost of loading off of the main thread
+		if (gzip::is_compressed(data->data(), data->size())) {
+			result = gzip::decompress(data->data(), data->size());
+		} else {
+			result = *data;
+		}
+		return true;
+	}
+
+	void _WorkerLoop() {
+		while (true) {
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(Mutex);
+				Signal.wait(lock, [this]() { return !IsRunning || !Jobs.empty(); });
+				if (!IsRunning) {
+					return;
+				}
+				job = std::move(Jobs.front());
+				Jobs.pop_front();
+			}
+
+			Result result{ job.Key, job.Request, true, std::vector<std::string>(job.Parts.size()) };
+			for (size_t ix = 0; ix < job.Parts.size() && result.IsOk; ix++) {
+				try {
+					result.IsOk = _ReadPart(job.Parts[ix], result.Parts[ix]);
+				} catch (const std::exception&) {
+					result.IsOk = false;
+				}
+			}
+
+			WorldCellLoadedEvent loaded{ job.Coord, result.IsOk, 0 };
+			for (const std::string& part : result.Parts) {
+				loaded.Bytes += part.size();
+			}
+			EventBus::Publish(loaded);
+
+			std::lock_guard<std::mutex> lock(Mutex);
+			Results.push_back(std::move(result));
+		}
+	}
+};
+
+WorldStreamer::WorldStreamer(const GameScene::sptr& scene) :
+	WorldStreamer(scene, Settings()) { }
+
+WorldStreamer::WorldStreamer(const GameScene::sptr& scene, const Settings& settings) :
+	_scene(scene),
+	_settings(Settings()),
+	_stats(Stats()),
+	_cells(std::unordered_map<uint64_t, Cell>()),
+	_active(std::vector<uint64_t>()),
+	_loader(std::make_unique<Loader>()),
+	_nextRequest(1)
+{
+	SetSettings(settings);
+}
+
+WorldStreamer::~WorldStreamer() = default;
+
+uint64_t WorldStreamer::_Key(const glm::ivec2& cell) {
+	return (static_cast<uint64_t>(static_cast<uint32_t>(cell.x)) << 32) | static_cast<uint32_t>(cell.y);
+}
+
+WorldStreamer::Cell& WorldStreamer::_AddCell(const glm::ivec2& cell) {
+	Cell& result = _cells[_Key(cell)];
+	result.Coord = cell;
+	// New data is picked up the next time the cell loads
+	result.Failed = false;
+	return result;
+}
+
+void WorldStreamer::AddCellFile(const glm::ivec2& cell, const std::string& path) {
+	_AddCell(cell).Parts.push_back(Part{ path, nullptr });
+}
+
+void WorldStreamer::AddCellData(const glm::ivec2& cell, std::string data) {
+	_AddCell(cell).Parts.push_back(Part{ std::string(), std::make_shared<const std::string>(std::move(data)) });
+}
+
+size_t WorldStreamer::BakeCells(const std::vector<entt::entity>& entities, const std::string& directory) {
+	entt::registry& registry = _scene->Registry();
+
+	// Group the roots and their children by cell
+	std::unordered_map<uint64_t, std::vector<entt::entity>> groups;
+	std::vector<entt::entity> removed;
+	removed.reserve(entities.size());
+	std::vector<entt::entity> stack;
+	for (const entt::entity root : entities) {
+		const Transform* transform = registry.try_get<Transform>(root);
+		if (transform == nullptr) {
+			continue;
+		}
+		const glm::vec3 position = transform->GetParent().entity() == entt::null ?
+			transform->GetLocalPosition() : glm::vec3(transform->WorldTransform()[3]);
+		std::vector<entt::entity>& group = groups[_Key(GetCell(position))];
+
+		stack.push_back(root);
+		while (!stack.empty()) {
+			const entt::entity entity = stack.back();
+			stack.pop_back();
+			group.push_back(entity);
+			removed.push_back(entity);
+			registry.get<Transform>(entity).EachChild([&](entt::handle child) { stack.push_back(child.entity()); });
+		}
+	}
+
+	for (auto& [key, group] : groups) {
+		const glm::ivec2 coord(static_cast<int32_t>(key >> 32), static_cast<int32_t>(key & 0xFFFFFFFF));
+		std::string data = SceneSerializer::SaveToString(*_scene, group, SceneFormat::CompressedBinary);
+		if (directory.empty()) {
+			AddCellData(coord, std::move(data));
+			continue;
+		}
+		const std::string path = directory + "/cell_" + std::to_string(coord.x) + "_" + std::to_string(coord.y) +
+			"_" + std::to_string(_cells.count(key) != 0 ? _cells[key].Parts.size() : 0) + ".scene";
+		std::ofstream file(path, std::ios::binary);
+		file.write(data.data(), data.size());
+		if (!file.good()) {
+			// Keep the cell in memory rather than losing it
+			LogError("Failed to write world cell \"" + path + "\", keeping it in memory");
+			AddCellData(coord, std::move(data));
+		} else {
+			AddCellFile(coord, path);
+		}
+	}
+
+	// The entities are in cells now, they will be streamed back in when the focus gets close
+	_scene->RemoveEntities(removed.begin(), removed.end());
+	_RefreshStats();
+	return groups.size();
+}
+
+glm::ivec2 WorldStreamer::GetCell(const glm::vec3& position) const {
+	return glm::ivec2(glm::floor(glm::vec2(position.x, position.y) / _settings.CellSize));
+}
+
+bool WorldStreamer::IsResident(const glm::ivec2& cell) const {
+	auto it = _cells.find(_Key(cell));
+	return it != _cells.end() && it->second.State == CellState::Resident;
+}
+
+void WorldStreamer::SetSettings(const Settings& settings) {
+	const float cellSize = _settings.CellSize;
+	_settings = settings;
+	// Cells are keyed by their coordinates, so the cell size can't change once there are cells
+	if (!_cells.empty()) {
+		_settings.CellSize = cellSize;
+	}
+	_settings.CellSize = glm::max(_settings.CellSize, 0.001f);
+	_settings.UnloadRadius = glm::max(_settings.UnloadRadius, _settings.LoadRadius);
+}
+
+float WorldStreamer::_DistanceToCell(const glm::vec2& focus, const glm::ivec2& cell) const {
+	// Distance to the closest point of the cell, so cells start loading before the focus is at their center
+	const glm::vec2 min = glm::vec2(cell) * _settings.CellSize;
+	const glm::vec2 max = min + _settings.CellSize;
+	const glm::vec2 delta = glm::max(glm::max(min - focus, focus - max), glm::vec2(0.0f));
+	return glm::length(delta);
+}
+
+void WorldStreamer::_RequestLoad(uint64_t key, Cell& cell) {
+	cell.State = CellState::Loading;
+	cell.Request = _nextRequest++;
+	_loader->Submit(Loader::Job{ key, cell.Coord, cell.Request, cell.Parts });
+	_active.push_back(key);
+}
+
+void WorldStreamer::_Unload(Cell& cell) {
+	if (cell.State == CellState::Resident) {
+		_scene->RemoveEntities(cell.Entities.begin(), cell.Entities.end());
+		_stats.RemovedThisFrame += static_cast<uint32_t>(cell.Entities.size());
+		_stats.TotalUnloads++;
+	} else if (cell.State == CellState::Loading) {
+		_loader->Cancel(_Key(cell.Coord));
+	}
+	cell.Entities.clear();
+	cell.Entities.shrink_to_fit();
+	cell.Loaded.clear();
+	cell.State = CellState::Unloaded;
+}
+
+void WorldStreamer::_CollectLoaded() {
+	std::vector<Loader::Result> results;
+	_loader->TakeResults(results);
+	for (Loader::Result& result : results) {
+		auto it = _cells.find(result.Key);
+		// Ignore anything that was cancelled or re-requested since
+		if (it == _cells.end() || it->second.State != CellState::Loading || it->second.Request != result.Request) {
+			continue;
+		}
+		Cell& cell = it->second;
+		if (!result.IsOk) {
+			LogError("Failed to read world cell (" + std::to_string(cell.Coord.x) + ", " + std::to_string(cell.Coord.y) + ")");
+			cell.Failed = true;
+			cell.State = CellState::Unloaded;
+			continue;
+		}
+		cell.Bytes = 0;
+		for (const std::string& part : result.Parts) {
+			cell.Bytes += part.size();
+		}
+		cell.Loaded = std::move(result.Parts);
+		cell.State = CellState::Waiting;
+	}
+}
+
+void WorldStreamer::Update(const glm::vec3& focus) {
+	const glm::vec2 focus2D(focus.x, focus.y);
+	_stats.CreatedThisFrame = 0;
+	_stats.RemovedThisFrame = 0;
+
+	_CollectLoaded();
+
+	// Unload anything that has moved out of range, and drop cells that have finished unloading from the active list
+	for (size_t ix = 0; ix < _active.size();) {
+		Cell& cell = _cells[_active[ix]];
+		if (cell.State != CellState::Unloaded && _DistanceToCell(focus2D, cell.Coord) > _settings.UnloadRadius) {
+			_Unload(cell);
+		}
+		if (cell.State == CellState::Unloaded) {
+			_active[ix] = _active.back();
+			_active.pop_back();
+		} else {
+			ix++;
+		}
+	}
+
+	// Request any cells that have come into range, only the cells that could be in range are looked at
+	const glm::ivec2 first = GetCell(glm::vec3(focus2D - _settings.LoadRadius, 0.0f));
+	const glm::ivec2 last = GetCell(glm::vec3(focus2D + _settings.LoadRadius, 0.0f));
+	for (int y = first.y; y <= last.y; y++) {
+		for (int x = first.x; x <= last.x; x++) {
+			const uint64_t key = _Key(glm::ivec2(x, y));
+			auto it = _cells.find(key);
+			if (it == _cells.end() || it->second.State != CellState::Unloaded || it->second.Failed) {
+				continue;
+			}
+			if (_DistanceToCell(focus2D, it->second.Coord) <= _settings.LoadRadius) {
+				_RequestLoad(key, it->second);
+			}
+		}
+	}
+
+	// Create the cells that are ready, closest first, until we run out of budget for this frame
+	std::vector<std::pair<float, Cell*>> waiting;
+	for (const uint64_t key : _active) {
+		Cell& cell = _cells[key];
+		if (cell.State == CellState::Waiting) {
+			waiting.emplace_back(_DistanceToCell(focus2D, cell.Coord), &cell);
+		}
+	}
+	std::sort(waiting.begin(), waiting.end(), [](const auto& l, const auto& r) { return l.first < r.first; });
+	for (const auto& [distance, cell] : waiting) {
+		if (_stats.CreatedThisFrame >= _settings.EntityBudget) {
+			break;
+		}
+		for (const std::string& part : cell->Loaded) {
+			if (!SceneSerializer::LoadIntoScene(*_scene, part, &cell->Entities)) {
+				cell->Failed = true;
+			}
+		}
+		cell->Loaded.clear();
+		cell->State = CellState::Resident;
+		_stats.CreatedThisFrame += static_cast<uint32_t>(cell->Entities.size());
+		_stats.TotalLoads++;
+	}
+
+	_RefreshStats();
+}
+
+void WorldStreamer::UnloadAll() {
+	for (const uint64_t key : _active) {
+		_Unload(_cells[key]);
+	}
+	_active.clear();
+	_RefreshStats();
+}
+
+void WorldStreamer::_RefreshStats() {
+	_stats.Cells = static_cast<uint32_t>(_cells.size());
+	_stats.Resident = 0;
+	_stats.Loading = 0;
+	_stats.Waiting = 0;
+	_stats.ResidentEntities = 0;
+	_stats.ResidentBytes = 0;
+	for (const uint64_t key : _active) {
+		const Cell& cell = _cells[key];
+		switch (cell.State) {
+			case CellState::Resident:
+				_stats.Resident++;
+				_stats.ResidentEntities += static_cast<uint32_t>(cell.Entities.size());
+				_stats.ResidentBytes += cell.Bytes;
+				break;
+			case CellState::Loading:
+				_stats.Loading++;
+				break;
+			case CellState::Waiting:
+				_stats.Waiting++;
+				break;
+			default:
+				break;
+		}
+	}
+}
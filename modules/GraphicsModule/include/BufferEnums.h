@@ -0,0 +1,31 @@
+#pragma once
+
+#include <EnumToString.h>
+
+#include "glad/glad.h"
+
+// https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glBufferStorage.xhtml
+// Flags for immutable buffer storage, these determine what we are allowed to do with the buffer after creation
+ENUM_FLAGS(BufferStorageFlags, GLbitfield,
+	None           = 0,
+	DynamicStorage = GL_DYNAMIC_STORAGE_BIT, // Allows updating the contents via glNamedBufferSubData
+	MapRead        = GL_MAP_READ_BIT,
+	MapWrite       = GL_MAP_WRITE_BIT,
+	MapPersistent  = GL_MAP_PERSISTENT_BIT,  // Allows the buffer to stay mapped while it is used for drawing
+	MapCoherent    = GL_MAP_COHERENT_BIT,    // Writes to a persistent mapping are visible to the GPU without flushing
+	ClientStorage  = GL_CLIENT_STORAGE_BIT   // Hint that the storage should live in client memory
+);
+
+// https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glMapBufferRange.xhtml
+// Access flags for mapping a buffer range into client memory
+ENUM_FLAGS(BufferMapFlags, GLbitfield,
+	None             = 0,
+	Read             = GL_MAP_READ_BIT,
+	Write            = GL_MAP_WRITE_BIT,
+	Persistent       = GL_MAP_PERSISTENT_BIT,
+	Coherent         = GL_MAP_COHERENT_BIT,
+	InvalidateRange  = GL_MAP_INVALIDATE_RANGE_BIT,
+	InvalidateBuffer = GL_MAP_INVALIDATE_BUFFER_BIT,
+	FlushExplicit    = GL_MAP_FLUSH_EXPLICIT_BIT, // Changes must be published with FlushRange
+	Unsynchronized   = GL_MAP_UNSYNCHRONIZED_BIT  // The driver will not wait for the GPU before mapping
+);
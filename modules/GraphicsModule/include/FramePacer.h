@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+
+struct GLFWwindow;
+
+/// <summary>
+/// Paces the game loop to a target frame rate, limits how many frames the GPU can fall behind by, and throttles the
+/// loop while the window is in the background
+///
+/// BeginFrame is called on the main thread at the very top of the loop, before events are polled. It waits until the
+/// next frame is due (sleeping for most of the wait, then spinning for the last little bit, since sleeps are only
+/// accurate to a millisecond or so), so that input is sampled as late as possible. Frames are scheduled on a fixed
+/// cadence, so one late frame doesn't push all of the following frames back
+///
+/// WaitForGpu and EndFrame are called on the thread that owns the context (see RenderThread). EndFrame drops a fence
+/// after each frame is presented, and WaitForGpu blocks until no more than MaxFramesInFlight frames are queued on
+/// the GPU, which bounds the input latency the driver's own queue can add
+///
+/// When the window loses focus or is minimised, the loop drops to IdleFps, waiting on window events so that it wakes
+/// up straight away when the window is brought back
+/// </summary>
+class FramePacer final
+{
+public:
+	/// <summary>
+	/// Pacing settings, can be changed at any time
+	/// </summary>
+	struct Settings {
+		float    TargetFps = 0.0f;        // The frame rate to pace to, 0 to run as fast as possible
+		uint32_t MaxFramesInFlight = 2;   // The most frames the GPU can be working on at once, 0 for no limit
+		bool     ThrottleWhenIdle = true; // Whether to drop to IdleFps when the window is unfocused or minimised
+		float    IdleFps = 10.0f;         // The frame rate to run at while idle
+		float    SpinMs = 1.0f;           // How long before a frame is due to stop sleeping and start spinning
+	};
+
+	/// <summary>
+	/// Timings from the most recent frames, for tuning and display
+	/// </summary>
+	struct Stats {
+		float    FrameMs = 0.0f;          // The time between the last two frames starting
+		float    PacingWaitMs = 0.0f;     // How long the main thread waited for the last frame to be due
+		float    GpuWaitMs = 0.0f;        // How long the context thread waited for the GPU in the last frame
+		float    InputToSubmitMs = 0.0f;  // From sampling input to the frame being handed to the driver
+		float    InputToPresentMs = 0.0f; // From sampling input to the GPU finishing the frame (an upper bound)
+		uint32_t FramesInFlight = 0;      // The number of frames the GPU was still working on after the last frame
+		bool     IsIdle = false;          // Whether the last frame was throttled
+	};
+
+	static void SetSettings(const Settings& settings);
+	static Settings GetSettings();
+
+	/// <summary>
+	/// Waits until the next frame is due, call at the very start of the frame on the main thread
+	/// </summary>
+	/// <param name="window">The window to check for focus</param>
+	/// <returns>The number of the frame that is starting, to be passed to EndFrame</returns>
+	static uint64_t BeginFrame(GLFWwindow* window);
+	/// <summary>
+	/// Waits until the GPU is working on less than MaxFramesInFlight frames, call on the thread that owns the context
+	/// before drawing a frame
+	/// </summary>
+	static void WaitForGpu();
+	/// <summary>
+	/// Marks the end of a frame, call on the thread that owns the context right after swapping buffers
+	/// </summary>
+	/// <param name="frame">The frame number that was returned by BeginFrame for this frame</param>
+	static void EndFrame(uint64_t frame);
+
+	/// <summary>
+	/// Gets the timings for the most recent frames, can be called from any thread
+	/// </summary>
+	static Stats GetStats();
+
+	/// <summary>
+	/// Releases any fences that are still waiting, call before destroying the context
+	/// </summary>
+	static void Shutdown();
+
+private:
+	FramePacer() = delete;
+
+	struct State;
+	static State& _GetState();
+	static bool _IsWindowIdle(GLFWwindow* window);
+	static void _WaitUntil(State& state, const Settings& settings, double target, GLFWwindow* window, bool isIdle);
+	static void _RetireFences(State& state, bool block);
+};
@@ -0,0 +1,115 @@
+#pragma once
+/*
+ * The GL tracer records every OpenGL call made through glad into a ring buffer, along with CPU timestamps,
+ * arguments and the subsystem that made the call, and flags calls that match known pipeline stall patterns
+ *
+ * The tracer is only compiled in when GL_TRACE_ENABLED is defined (generate the solution with
+ * "premake5 vs2019 --gl-trace"). Otherwise all of the GL_TRACE_* macros compile to nothing, and glad's
+ * function pointers are never touched, so there is no overhead at all
+ *
+ * Usage:
+ *    GL_TRACE_INSTALL();            // Once, directly after loading glad
+ *    GL_TRACE_BEGIN_FRAME();        // At the top of the frame loop
+ *    GL_TRACE_SCOPE("Post Effects") // Tags all GL calls until the end of the C++ scope
+ *    GL_TRACE_END_FRAME();          // After swapping buffers
+ *    GL_TRACE_DUMP("gl_trace.txt"); // Write the contents of the ring buffer to a file
+ */
+
+#ifdef GL_TRACE_ENABLED
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <string>
+
+/// <summary>
+/// Flags for the stall patterns that the tracer can detect
+/// </summary>
+enum GLTraceStall : uint8_t {
+	GLTraceStall_None          = 0,
+	GLTraceStall_Query         = 1 << 0, // glGet* or glIs* inside the frame loop, forces a sync with the driver thread
+	GLTraceStall_StateSave     = 1 << 1, // glGetIntegerv of bound program / VAO to save and restore state (ex: SpriteSheetQuad::Draw)
+	GLTraceStall_ReadAfterWrite= 1 << 2, // Reading back or mapping for read a buffer that was written this frame
+	GLTraceStall_RedundantBind = 1 << 3  // Binding an object that is already bound to the same slot
+};
+
+/// <summary>
+/// A single recorded GL call
+/// </summary>
+struct GLTraceEntry {
+	uint64_t    Frame;
+	int64_t     StartNs;    // CPU time the call started, relative to when the tracer was installed
+	int64_t     DurationNs; // CPU time spent in the call
+	const char* Function;
+	const char* Subsystem;
+	uint64_t    Args[6];
+	uint8_t     ArgCount;
+	uint8_t     FloatMask;  // Bit N is set if argument N is a floating point value (stored as the bits of a double)
+	uint8_t     Stalls;     // Combination of GLTraceStall flags
+	uint8_t     Kind;       // Internal, used by the stall detector
+};
+
+/// <summary>
+/// Static class that manages the GL call tracer
+/// </summary>
+class GLTrace final {
+public:
+	/// <summary>
+	/// Replaces glad's function pointers with tracing wrappers, must be called after glad is loaded
+	/// </summary>
+	/// <param name="capacity">The number of calls to keep in the ring buffer</param>
+	static void Install(size_t capacity = 1 << 16);
+
+	static void BeginFrame();
+	static void EndFrame();
+
+	/// <summary>
+	/// Writes all the calls in the ring buffer to a file, oldest first, followed by a summary of detected stalls
+	/// </summary>
+	/// <param name="path">The path of the file to write to</param>
+	/// <returns>True if the file was written</returns>
+	static bool Dump(const std::string& path);
+
+	/// <summary>
+	/// Gets the number of calls flagged with the given stall pattern during the last completed frame
+	/// </summary>
+	static uint32_t GetLastFrameStallCount(GLTraceStall stall);
+	/// <summary>
+	/// Gets the number of GL calls made during the last completed frame
+	/// </summary>
+	static uint32_t GetLastFrameCallCount();
+
+	/// <summary>
+	/// Tags all GL calls on this thread with a subsystem name until the scope ends
+	/// </summary>
+	struct Scope {
+		Scope(const char* name);
+		~Scope();
+		const char* Previous;
+	};
+
+	// Used by the generated wrappers, do not call directly
+	static GLTraceEntry& _BeginCall(const char* function, uint8_t kind);
+	static void _EndCall(GLTraceEntry& entry);
+
+private:
+	GLTrace() = delete;
+};
+
+#define GL_TRACE_CONCAT_(a, b) a##b
+#define GL_TRACE_CONCAT(a, b) GL_TRACE_CONCAT_(a, b)
+
+#define GL_TRACE_INSTALL() GLTrace::Install()
+#define GL_TRACE_BEGIN_FRAME() GLTrace::BeginFrame()
+#define GL_TRACE_END_FRAME() GLTrace::EndFrame()
+#define GL_TRACE_SCOPE(name) GLTrace::Scope GL_TRACE_CONCAT(__glTraceScope, __LINE__)(name)
+#define GL_TRACE_DUMP(path) GLTrace::Dump(path)
+
+#else
+
+#define GL_TRACE_INSTALL()
+#define GL_TRACE_BEGIN_FRAME()
+#define GL_TRACE_END_FRAME()
+#define GL_TRACE_SCOPE(name)
+#define GL_TRACE_DUMP(path)
+
+#endif
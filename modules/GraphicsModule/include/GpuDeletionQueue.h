@@ -0,0 +1,81 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <mutex>
+
+/// <summary>
+/// The types of OpenGL objects that can be released through the GpuDeletionQueue
+/// </summary>
+enum class GpuResourceType : uint8_t {
+	Buffer       = 0,
+	Texture      = 1,
+	VertexArray  = 2,
+	Framebuffer  = 3,
+	Renderbuffer = 4,
+	Program      = 5,
+	Query        = 6,
+	Count        = 7
+};
+
+/// <summary>
+/// Defers the destruction of OpenGL objects until the GPU is guaranteed to be done with them
+/// 
+/// Destructors enqueue their handles instead of deleting them directly (this is safe from any thread). Once per
+/// frame, EndFrame moves everything that was enqueued into a batch guarded by a fence. A batch is only released
+/// once it is at least FrameLatency frames old and it's fence has signaled, and each resource type is deleted
+/// with a single glDelete* call
+/// </summary>
+class GpuDeletionQueue final
+{
+public:
+	/// <summary>
+	/// Enqueues an OpenGL object to be deleted once the GPU is done with it. Can be called from any thread
+	/// </summary>
+	/// <param name="type">The type of object the handle refers to</param>
+	/// <param name="handle">The handle to release, 0 will be ignored</param>
+	static void Enqueue(GpuResourceType type, GLuint handle);
+	/// <summary>
+	/// Enqueues a fence sync object to be deleted once the GPU is done with it. Can be called from any thread
+	/// </summary>
+	/// <param name="sync">The sync object to release, nullptr will be ignored</param>
+	static void Enqueue(GLsync sync);
+
+	/// <summary>
+	/// Closes the current batch of deletions behind a fence, and releases any old batches that the GPU has
+	/// finished with. Must be called once per frame from the thread that owns the GL context (ex: after swapping)
+	/// </summary>
+	static void EndFrame();
+	/// <summary>
+	/// Waits for the GPU to go idle and releases everything in the queue. Call this before destroying the context
+	/// </summary>
+	static void Flush();
+
+	/// <summary>
+	/// Sets the minimum number of frames to wait before releasing a batch (default is 2)
+	/// </summary>
+	static void SetFrameLatency(uint32_t frames) { _frameLatency = frames; }
+	/// <summary>
+	/// Gets the number of handles waiting to be released
+	/// </summary>
+	static size_t GetPendingCount();
+
+private:
+	GpuDeletionQueue() = delete;
+
+	struct Batch {
+		GLsync   Fence = nullptr;
+		uint64_t Frame = 0;
+		std::vector<GLuint> Handles[(size_t)GpuResourceType::Count];
+		std::vector<GLsync> Syncs;
+	};
+
+	static void _Release(Batch& batch);
+
+	static std::mutex _mutex;
+	static Batch _pending;
+	static std::deque<Batch> _inFlight;
+	static uint64_t _frame;
+	static uint32_t _frameLatency;
+};
@@ -0,0 +1,135 @@
+#pragma once
+#include <glad/glad.h>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/// <summary>
+/// Measures how much GPU time is spent in named, nested regions of a frame using GL_TIMESTAMP queries
+/// 
+/// Queries are written into one of several per-frame query sets, and a set is only read back when we come
+/// around to reuse it a few frames later. If the results are still not available at that point the sample is
+/// dropped rather than waiting, so reading results never stalls the pipeline
+/// </summary>
+class GpuProfiler final
+{
+public:
+	/// <summary>
+	/// The timing results for a single region
+	/// </summary>
+	struct RegionStats {
+		std::string Name;
+		std::string Path;      // The names of all the parent regions and this region, separated by '/'
+		int         Depth;     // The nesting depth of the region, 0 for top level regions
+		float       LastMs;    // The GPU time for the most recently resolved frame
+		float       AverageMs; // The rolling average over the last SampleCount resolved frames
+	};
+
+	/// <summary>
+	/// The number of frames that the rolling averages are calculated over
+	/// </summary>
+	static const int SampleCount = 64;
+	/// <summary>
+	/// The number of query sets that we cycle through, this is how many frames old results are when read
+	/// </summary>
+	static const int FrameLatency = 3;
+
+	/// <summary>
+	/// Starts a new frame, resolving the results of the frame that used this query set if they are ready
+	/// </summary>
+	static void BeginFrame();
+	/// <summary>
+	/// Ends the current frame, all regions must be closed
+	/// </summary>
+	static void EndFrame();
+
+	/// <summary>
+	/// Opens a new timing region, nested inside the currently open region if there is one
+	/// </summary>
+	/// <param name="name">The name of the region, should be the same from frame to frame</param>
+	static void BeginRegion(const std::string& name);
+	/// <summary>
+	/// Closes the most recently opened region
+	/// </summary>
+	static void EndRegion();
+
+	/// <summary>
+	/// Gets the stats for all the regions in the most recently resolved frame, in the order they were opened
+	/// (so parents will always be directly followed by their children). Only safe to use from the thread that
+	/// owns the context, other threads should use CopyResults
+	/// </summary>
+	static const std::vector<RegionStats>& GetResults() { return _results; }
+	/// <summary>
+	/// Gets a copy of the results, can be called from any thread (ex: when rendering on a render thread)
+	/// </summary>
+	static std::vector<RegionStats> CopyResults();
+	/// <summary>
+	/// Gets the number of frames that were dropped because their results were not ready in time, can be called
+	/// from any thread
+	/// </summary>
+	static uint64_t GetDroppedSamples() { return _droppedSamples.load(std::memory_order_relaxed); }
+
+	/// <summary>
+	/// Enables or disables the profiler, when disabled no queries are issued
+	/// </summary>
+	static void SetEnabled(bool enabled) { _enabled = enabled; }
+	static bool IsEnabled() { return _enabled; }
+
+	/// <summary>
+	/// Releases all of the query objects, call before destroying the context
+	/// </summary>
+	static void Shutdown();
+
+private:
+	GpuProfiler() = delete;
+
+	struct Region {
+		std::string Name;
+		std::string Path;
+		int         Depth;
+		GLuint      BeginQuery;
+		GLuint      EndQuery;
+	};
+
+	struct FrameData {
+		std::vector<Region> Regions;
+		std::vector<GLuint> Queries;
+		size_t QueriesUsed = 0;
+		bool   Pending = false;
+	};
+
+	struct History {
+		float Samples[SampleCount] = { 0 };
+		int   Count = 0;
+		int   Next = 0;
+		float Sum = 0.0f;
+	};
+
+	static GLuint _NextQuery(FrameData& frame);
+	static void _Resolve(FrameData& frame);
+
+	static bool _enabled;
+	static uint64_t _frameIndex;
+	static FrameData _frames[FrameLatency];
+	static std::vector<size_t> _openRegions;
+	static std::unordered_map<std::string, History> _history;
+	static std::vector<RegionStats> _results;
+	// Guards _results while they are being rebuilt
+	static std::mutex _resultsMutex;
+	static std::atomic<uint64_t> _droppedSamples;
+};
+
+/// <summary>
+/// Times all GPU work submitted until the end of the C++ scope
+/// </summary>
+struct GpuProfileScope {
+	GpuProfileScope(const std::string& name) { GpuProfiler::BeginRegion(name); }
+	~GpuProfileScope() { GpuProfiler::EndRegion(); }
+};
+
+#define GPU_PROFILE_CONCAT_(a, b) a##b
+#define GPU_PROFILE_CONCAT(a, b) GPU_PROFILE_CONCAT_(a, b)
+#define GPU_PROFILE_SCOPE(name) GpuProfileScope GPU_PROFILE_CONCAT(__gpuProfileScope, __LINE__)(name)
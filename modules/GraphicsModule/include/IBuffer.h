@@ -1,5 +1,7 @@
 #pragma once
 #include <glad/glad.h>
+#include "BufferEnums.h"
+#include "Logging.h"
 
 /// <summary>
 /// This is our abstract base class for all our OpenGL buffer types
@@ -38,6 +40,95 @@ public:
 		IBuffer::LoadData((const void*)(data), sizeof(T), count);
 	}
 
+	/// <summary>
+	/// Allocates immutable storage for this buffer using glNamedBufferStorage. The size of an immutable buffer can
+	/// never change, so LoadData may not be used afterwards. Use UpdateRange or mapping to change the contents
+	/// </summary>
+	/// <param name="data">The initial contents of the buffer, or nullptr to leave it uninitialized</param>
+	/// <param name="elementSize">The size of a single element, in bytes</param>
+	/// <param name="elementCount">The number of elements to allocate storage for</param>
+	/// <param name="flags">The storage flags, must include DynamicStorage to use UpdateRange, or the map flags to use mapping</param>
+	void AllocateStorage(const void* data, size_t elementSize, size_t elementCount, BufferStorageFlags flags);
+	/// <summary>
+	/// Allocates immutable storage for this buffer using glNamedBufferStorage
+	/// </summary>
+	/// <typeparam name="T">The type of elements that will be stored in the buffer</typeparam>
+	/// <param name="data">A pointer to the initial elements, or nullptr to leave the buffer uninitialized</param>
+	/// <param name="count">The number of elements to allocate storage for</param>
+	/// <param name="flags">The storage flags for the buffer</param>
+	template <typename T>
+	void AllocateStorage(const T* data, size_t count, BufferStorageFlags flags) {
+		AllocateStorage((const void*)(data), sizeof(T), count, flags);
+	}
+
+	/// <summary>
+	/// Updates a range of elements in this buffer, without re-allocating it, using glNamedBufferSubData
+	/// </summary>
+	/// <param name="data">The data to copy into the buffer</param>
+	/// <param name="elementOffset">The index of the first element to overwrite</param>
+	/// <param name="elementCount">The number of elements to overwrite</param>
+	void UpdateRange(const void* data, size_t elementOffset, size_t elementCount);
+	/// <summary>
+	/// Updates a range of elements in this buffer, without re-allocating it, using glNamedBufferSubData
+	/// </summary>
+	/// <typeparam name="T">The type of data you are uploading, should match the element size of the buffer</typeparam>
+	/// <param name="data">A pointer to the first element to upload</param>
+	/// <param name="elementOffset">The index of the first element to overwrite</param>
+	/// <param name="count">The number of elements to overwrite</param>
+	template <typename T>
+	void UpdateRange(const T* data, size_t elementOffset, size_t count) {
+		LOG_ASSERT(sizeof(T) == _elementSize, "Element size does not match the buffer!");
+		UpdateRange((const void*)(data), elementOffset, count);
+	}
+
+	/// <summary>
+	/// Orphans the contents of this buffer, so that the driver can hand us fresh memory instead of waiting
+	/// for the GPU to finish reading the old contents. Mutable buffers are re-specified with the same size,
+	/// immutable buffers are invalidated
+	/// </summary>
+	void Orphan();
+
+	/// <summary>
+	/// Maps a range of bytes in this buffer into client memory
+	/// </summary>
+	/// <param name="offset">The offset into the buffer in bytes</param>
+	/// <param name="length">The number of bytes to map</param>
+	/// <param name="flags">The access flags for the mapping</param>
+	/// <returns>A pointer to the mapped memory, or nullptr if the mapping failed</returns>
+	void* MapRange(size_t offset, size_t length, BufferMapFlags flags);
+	/// <summary>
+	/// Maps this entire buffer into client memory
+	/// </summary>
+	/// <param name="flags">The access flags for the mapping</param>
+	/// <returns>A pointer to the mapped memory, or nullptr if the mapping failed</returns>
+	void* Map(BufferMapFlags flags) { return MapRange(0, GetTotalSize(), flags); }
+	/// <summary>
+	/// Maps this entire buffer persistently for writing. The buffer must have been created with AllocateStorage
+	/// using the MapWrite and MapPersistent flags (and MapCoherent if coherent is true). The mapping remains valid
+	/// while the buffer is used for drawing, it is up to the caller to avoid writing to regions the GPU is reading
+	/// </summary>
+	/// <param name="coherent">True if writes should be visible without flushing, false to use FlushRange</param>
+	/// <returns>A pointer to the mapped memory, or nullptr if the mapping failed</returns>
+	void* MapPersistent(bool coherent = true);
+	/// <summary>
+	/// Flushes a range of a buffer mapped with the FlushExplicit flag, making the writes visible to the GPU
+	/// </summary>
+	/// <param name="offset">The offset in bytes, relative to the start of the mapped range</param>
+	/// <param name="length">The number of bytes to flush</param>
+	void FlushRange(size_t offset, size_t length);
+	/// <summary>
+	/// Unmaps this buffer if it is mapped
+	/// </summary>
+	void Unmap();
+	/// <summary>
+	/// Gets the pointer to the currently mapped region of this buffer, or nullptr if it is not mapped
+	/// </summary>
+	void* GetMappedPointer() const { return _mappedPtr; }
+	/// <summary>
+	/// Returns true if this buffer was created with immutable storage via AllocateStorage
+	/// </summary>
+	bool IsImmutable() const { return _isImmutable; }
+
 	/// <summary>
 	/// Returns the number of elements that are loaded into this buffer
 	/// </summary>
@@ -86,4 +177,7 @@ protected:
 	GLuint _handle; // The OpenGL handle for the underlying buffer
 	GLenum _usage; // The buffer usage mode (GL_STATIC_DRAW, GL_DYNAMIC_DRAW)
 	GLenum _type; // The buffer type (ex GL_ARRAY_BUFFER, GL_ARRAY_ELEMENT_BUFFER)
+	bool   _isImmutable; // True if the storage was allocated with glNamedBufferStorage
+	BufferStorageFlags _storageFlags; // The flags the immutable storage was allocated with
+	void*  _mappedPtr; // The pointer to the mapped region of the buffer, or nullptr if not mapped
 };
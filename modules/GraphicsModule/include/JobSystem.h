@@ -0,0 +1,196 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/// <summary>
+/// Tracks a set of jobs that have been handed to the JobSystem. The counter goes up when a job is queued against it,
+/// and down when that job finishes, so it is done when it reaches zero. Jobs can also be queued to start once a
+/// counter is done (see JobSystem::Run)
+///
+/// A counter must not be destroyed while jobs are still queued against it, wait on it first
+/// </summary>
+class JobCounter final
+{
+public:
+	JobCounter() : _pending(0), _deferred(std::vector<Deferred>()) {}
+	~JobCounter();
+
+	JobCounter(const JobCounter& other) = delete;
+	JobCounter& operator =(const JobCounter& other) = delete;
+
+	/// <summary>
+	/// Checks whether every job queued against this counter has finished
+	/// </summary>
+	bool IsDone() const { return _pending.load(std::memory_order_acquire) == 0; }
+	/// <summary>
+	/// Gets the number of jobs that are queued or running against this counter
+	/// </summary>
+	uint32_t GetPending() const { return _pending.load(std::memory_order_acquire); }
+
+private:
+	friend class JobSystem;
+
+	// A job that is waiting for this counter to be done before it can be queued
+	struct Deferred {
+		std::function<void()> Func;
+		JobCounter*           Counter;
+	};
+
+	std::atomic<uint32_t> _pending;
+	// Guards the deferred jobs, and the last release of the counter
+	std::mutex _mutex;
+	std::vector<Deferred> _deferred;
+};
+
+/// <summary>
+/// A work-stealing job system, shared by everything in the engine that wants to spread work across threads
+///
+/// Each worker thread has it's own queue. Workers push and pop jobs at the back of their own queue (so the most
+/// recent, cache-warm work runs first) and steal from the front of the other queues when theirs is empty. Threads
+/// that are not workers (the main thread, the render thread, etc) share one extra queue. Idle workers sleep until
+/// there is something to steal
+///
+/// Threads never block while waiting on jobs, Wait and ParallelFor run other queued jobs until the work they are
+/// waiting on is done. Because of that, jobs should not block on anything other than other jobs (file IO and the
+/// like belong on their own thread)
+///
+/// The workers are started the first time a job is queued, or with Init. Shutdown should be called before exiting
+/// </summary>
+class JobSystem final
+{
+public:
+	typedef std::function<void()> JobFunc;
+
+	/// <summary>
+	/// Counts of the work the system has done since it was started, for tuning and display
+	/// </summary>
+	struct Stats {
+		uint64_t Executed = 0; // The number of jobs that have been run
+		uint64_t Stolen = 0;   // The number of jobs that were run by a thread other than the one that queued them
+	};
+
+	/// <summary>
+	/// Starts the worker threads, does nothing if they are already running
+	/// </summary>
+	/// <param name="workerCount">The number of worker threads, or 0 to use one less than the number of hardware threads</param>
+	static void Init(size_t workerCount = 0);
+	/// <summary>
+	/// Runs everything left in the queues and stops the worker threads. Should be called from the same thread as Init
+	/// </summary>
+	static void Shutdown();
+	/// <summary>
+	/// Checks whether the worker threads are running
+	/// </summary>
+	static bool IsRunning();
+	/// <summary>
+	/// Gets the number of worker threads (not including threads that help while they wait)
+	/// </summary>
+	static size_t GetWorkerCount();
+
+	/// <summary>
+	/// Queues a job. Can be called from any thread, including from inside another job
+	/// </summary>
+	/// <param name="job">The job to run, anything it references must outlive it</param>
+	/// <param name="counter">An optional counter to track the job with</param>
+	static void Run(JobFunc&& job, JobCounter* counter = nullptr);
+	/// <summary>
+	/// Queues a job that only starts once another counter is done. The job is tracked by counter straight away, so
+	/// waiting on counter will wait for it even if it hasn't started
+	/// </summary>
+	/// <param name="job">The job to run, anything it references must outlive it</param>
+	/// <param name="counter">An optional counter to track the job with</param>
+	/// <param name="after">The counter that must be done before the job starts</param>
+	static void Run(JobFunc&& job, JobCounter* counter, JobCounter& after);
+	/// <summary>
+	/// Runs other jobs until the given counter is done
+	/// </summary>
+	static void Wait(JobCounter& counter);
+	/// <summary>
+	/// Runs a single queued job if there is one, for threads that want to help out while they wait on something
+	/// </summary>
+	/// <returns>True if a job was run</returns>
+	static bool TryRunOne();
+
+	/// <summary>
+	/// Splits the range [0, count) into chunks and processes them across the workers, returning once every chunk has
+	/// been processed. The calling thread processes chunks as well
+	/// </summary>
+	/// <param name="count">The number of items to process</param>
+	/// <param name="chunkSize">The number of items to hand out at a time</param>
+	/// <param name="func">Invoked with the first and one past the last index of each chunk</param>
+	static void ParallelFor(size_t count, size_t chunkSize, const std::function<void(size_t, size_t)>& func);
+	/// <summary>
+	/// Invokes func on every element of an array, split into chunks across the workers (see ParallelFor)
+	/// </summary>
+	/// <param name="data">The first element to process</param>
+	/// <param name="count">The number of elements to process</param>
+	/// <param name="chunkSize">The number of elements to hand out at a time</param>
+	/// <param name="func">A callable with the signature void(T&)</param>
+	template <typename T, typename Func>
+	static void ParallelForEach(T* data, size_t count, size_t chunkSize, const Func& func) {
+		ParallelFor(count, chunkSize, [data, &func](size_t first, size_t last) {
+			for (size_t ix = first; ix < last; ix++) {
+				func(data[ix]);
+			}
+		});
+	}
+
+	/// <summary>
+	/// Gets the totals since the workers were started
+	/// </summary>
+	static Stats GetStats();
+
+private:
+	JobSystem() = delete;
+
+	struct Job {
+		JobFunc     Func;
+		JobCounter* Counter;
+	};
+	struct Queue;
+	struct State;
+
+	static State& _GetState();
+	static void _Push(JobFunc&& job, JobCounter* counter);
+	static bool _RunOne(State& state, size_t queue);
+	static void _Execute(Job& job);
+	static void _Release(JobCounter* counter);
+	static void _WorkerLoop(size_t queue);
+};
+
+/// <summary>
+/// A scoped set of jobs, that waits for all of it's jobs to finish before it goes out of scope
+/// </summary>
+class TaskGroup final
+{
+public:
+	TaskGroup() : _counter() {}
+	~TaskGroup() { Wait(); }
+
+	TaskGroup(const TaskGroup& other) = delete;
+	TaskGroup& operator =(const TaskGroup& other) = delete;
+
+	/// <summary>
+	/// Queues a job as part of this group
+	/// </summary>
+	void Run(JobSystem::JobFunc&& job) { JobSystem::Run(std::move(job), &_counter); }
+	/// <summary>
+	/// Queues a job as part of this group, that only starts once another counter is done
+	/// </summary>
+	void RunAfter(JobCounter& after, JobSystem::JobFunc&& job) { JobSystem::Run(std::move(job), &_counter, after); }
+	/// <summary>
+	/// Runs other jobs until every job in the group has finished
+	/// </summary>
+	void Wait() { JobSystem::Wait(_counter); }
+
+	/// <summary>
+	/// Gets the counter tracking the group, so other jobs can be made to start after it
+	/// </summary>
+	JobCounter& GetCounter() { return _counter; }
+
+private:
+	JobCounter _counter;
+};
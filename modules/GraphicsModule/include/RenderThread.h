@@ -0,0 +1,117 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+
+struct GLFWwindow;
+
+/// <summary>
+/// Runs OpenGL work on a dedicated thread that owns the context, so that the main thread can simulate and build
+/// the next frame while the last one is being submitted
+///
+/// All GL work goes through a single queue, and runs in the order it was queued. Frames are queued with
+/// SubmitFrame, anything queued with Enqueue while a frame is being built runs before that frame. The render
+/// thread runs at most one frame behind: BeginFrame blocks until there is no more than one frame waiting, so two
+/// snapshots are enough to hand frames over (one being built by the main thread, one being rendered)
+///
+/// When the thread is not running, everything runs immediately on the calling thread, which is the same as not
+/// having a render thread at all
+/// </summary>
+class RenderThread final
+{
+public:
+	typedef std::function<void()> Command;
+
+	/// <summary>
+	/// Timings for the last frame, for tuning and display
+	/// </summary>
+	struct Stats {
+		float    RenderMs = 0.0f; // How long the render thread spent running the last frame
+		float    IdleMs = 0.0f;   // How long the render thread waited for the last frame to be submitted
+		float    WaitMs = 0.0f;   // How long the main thread waited in BeginFrame for the render thread to catch up
+		uint64_t Frames = 0;      // The number of frames that have been rendered
+	};
+
+	/// <summary>
+	/// Hands the window's GL context over to a new render thread. The context must be current on the calling
+	/// thread, and will not be current on it until Stop is called
+	/// </summary>
+	static void Start(GLFWwindow* window);
+	/// <summary>
+	/// Runs everything left in the queue, stops the render thread and makes the context current on the calling
+	/// thread again. Does nothing if the thread is not running
+	/// </summary>
+	static void Stop();
+	/// <summary>
+	/// Checks whether the render thread is running (if not, all GL work runs on the calling thread)
+	/// </summary>
+	static bool IsRunning();
+	/// <summary>
+	/// Checks whether the calling thread is the render thread
+	/// </summary>
+	static bool IsRenderThread();
+
+	/// <summary>
+	/// Queues some GL work to run before the next frame. Anything the command uses must either be captured by value
+	/// or only be touched by the render thread
+	/// </summary>
+	static void Enqueue(Command&& command);
+	/// <summary>
+	/// Runs some GL work on the render thread and waits for the result, for things like creating resources that
+	/// are needed right away. This has to wait for anything that is already queued, so it should be used sparingly
+	/// </summary>
+	/// <param name="func">A callable with no arguments, it's result (if any) is returned</param>
+	template <typename Func>
+	static auto Call(Func&& func) -> decltype(func()) {
+		typedef decltype(func()) Result;
+		if (!IsRunning() || IsRenderThread()) {
+			return func();
+		}
+		// std::function needs to be copyable, so the task gets shared with the command
+		std::shared_ptr<std::packaged_task<Result()>> task = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(func));
+		std::future<Result> result = task->get_future();
+		Enqueue([task]() { (*task)(); });
+		return result.get();
+	}
+
+	/// <summary>
+	/// Waits until there is at most one frame waiting to be rendered, should be called before the main thread
+	/// starts filling in a frame's snapshot
+	/// </summary>
+	/// <returns>The index of the snapshot to fill in (0 or 1)</returns>
+	static uint32_t BeginFrame();
+	/// <summary>
+	/// Queues a frame to be rendered, the frame should only use the snapshot returned by BeginFrame and resources
+	/// that only the render thread touches
+	/// </summary>
+	static void SubmitFrame(Command&& frame);
+	/// <summary>
+	/// Waits for everything in the queue to finish
+	/// </summary>
+	static void WaitIdle();
+
+	/// <summary>
+	/// Gets the number of the frame that is being built, ie. the frame that the next SubmitFrame will queue. Frames
+	/// are numbered from 1, so anything that the frame being built might use is safe to release once
+	/// GetCompletedFrames reaches this number
+	/// </summary>
+	static uint64_t GetBuildingFrame();
+	/// <summary>
+	/// Gets the number of frames that have finished rendering
+	/// </summary>
+	static uint64_t GetCompletedFrames();
+
+	/// <summary>
+	/// Gets the timings for the last frame
+	/// </summary>
+	static Stats GetStats();
+
+private:
+	RenderThread() = delete;
+
+	struct State;
+	static State& _GetState();
+	static void _ThreadLoop(GLFWwindow* window);
+};
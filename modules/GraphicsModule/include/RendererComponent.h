@@ -1,12 +1,28 @@
 #pragma once
+#include <type_traits>
 #include <VertexArrayObject.h>
 #include <ShaderMaterial.h>
+#include <ResourcePool.h>
 
+typedef ResourceHandle<VertexArrayObject> MeshHandle;
+typedef ResourceHandle<ShaderMaterial> MaterialHandle;
+
+/// <summary>
+/// Draws a mesh with a material. The mesh and material are referred to by handle (see ResourcePool), so renderers
+/// can be copied and sorted without touching any reference counts
+/// </summary>
 class RendererComponent {
 public:
-	VertexArrayObject::sptr Mesh;
-	ShaderMaterial::sptr    Material;
+	MeshHandle     Mesh;
+	MaterialHandle Material;
+
+	RendererComponent& SetMesh(const VertexArrayObject::sptr& mesh) { Mesh = ResourcePool<VertexArrayObject>::Add(mesh); return *this; }
+	RendererComponent& SetMaterial(const ShaderMaterial::sptr& material) { Material = ResourcePool<ShaderMaterial>::Add(material); return *this; }
+	RendererComponent& SetMesh(MeshHandle mesh) { Mesh = mesh; return *this; }
+	RendererComponent& SetMaterial(MaterialHandle material) { Material = material; return *this; }
+
+	VertexArrayObject* GetMesh() const { return ResourcePool<VertexArrayObject>::Get(Mesh); }
+	ShaderMaterial* GetMaterial() const { return ResourcePool<ShaderMaterial>::Get(Material); }
+};
 
-	RendererComponent& SetMesh(const VertexArrayObject::sptr& mesh) { Mesh = mesh; return *this; }
-	RendererComponent& SetMaterial(const ShaderMaterial::sptr& material) { Material = material; return *this; }
-};
\ No newline at end of file
+static_assert(std::is_trivially_copyable<RendererComponent>::value, "Renderers should stay trivially copyable");
@@ -0,0 +1,330 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+#include "Logging.h"
+#include "RenderThread.h"
+
+// Stale handle detection is on by default in debug builds
+#if defined(_DEBUG) && !defined(RESOURCE_POOL_VALIDATE)
+#define RESOURCE_POOL_VALIDATE 1
+#endif
+
+/// <summary>
+/// A 32 bit reference to a resource in a ResourcePool, made up of the index of the resource's slot and the
+/// generation of the slot when the handle was made. When a resource is released it's slot's generation is bumped, so
+/// any handles to it that are still around are detected as stale instead of finding whatever took the slot next
+///
+/// Handles are plain values, so anything holding them can be copied around without touching reference counts. A
+/// default constructed handle is null
+/// </summary>
+/// <typeparam name="T">The type of resource the handle refers to</typeparam>
+template <typename T>
+struct ResourceHandle {
+	static constexpr uint32_t IndexBits = 20;
+	static constexpr uint32_t IndexMask = (1u << IndexBits) - 1;
+	static constexpr uint32_t MaxGeneration = (1u << (32 - IndexBits)) - 1;
+
+	// Generations start at 1, so 0 is never a valid handle
+	uint32_t Value = 0;
+
+	uint32_t Index() const { return Value & IndexMask; }
+	uint32_t Generation() const { return Value >> IndexBits; }
+	bool IsNull() const { return Value == 0; }
+
+	bool operator ==(const ResourceHandle& other) const { return Value == other.Value; }
+	bool operator !=(const ResourceHandle& other) const { return Value != other.Value; }
+
+	static ResourceHandle Make(uint32_t index, uint32_t generation) {
+		ResourceHandle result;
+		result.Value = (generation << IndexBits) | (index & IndexMask);
+		return result;
+	}
+};
+
+/// <summary>
+/// Owns all of the resources of a given type, and hands out generational handles to them. Resources stay alive
+/// until they are removed from the pool (or the pool is cleared), no matter how many handles refer to them
+///
+/// Frames that were already built may still draw with a resource after it is removed, so removing only retires it's
+/// slot, tagged with the frame that is being built (see RenderThread::GetBuildingFrame). The slot keeps resolving
+/// until ReleaseRetired sees that frame has finished rendering, then the pool drops it's reference and the slot's
+/// handles go stale. RemoveUnused retires everything that nothing refers to any more, so resources are freed when
+/// the last renderer using them goes away
+///
+/// Lookups are lock free and can happen from any thread, even while resources are being added. Adding, removing and
+/// releasing is guarded by a lock. Releasing should happen on the thread that builds frames, between frames, so
+/// nothing is looking up a slot while it goes away
+///
+/// With RESOURCE_POOL_VALIDATE, looking up a handle that is stale (ie. it's resource was released) asserts
+/// </summary>
+/// <typeparam name="T">The type of resource to store</typeparam>
+template <typename T>
+class ResourcePool final {
+public:
+	typedef ResourceHandle<T> Handle;
+
+	/// <summary>
+	/// Adds a resource to the pool, if it's already in the pool the existing handle is returned (and if it was
+	/// removed but not released yet, it is kept after all)
+	/// </summary>
+	/// <returns>A handle to the resource, or a null handle if resource is nullptr</returns>
+	static Handle Add(const std::shared_ptr<T>& resource) {
+		if (resource == nullptr) {
+			return Handle();
+		}
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto it = _lookup.find(resource.get());
+		if (it != _lookup.end()) {
+			// Any entry left in the retired list is skipped once the frames don't match
+			_GetSlot(it->second.Index()).RetireFrame = 0;
+			return it->second;
+		}
+
+		uint32_t index;
+		if (!_freeList.empty()) {
+			index = _freeList.back();
+			_freeList.pop_back();
+		} else {
+			index = _slotCount.load(std::memory_order_relaxed);
+			LOG_ASSERT(index <= Handle::IndexMask, "Too many resources in the {} pool", typeid(T).name());
+			// Slots live in chunks that never move, that way lookups don't need the lock
+			if (_chunks[index >> ChunkBits].load(std::memory_order_relaxed) == nullptr) {
+				_ownedChunks.push_back(std::make_unique<Slot[]>(ChunkSize));
+				_chunks[index >> ChunkBits].store(_ownedChunks.back().get(), std::memory_order_release);
+			}
+			_slotCount.store(index + 1, std::memory_order_release);
+		}
+
+		Slot& slot = _GetSlot(index);
+		slot.Owner = resource;
+		slot.Resource.store(resource.get(), std::memory_order_release);
+		const Handle result = Handle::Make(index, slot.Generation.load(std::memory_order_relaxed));
+		_lookup[resource.get()] = result;
+		return result;
+	}
+
+	/// <summary>
+	/// Finds the handle for a resource that is already in the pool
+	/// </summary>
+	/// <returns>The resource's handle, or a null handle if it is not in the pool</returns>
+	static Handle Find(const T* resource) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto it = _lookup.find(resource);
+		return it != _lookup.end() ? it->second : Handle();
+	}
+
+	/// <summary>
+	/// Checks whether a handle refers to a resource that has not been released
+	/// </summary>
+	static bool IsValid(Handle handle) {
+		return _Resolve(handle) != nullptr;
+	}
+
+	/// <summary>
+	/// Gets the resource a handle refers to
+	/// </summary>
+	/// <returns>The resource, or nullptr if the handle is null or stale</returns>
+	static T* Get(Handle handle) {
+		T* result = _Resolve(handle);
+		#if RESOURCE_POOL_VALIDATE
+		LOG_ASSERT(result != nullptr || handle.IsNull(), "Stale {} handle (index {}, generation {})", typeid(T).name(), handle.Index(), handle.Generation());
+		#endif
+		return result;
+	}
+
+	/// <summary>
+	/// Gets a shared reference to the resource a handle refers to, for handing it to code that still works with
+	/// shared pointers (ex: the AssetLibrary)
+	/// </summary>
+	/// <returns>The resource, or nullptr if the handle is null or stale</returns>
+	static std::shared_ptr<T> GetShared(Handle handle) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _Resolve(handle) != nullptr ? _GetSlot(handle.Index()).Owner : nullptr;
+	}
+
+	/// <summary>
+	/// Removes a resource from the pool. It is released (and any handles to it become stale) once the frame that is
+	/// being built has finished rendering. Does nothing if the handle is already stale
+	/// </summary>
+	static void Remove(Handle handle) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_Resolve(handle) != nullptr) {
+			_Retire(handle.Index(), RenderThread::GetBuildingFrame());
+		}
+	}
+
+	/// <summary>
+	/// Removes every resource that isn't marked as used, and that nothing outside of the pool holds a shared
+	/// reference to (ex: the AssetLibrary). Like Remove, they are released once the frame being built is done
+	/// </summary>
+	/// <param name="isUsed">Indexed by slot index, true for the slots that are referred to by handles that are still around</param>
+	/// <returns>The number of resources that were removed</returns>
+	static size_t RemoveUnused(const std::vector<bool>& isUsed) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		const uint64_t frame = RenderThread::GetBuildingFrame();
+		const uint32_t count = _slotCount.load(std::memory_order_relaxed);
+		size_t result = 0;
+		for (uint32_t ix = 0; ix < count; ix++) {
+			Slot& slot = _GetSlot(ix);
+			if (slot.Owner == nullptr || slot.RetireFrame != 0 || (ix < isUsed.size() && isUsed[ix]) || slot.Owner.use_count() > 1) {
+				continue;
+			}
+			_Retire(ix, frame);
+			result++;
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// Releases the resources that were removed before a frame that has finished rendering. Should be called once
+	/// per frame on the thread that builds frames, before anything looks up resources for the new frame
+	/// </summary>
+	/// <returns>The number of resources that were released</returns>
+	static size_t ReleaseRetired() {
+		const uint64_t completed = RenderThread::GetCompletedFrames();
+		std::vector<std::shared_ptr<T>> owners;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			// Slots are retired in frame order, so we can stop at the first one that may still be drawn
+			while (!_retired.empty()) {
+				const Retired& front = _retired.front();
+				Slot& slot = _GetSlot(front.Index);
+				if (slot.RetireFrame == front.Frame) {
+					if (front.Frame > completed) {
+						break;
+					}
+					owners.push_back(_Free(front.Index));
+				}
+				_retired.pop_front();
+			}
+		}
+		// The resources are destroyed once we let go of the lock
+		return owners.size();
+	}
+
+	/// <summary>
+	/// Releases every resource in the pool right away, any handles that are still around become stale. Nothing can
+	/// be drawing with the resources, so this should only be called once the render thread is stopped
+	/// </summary>
+	static void Clear() {
+		std::vector<std::shared_ptr<T>> owners;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			const uint32_t count = _slotCount.load(std::memory_order_relaxed);
+			for (uint32_t ix = 0; ix < count; ix++) {
+				if (_GetSlot(ix).Resource.load(std::memory_order_relaxed) != nullptr) {
+					owners.push_back(_Free(ix));
+				}
+			}
+			_retired.clear();
+		}
+	}
+
+	/// <summary>
+	/// Gets the number of resources in the pool, including ones that have been removed but not released yet
+	/// </summary>
+	static size_t Size() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _lookup.size();
+	}
+
+	/// <summary>
+	/// Gets one past the highest slot index that has been used, for sizing tables that are indexed by handle
+	/// </summary>
+	static uint32_t GetSlotCount() {
+		return _slotCount.load(std::memory_order_acquire);
+	}
+
+	/// <summary>
+	/// Invokes a function for each resource in the pool (including ones that have been removed but not released
+	/// yet), in order of their slot index
+	/// </summary>
+	/// <param name="func">A callable taking the resource's handle and the resource (Handle, T&)</param>
+	template <typename Func>
+	static void ForEach(Func&& func) {
+		const uint32_t count = GetSlotCount();
+		for (uint32_t ix = 0; ix < count; ix++) {
+			const Handle handle = Handle::Make(ix, _GetSlot(ix).Generation.load(std::memory_order_acquire));
+			T* resource = _Resolve(handle);
+			if (resource != nullptr) {
+				func(handle, *resource);
+			}
+		}
+	}
+
+private:
+	ResourcePool() = delete;
+
+	static constexpr uint32_t ChunkBits = 10;
+	static constexpr uint32_t ChunkSize = 1u << ChunkBits;
+	static constexpr uint32_t MaxChunks = (Handle::IndexMask + 1) >> ChunkBits;
+
+	struct Slot {
+		std::atomic<uint32_t> Generation{ 1 };
+		std::atomic<T*> Resource{ nullptr };
+		// Only touched under the lock
+		std::shared_ptr<T> Owner;
+		// The frame the slot was removed during, or 0 if it hasn't been removed
+		uint64_t RetireFrame = 0;
+	};
+
+	struct Retired {
+		uint32_t Index;
+		uint64_t Frame;
+	};
+
+	static Slot& _GetSlot(uint32_t index) {
+		return _chunks[index >> ChunkBits].load(std::memory_order_acquire)[index & (ChunkSize - 1)];
+	}
+
+	static T* _Resolve(Handle handle) {
+		if (handle.IsNull() || handle.Index() >= _slotCount.load(std::memory_order_acquire)) {
+			return nullptr;
+		}
+		Slot& slot = _GetSlot(handle.Index());
+		if (slot.Generation.load(std::memory_order_acquire) != handle.Generation()) {
+			return nullptr;
+		}
+		return slot.Resource.load(std::memory_order_acquire);
+	}
+
+	// Must hold the lock
+	static void _Retire(uint32_t index, uint64_t frame) {
+		Slot& slot = _GetSlot(index);
+		if (slot.RetireFrame == 0) {
+			slot.RetireFrame = frame;
+			_retired.push_back({ index, frame });
+		}
+	}
+
+	// Must hold the lock, returns the pool's reference to the resource
+	static std::shared_ptr<T> _Free(uint32_t index) {
+		Slot& slot = _GetSlot(index);
+		const uint32_t generation = slot.Generation.load(std::memory_order_relaxed) + 1;
+		slot.Resource.store(nullptr, std::memory_order_release);
+		slot.Generation.store(generation, std::memory_order_release);
+		slot.RetireFrame = 0;
+		_lookup.erase(slot.Owner.get());
+		// Once a slot runs out of generations it's retired, so old handles can never match it again
+		if (generation <= Handle::MaxGeneration) {
+			_freeList.push_back(index);
+		}
+		return std::move(slot.Owner);
+	}
+
+	inline static std::mutex _mutex;
+	inline static std::atomic<Slot*> _chunks[MaxChunks] = {};
+	inline static std::atomic<uint32_t> _slotCount{ 0 };
+	inline static std::vector<std::unique_ptr<Slot[]>> _ownedChunks;
+	inline static std::vector<uint32_t> _freeList;
+	// Removed slots waiting for their frame to finish, in the order they were removed
+	inline static std::deque<Retired> _retired;
+	inline static std::unordered_map<const T*, Handle> _lookup;
+};
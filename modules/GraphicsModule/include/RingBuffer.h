@@ -0,0 +1,76 @@
+#pragma once
+#include "IBuffer.h"
+#include <memory>
+#include <vector>
+
+/// <summary>
+/// A persistently mapped buffer that is split into a number of segments, which are written to in turn. Each
+/// segment is guarded by a fence, so we only ever wait on the GPU if it is still reading from the segment
+/// we are about to overwrite, which lets us stream dynamic geometry without implicit driver synchronization
+/// 
+/// Typical usage is once per frame (or per batch):
+///    void* data = ring->BeginSegment();
+///    ... write up to GetSegmentSize() bytes, draw using GetSegmentOffset() ...
+///    ring->EndSegment();
+/// </summary>
+class RingBuffer : public IBuffer
+{
+public:
+	typedef std::shared_ptr<RingBuffer> sptr;
+	static inline sptr Create(GLenum type, size_t segmentSize, int segmentCount = 3) {
+		return std::make_shared<RingBuffer>(type, segmentSize, segmentCount);
+	}
+
+public:
+	/// <summary>
+	/// Creates a new ring buffer, allocating and persistently mapping it's storage
+	/// </summary>
+	/// <param name="type">The type of buffer (EX: GL_ARRAY_BUFFER, GL_UNIFORM_BUFFER)</param>
+	/// <param name="segmentSize">The size of a single segment, in bytes</param>
+	/// <param name="segmentCount">The number of segments, should be at least the number of frames the GPU can be behind by</param>
+	RingBuffer(GLenum type, size_t segmentSize, int segmentCount = 3);
+	virtual ~RingBuffer();
+
+	// Ring buffers have immutable storage, so we don't allow re-specifying the data
+	inline void LoadData(const void*, size_t, size_t) override {
+		LOG_ASSERT(false, "Ring buffers cannot be re-specified, write to the mapped segments instead");
+	}
+
+	/// <summary>
+	/// Advances to the next segment, waiting for the GPU to finish with it if required
+	/// </summary>
+	/// <returns>A pointer to the start of the segment, valid for GetSegmentSize() bytes</returns>
+	void* BeginSegment();
+	/// <summary>
+	/// Sub-allocates a block from the current segment
+	/// </summary>
+	/// <param name="size">The size of the block, in bytes</param>
+	/// <param name="alignment">The alignment of the block, in bytes (ex: GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT)</param>
+	/// <param name="outOffset">If not null, receives the offset of the block from the start of the buffer</param>
+	/// <returns>A pointer to the block, or nullptr if there is not enough room left in the segment</returns>
+	void* Allocate(size_t size, size_t alignment = 4, size_t* outOffset = nullptr);
+	/// <summary>
+	/// Ends the current segment, inserting a fence after all the commands that use it
+	/// </summary>
+	void EndSegment();
+
+	/// <summary>
+	/// Gets the offset in bytes from the start of the buffer to the current segment
+	/// </summary>
+	size_t GetSegmentOffset() const { return _currentSegment * _segmentSize; }
+	/// <summary>
+	/// Gets the size of a single segment in bytes
+	/// </summary>
+	size_t GetSegmentSize() const { return _segmentSize; }
+	/// <summary>
+	/// Gets the number of segments in this buffer
+	/// </summary>
+	int GetSegmentCount() const { return _segmentCount; }
+
+protected:
+	size_t _segmentSize;
+	int    _segmentCount;
+	int    _currentSegment;
+	size_t _segmentUsed;
+	std::vector<GLsync> _fences;
+};
@@ -3,6 +3,8 @@
 #include <memory>
 
 #include <string>               // for std::string
+#include <vector>               // for std::vector
+#include <functional>           // for std::function
 #include <unordered_map>        // for std::unordered_map
 #include <GLM/glm.hpp>          // for our GLM types
 #include <GLM/gtc/type_ptr.hpp> // for glm::value_ptr
@@ -11,7 +13,7 @@
 /// <summary>
 /// This class will wrap around an OpenGL shader program
 /// </summary>
-class Shader final
+class Shader final : public std::enable_shared_from_this<Shader>
 {
 public:
 	typedef std::shared_ptr<Shader> sptr;
@@ -70,6 +72,42 @@ public:
 	/// Gets the underlying OpenGL handle that this class is wrapping
 	/// </summary>
 	GLuint GetHandle() const { return _handle; }
+
+	/// <summary>
+	/// Sets the names of the compile-time features that this shader can be permuted by. Bit N of a
+	/// feature mask maps to the Nth name, which gets injected as a #define directly after the #version line
+	/// </summary>
+	/// <param name="defines">The names of the preprocessor defines, in bit order (max 32)</param>
+	void SetPermutationDefines(const std::vector<std::string>& defines);
+	/// <summary>
+	/// Gets the variant of this shader compiled with the given feature bitmask. Variants are compiled
+	/// and linked the first time they are requested, and cached from then on. A mask of 0 is this shader
+	/// </summary>
+	/// <param name="features">The bitmask of features to enable (see SetPermutationDefines)</param>
+	/// <returns>The shader variant, or nullptr if it failed to compile</returns>
+	sptr GetVariant(uint32_t features);
+	/// <summary>
+	/// Gets the feature bitmask that this shader was compiled with
+	/// </summary>
+	uint32_t GetFeatures() const { return _features; }
+	
+	/// <summary>
+	/// Sets a uniform on this shader and all of it's variants, including variants that have not been compiled yet
+	/// Use this for per-scene values (lights, ambient, etc...) that all permutations should agree on
+	/// </summary>
+	/// <param name="name">The name of the uniform to set</param>
+	/// <param name="value">The value to set</param>
+	template <typename T>
+	void SetSharedUniform(const std::string& name, const T& value) {
+		std::function<void(Shader&)> apply = [name, value](Shader& shader) { shader.SetUniform(name, value); };
+		apply(*this);
+		for (auto& kvp : _variants) {
+			if (kvp.second != nullptr) {
+				apply(*kvp.second);
+			}
+		}
+		_sharedUniforms[name] = apply;
+	}
 	
 public:
 	int GetUniformLocation(const std::string& name);
@@ -123,5 +161,15 @@ protected:
 	GLuint _handle;
 
 	std::unordered_map<std::string, int> _uniformLocs;
+
+	// The un-permuted source for each stage, so that we can re-compile it with other defines
+	std::unordered_map<GLenum, std::string> _stageSources;
+	std::vector<std::string> _permutationDefines;
+	uint32_t _features;
+	std::unordered_map<uint32_t, sptr> _variants;
+	std::unordered_map<std::string, std::function<void(Shader&)>> _sharedUniforms;
+
+	bool _CompileShaderPart(const char* source, GLenum type);
+	static std::string _InjectDefines(const std::string& source, const std::vector<std::string>& defines, uint32_t features);
 	
 };
\ No newline at end of file
@@ -3,8 +3,12 @@
 #include "Shader.h"
 #include "ITexture.h"
 #include "Macros.h"
+#include "ResourcePool.h"
 #include <EnumToString.h>
 
+typedef ResourceHandle<Shader> ShaderHandle;
+typedef ResourceHandle<ITexture> TextureHandle;
+
 struct ShaderParamName {
 	std::string Name;
 	int         Location;
@@ -37,8 +41,7 @@ public:
 	ShaderMaterial();
 	virtual ~ShaderMaterial();
 
-	Shader::sptr Shader;
-	std::unordered_map<ShaderParamName, ITexture::sptr> Textures;
+	std::unordered_map<ShaderParamName, TextureHandle> Textures;
 	std::unordered_map<ShaderParamName, float> FloatParams;
 	std::unordered_map<ShaderParamName, glm::vec2> Vec2Params;
 	std::unordered_map<ShaderParamName, glm::vec3> Vec3Params;
@@ -51,6 +54,27 @@ public:
 
 	void Apply();
 
+	/// <summary>
+	/// Sets the shader that this material draws with, adding it to the shader pool if it isn't already
+	/// </summary>
+	void SetShader(const Shader::sptr& shader);
+	/// <summary>
+	/// Gets the shader (or shader variant) that this material draws with, or nullptr if it has not been set
+	/// </summary>
+	Shader* GetShader() const { return ResourcePool<Shader>::Get(_shader); }
+	ShaderHandle GetShaderHandle() const { return _shader; }
+	/// <summary>
+	/// Gets the shader that variants are selected from, or a null handle if no variant has been selected
+	/// </summary>
+	ShaderHandle GetBaseShaderHandle() const { return _baseShader; }
+
+	/// <summary>
+	/// Switches this material to the variant of it's shader compiled with the given feature bitmask,
+	/// re-resolving all parameter locations against the new program
+	/// </summary>
+	/// <param name="features">The feature bitmask to select (see Shader::SetPermutationDefines)</param>
+	void SetVariant(uint32_t features);
+
 	void Set(const std::string& name, const ITexture::sptr& texture);
 	void Set(const std::string& name, float value);
 	void Set(const std::string& name, const glm::vec2& value);
@@ -60,4 +84,7 @@ public:
 	void Set(const std::string& name, const glm::mat3& value);
 
 protected:
+	ShaderHandle _shader;
+	// The un-permuted shader that variants are requested from
+	ShaderHandle _baseShader;
 };
@@ -0,0 +1,244 @@
+#pragma once
+#include <entt.hpp>
+#include <vector>
+#include <cstdint>
+#include <GLM/glm.hpp>
+#include <GLM/gtc/quaternion.hpp>
+
+/// <summary>
+/// Structure-of-arrays storage for all of the transforms within a registry. The Transform component
+/// is only a facade that holds an index into this store, the hot data (local TRS, local and world
+/// matrices and parent indices) lives in contiguous arrays so that the per-frame update can compose
+/// local matrices 4 at a time with SIMD, and evaluate world matrices one hierarchy depth at a time
+/// in parallel.
+///
+/// Transforms are only re-evaluated when something changes. Modifying a transform's local TRS or parent
+/// queues it, and the update will re-calculate the queued transforms and any of their descendants. World
+/// normal and inverse matrices are only calculated when they are asked for. The transforms whose world
+/// matrix changed during the last update are published via GetChangedEntities, so that systems like
+/// rendering and culling can update incrementally
+///
+/// Hierarchies are stored as intrusive first child / next sibling lists, and the slots are kept bucketed
+/// by depth as the hierarchy changes, so reparenting only touches the slot's ancestors (to check for cycles)
+/// and the subtree being moved, never the rest of the store
+///
+/// For fixed timestep simulations, wrap each fixed tick in BeginFixedStep/EndFixedStep. The store remembers the
+/// local TRS of anything modified during the tick, and Interpolate blends between that and the current state to
+/// produce the render matrices (see GetRenderMatrix). Transforms that did not move during the last tick simply
+/// render with their world matrix
+///
+/// Writes to a transform don't go through the registry, so with TRANSFORM_STORE_REPORT_WRITES (on by default in
+/// debug builds) the store raises the registry's on_update&lt;Transform&gt; signal for every write. This lets the
+/// SystemScheduler's access validation see them
+///
+/// There is one store per registry, stored in the registry's context (see Get)
+/// </summary>
+class TransformStore final
+{
+public:
+	static constexpr uint32_t InvalidIndex = ~0u;
+
+	TransformStore(entt::registry& registry);
+	TransformStore(const TransformStore& other) = delete;
+	TransformStore(TransformStore&& other) = delete;
+	TransformStore& operator =(const TransformStore& other) = delete;
+	TransformStore& operator =(TransformStore&& other) = delete;
+	~TransformStore();
+
+	/// <summary>
+	/// Gets the transform store for the given registry, creating it if it does not exist yet
+	/// </summary>
+	static TransformStore& Get(entt::registry& registry);
+
+	/// <summary>
+	/// Allocates a new slot in the store, with an identity local transform and no parent
+	/// </summary>
+	/// <param name="entity">The entity that owns the slot</param>
+	/// <returns>The index of the new slot</returns>
+	uint32_t Allocate(entt::entity entity);
+	/// <summary>
+	/// Releases a slot back to the store. Any children of the slot become roots
+	/// </summary>
+	/// <param name="index">The index of the slot to release</param>
+	void Free(uint32_t index);
+	/// <summary>
+	/// Makes sure the store has room for at least count transforms, so that bulk creation doesn't re-allocate
+	/// </summary>
+	void Reserve(size_t count) { _Reserve(count); }
+
+	/// <summary>
+	/// Re-calculates the local and world matrices for every transform that was modified since the last
+	/// update, along with all of their descendants. This should be called once per frame, before rendering
+	/// </summary>
+	void UpdateWorldMatrices();
+
+	/// <summary>
+	/// Marks the start of a fixed simulation tick. Transforms modified before EndFixedStep will have their state
+	/// from before the tick saved, so that rendering can interpolate between the previous and current tick
+	/// </summary>
+	void BeginFixedStep();
+	/// <summary>
+	/// Marks the end of a fixed simulation tick
+	/// </summary>
+	void EndFixedStep();
+	/// <summary>
+	/// Calculates the render matrices for every transform that moved during the last fixed tick (and their
+	/// descendants), blending between the state before and after the tick. Should be called after
+	/// UpdateWorldMatrices, before rendering
+	/// </summary>
+	/// <param name="alpha">How far we are between the last tick and the next one, from 0 to 1</param>
+	void Interpolate(float alpha);
+	/// <summary>
+	/// Gets the matrix to render the given slot with, which is the interpolated matrix if the slot moved during
+	/// the last fixed tick, or the world matrix if it did not
+	/// </summary>
+	const glm::mat4& GetRenderMatrix(uint32_t index) const {
+		return (_flags[index] & Flag_Interpolated) ? _renderWorld[index] : _world[index];
+	}
+	/// <summary>
+	/// Gets the normal matrix to go with GetRenderMatrix
+	/// </summary>
+	const glm::mat3& GetRenderNormalMatrix(uint32_t index) {
+		return (_flags[index] & Flag_Interpolated) ? _renderNormal[index] : _GetWorldNormal(index);
+	}
+
+	/// <summary>
+	/// Gets the entities whose world matrix changed during the last call to UpdateWorldMatrices
+	/// </summary>
+	const std::vector<entt::entity>& GetChangedEntities() const { return _changedEntities; }
+
+	/// <summary>
+	/// Sets the parent of the given slot, or makes it a root if parent is InvalidIndex
+	/// </summary>
+	void SetParent(uint32_t index, uint32_t parent);
+	/// <summary>
+	/// Gets the parent of the given slot, or InvalidIndex if it is a root
+	/// </summary>
+	uint32_t GetParent(uint32_t index) const { return _parent[index]; }
+	/// <summary>
+	/// Gets the first child of the given slot, or InvalidIndex if it has no children
+	/// </summary>
+	uint32_t GetFirstChild(uint32_t index) const { return _firstChild[index]; }
+	/// <summary>
+	/// Gets the next sibling of the given slot, or InvalidIndex if it is the last child of it's parent
+	/// </summary>
+	uint32_t GetNextSibling(uint32_t index) const { return _nextSibling[index]; }
+	/// <summary>
+	/// Gets the depth of the given slot within the hierarchy (ie. how many parents to the root)
+	/// </summary>
+	uint32_t GetDepth(uint32_t index) const { return _depth[index]; }
+	/// <summary>
+	/// Gets the entity that owns the given slot
+	/// </summary>
+	entt::entity GetEntity(uint32_t index) const { return _entity[index]; }
+
+	/// <summary>
+	/// Invokes a callback for every live slot, with parents always visited before their children
+	/// </summary>
+	/// <typeparam name="Func">A callable with the signature void(uint32_t index)</typeparam>
+	template <typename Func>
+	void EachInDepthOrder(Func func) const {
+		for (const std::vector<uint32_t>& level : _levels) {
+			for (uint32_t index : level) {
+				func(index);
+			}
+		}
+	}
+
+	/// <summary>
+	/// Gets the number of live transforms in the store
+	/// </summary>
+	size_t Size() const { return _indexCount - _freeList.size(); }
+
+	/// <summary>
+	/// If a level is at least this large, it's world matrices will be updated across the JobSystem's workers
+	/// </summary>
+	static constexpr size_t ParallelThreshold = 4096;
+
+private:
+	friend class Transform;
+
+	enum Flags : uint8_t {
+		Flag_None         = 0,
+		Flag_Alive        = 1 << 0,
+		Flag_LocalDirty   = 1 << 1, // The local matrix needs to be re-composed
+		Flag_Queued       = 1 << 2, // The slot is in the dirty list
+		Flag_Changed      = 1 << 3, // The world matrix changed during the last update
+		Flag_NormalDirty  = 1 << 4, // The world normal matrix needs to be re-calculated
+		Flag_InverseDirty = 1 << 5, // The world inverse matrix needs to be re-calculated
+		Flag_FixedSaved   = 1 << 6, // The slot's state from before the current fixed tick has been saved
+		Flag_Interpolated = 1 << 7  // The slot has an interpolated render matrix
+	};
+
+	entt::registry* _registry;
+
+	// Hot data, split per component so that we can stream through it 4 elements at a time
+	// These are always padded to a multiple of 4 elements, padding slots hold an identity transform
+	std::vector<float> _posX, _posY, _posZ;
+	std::vector<float> _rotX, _rotY, _rotZ, _rotW;
+	std::vector<float> _scaleX, _scaleY, _scaleZ;
+
+	std::vector<glm::mat4> _local;
+	std::vector<glm::mat3> _localNormal;
+	std::vector<glm::mat4> _world;
+	std::vector<glm::mat3> _worldNormal;
+	std::vector<glm::mat4> _worldInverse;
+
+	std::vector<uint32_t> _parent;
+	std::vector<uint32_t> _firstChild;
+	std::vector<uint32_t> _nextSibling;
+	std::vector<uint32_t> _prevSibling;
+	std::vector<uint32_t> _depth;
+	std::vector<uint32_t> _levelPos;
+	std::vector<uint8_t>  _flags;
+
+	// State from before the last fixed tick, only valid for slots with Flag_FixedSaved
+	std::vector<glm::vec3> _prevPos;
+	std::vector<glm::quat> _prevRot;
+	std::vector<glm::vec3> _prevScale;
+	// Interpolated matrices, only valid for slots with Flag_Interpolated
+	std::vector<glm::mat4> _renderWorld;
+	std::vector<glm::mat3> _renderNormal;
+	bool _isFixedStep;
+	// Slots that were saved during the last fixed tick, and the slots that were interpolated
+	std::vector<uint32_t> _fixedSaved;
+	std::vector<uint32_t> _interpolated;
+
+	// Cold data, only touched by the facade
+	std::vector<glm::vec3>    _eulerDeg;
+	std::vector<entt::entity> _entity;
+
+	uint32_t _indexCount;
+	std::vector<uint32_t> _freeList;
+
+	// Live slot indices, bucketed by hierarchy depth. _levelPos holds each slot's position within it's level
+	std::vector<std::vector<uint32_t>> _levels;
+	// Scratch space for walking subtrees
+	std::vector<uint32_t> _stack;
+
+	// Slots that were modified since the last update, and the same slots bucketed by depth during the update
+	std::vector<uint32_t> _dirty;
+	std::vector<std::vector<uint32_t>> _dirtyLevels;
+	// Slots whose world matrix changed during the last update
+	std::vector<uint32_t> _changed;
+	std::vector<entt::entity> _changedEntities;
+
+	void _Reserve(size_t count);
+	void _ResetSlot(uint32_t index);
+	void _Link(uint32_t index, uint32_t parent);
+	void _Unlink(uint32_t index);
+	void _AddToLevel(uint32_t index, uint32_t depth);
+	void _RemoveFromLevel(uint32_t index);
+	void _UpdateSubtreeDepth(uint32_t index);
+
+	void _MarkDirty(uint32_t index, uint8_t flags = Flag_None);
+	void _SaveFixedState(uint32_t index);
+	void _ComposeLocal(uint32_t index);
+	void _ComposeRange(uint32_t first, uint32_t count);
+	void _ComposeAll();
+	void _UpdateWorld(uint32_t index);
+	const glm::mat3& _GetWorldNormal(uint32_t index);
+	const glm::mat4& _GetWorldInverse(uint32_t index);
+
+	void _OnTransformDestroyed(entt::registry& registry, entt::entity entity);
+};
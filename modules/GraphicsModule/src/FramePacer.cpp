@@ -0,0 +1,192 @@
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+// The number of frames we remember the input time for, must be more than the render thread can fall behind by
+static constexpr size_t HistorySize = 16;
+// How long to block on a fence at a time when waiting for the GPU
+static constexpr GLuint64 FenceTimeoutNs = 100000000;
+
+static double Now() {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct FramePacer::State {
+	struct Fence {
+		GLsync   Sync;
+		uint64_t Frame;
+	};
+
+	// Guards everything that is shared between the main thread and the context thread
+	std::mutex Mutex;
+	Settings CurrentSettings;
+	Stats LastStats;
+	double InputTimes[HistorySize] = {};
+
+	// Only touched by BeginFrame (main thread)
+	uint64_t NextFrame = 0;
+	double NextDue = 0.0;
+	double LastStart = 0.0;
+	// A running estimate of how far sleeps overshoot, we start spinning this much earlier
+	double SleepError = 0.0;
+
+	// Only touched by the thread that owns the context
+	std::deque<Fence> Fences;
+};
+
+FramePacer::State& FramePacer::_GetState() {
+	static State state;
+	return state;
+}
+
+void FramePacer::SetSettings(const Settings& settings) {
+	State& state = _GetState();
+	std::lock_guard<std::mutex> lock(state.Mutex);
+	state.CurrentSettings = settings;
+}
+
+FramePacer::Settings FramePacer::GetSettings() {
+	State& state = _GetState();
+	std::lock_guard<std::mutex> lock(state.Mutex);
+	return state.CurrentSettings;
+}
+
+uint64_t FramePacer::BeginFrame(GLFWwindow* window) {
+	State& state = _GetState();
+	Settings settings = GetSettings();
+
+	const bool isIdle = settings.ThrottleWhenIdle && _IsWindowIdle(window);
+	const float fps = isIdle ? settings.IdleFps : settings.TargetFps;
+	const double start = Now();
+	if (fps > 0.0f) {
+		const double period = 1.0 / fps;
+		// Frames are due on a fixed cadence, unless we've fallen more than a frame behind or the rate just went up
+		if (state.NextDue <= 0.0 || start - state.NextDue > period || state.NextDue - start > period) {
+			state.NextDue = start;
+		}
+		_WaitUntil(state, settings, state.NextDue, window, isIdle);
+		state.NextDue += period;
+	} else {
+		state.NextDue = 0.0;
+	}
+
+	// Input gets sampled right after this, so this is when the frame's latency starts
+	const double now = Now();
+	const uint64_t frame = state.NextFrame++;
+	{
+		std::lock_guard<std::mutex> lock(state.Mutex);
+		state.LastStats.FrameMs = state.LastStart > 0.0 ? static_cast<float>((now - state.LastStart) * 1000.0) : 0.0f;
+		state.LastStats.PacingWaitMs = static_cast<float>((now - start) * 1000.0);
+		state.LastStats.IsIdle = isIdle;
+		state.InputTimes[frame % HistorySize] = now;
+	}
+	state.LastStart = now;
+	return frame;
+}
+
+void FramePacer::WaitForGpu() {
+	State& state = _GetState();
+	const uint32_t limit = GetSettings().MaxFramesInFlight;
+
+	const double start = Now();
+	_RetireFences(state, false);
+	// The frame we're about to draw counts towards the limit
+	while (limit > 0 && state.Fences.size() >= limit) {
+		_RetireFences(state, true);
+	}
+
+	std::lock_guard<std::mutex> lock(state.Mutex);
+	state.LastStats.GpuWaitMs = static_cast<float>((Now() - start) * 1000.0);
+}
+
+void FramePacer::EndFrame(uint64_t frame) {
+	State& state = _GetState();
+	const double now = Now();
+	state.Fences.push_back(State::Fence{ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), frame });
+	// Check on the earlier frames, so the latency stays up to date even if there's no limit
+	_RetireFences(state, false);
+
+	std::lock_guard<std::mutex> lock(state.Mutex);
+	state.LastStats.InputToSubmitMs = static_cast<float>((now - state.InputTimes[frame % HistorySize]) * 1000.0);
+	state.LastStats.FramesInFlight = static_cast<uint32_t>(state.Fences.size());
+}
+
+FramePacer::Stats FramePacer::GetStats() {
+	State& state = _GetState();
+	std::lock_guard<std::mutex> lock(state.Mutex);
+	return state.LastStats;
+}
+
+void FramePacer::Shutdown() {
+	State& state = _GetState();
+	for (const State::Fence& fence : state.Fences) {
+		glDeleteSync(fence.Sync);
+	}
+	state.Fences.clear();
+}
+
+bool FramePacer::_IsWindowIdle(GLFWwindow* window) {
+	if (window == nullptr) {
+		return false;
+	}
+	return glfwGetWindowAttrib(window, GLFW_ICONIFIED) || !glfwGetWindowAttrib(window, GLFW_FOCUSED);
+}
+
+void FramePacer::_WaitUntil(State& state, const Settings& settings, double target, GLFWwindow* window, bool isIdle) {
+	while (true) {
+		const double remaining = target - Now();
+		if (remaining <= 0.0) {
+			return;
+		}
+
+		if (isIdle) {
+			// Precision doesn't matter while idle, so we wait on window events instead, that way anything that brings
+			// the window back cuts the wait short
+			glfwWaitEventsTimeout(remaining);
+			if (!_IsWindowIdle(window)) {
+				return;
+			}
+			continue;
+		}
+
+		const double spin = settings.SpinMs / 1000.0 + state.SleepError;
+		if (remaining > spin) {
+			const double requested = remaining - spin;
+			const double before = Now();
+			std::this_thread::sleep_for(std::chrono::duration<double>(requested));
+			const double overshoot = std::max(0.0, (Now() - before) - requested);
+			state.SleepError = state.SleepError * 0.9 + overshoot * 0.1;
+		} else {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void FramePacer::_RetireFences(State& state, bool block) {
+	while (!state.Fences.empty()) {
+		const State::Fence& fence = state.Fences.front();
+		const GLenum result = glClientWaitSync(fence.Sync, block ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, block ? FenceTimeoutNs : 0);
+		if (result == GL_TIMEOUT_EXPIRED) {
+			if (!block) {
+				return;
+			}
+			continue;
+		}
+
+		// We only notice the fence when we check on it, so this is when the frame finished at the latest
+		if (result != GL_WAIT_FAILED) {
+			std::lock_guard<std::mutex> lock(state.Mutex);
+			state.LastStats.InputToPresentMs = static_cast<float>((Now() - state.InputTimes[fence.Frame % HistorySize]) * 1000.0);
+		}
+		glDeleteSync(fence.Sync);
+		state.Fences.pop_front();
+		// Once we've waited for one frame, the rest are only checked on
+		block = false;
+	}
+}
@@ -0,0 +1,511 @@
+#include "GLTrace.h"
+
+#ifdef GL_TRACE_ENABLED
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "Logging.h"
+
+namespace {
+	// The kinds of calls that the stall detector cares about
+	enum HookKind : uint8_t {
+		Kind_Generic = 0,
+		Kind_Query,           // glGet* / glIs*
+		Kind_GetIntegerv,     // glGetIntegerv, also checked for state save / restore
+		Kind_BindBuffer,      // (target, buffer)
+		Kind_BindVertexArray, // (vao)
+		Kind_UseProgram,      // (program)
+		Kind_BindTextureUnit, // (unit, texture)
+		Kind_BindTexture,     // (target, texture), slot depends on the active texture
+		Kind_ActiveTexture,   // (unit)
+		Kind_BindFramebuffer, // (target, framebuffer)
+		Kind_NamedWrite,      // (buffer, ...)
+		Kind_TargetWrite,     // (target, ...)
+		Kind_NamedRead,       // (buffer, ...)
+		Kind_TargetRead,      // (target, ...)
+		Kind_MapNamedRange,   // (buffer, offset, length, access)
+		Kind_MapNamed,        // (buffer, access)
+		Kind_MapTargetRange,  // (target, offset, length, access)
+		Kind_MapTarget        // (target, access)
+	};
+
+	typedef std::chrono::high_resolution_clock Clock;
+
+	std::vector<GLTraceEntry> Entries;
+	size_t NextEntry = 0;
+	Clock::time_point StartTime;
+
+	uint64_t Frame = 0;
+	bool     InFrame = false;
+	uint32_t FrameStalls[4] = { 0 };
+	uint32_t LastFrameStalls[4] = { 0 };
+	uint32_t FrameCalls = 0;
+	uint32_t LastFrameCalls = 0;
+
+	// State we shadow to detect redundant binds and reads after writes
+	std::unordered_map<uint64_t, uint64_t> BoundObjects;
+	std::unordered_map<uint64_t, uint64_t> LastBufferWrite;
+	uint64_t ActiveTextureUnit = GL_TEXTURE0;
+
+	thread_local const char* CurrentSubsystem = "<untagged>";
+
+	uint8_t ClassifyCall(const char* name) {
+		static const std::unordered_map<std::string, uint8_t> kinds = {
+			{ "glGetIntegerv",           Kind_GetIntegerv },
+			{ "glBindBuffer",            Kind_BindBuffer },
+			{ "glBindVertexArray",       Kind_BindVertexArray },
+			{ "glUseProgram",            Kind_UseProgram },
+			{ "glBindTextureUnit",       Kind_BindTextureUnit },
+			{ "glBindTexture",           Kind_BindTexture },
+			{ "glActiveTexture",         Kind_ActiveTexture },
+			{ "glBindFramebuffer",       Kind_BindFramebuffer },
+			{ "glNamedBufferData",       Kind_NamedWrite },
+			{ "glNamedBufferSubData",    Kind_NamedWrite },
+			{ "glNamedBufferStorage",    Kind_NamedWrite },
+			{ "glBufferData",            Kind_TargetWrite },
+			{ "glBufferSubData",         Kind_TargetWrite },
+			{ "glGetNamedBufferSubData", Kind_NamedRead },
+			{ "glGetBufferSubData",      Kind_TargetRead },
+			{ "glMapNamedBufferRange",   Kind_MapNamedRange },
+			{ "glMapNamedBuffer",        Kind_MapNamed },
+			{ "glMapBufferRange",        Kind_MapTargetRange },
+			{ "glMapBuffer",             Kind_MapTarget },
+		};
+		auto it = kinds.find(name);
+		if (it != kinds.end()) {
+			return it->second;
+		}
+		if (strncmp(name, "glGet", 5) == 0 || strncmp(name, "glIs", 4) == 0) {
+			return Kind_Query;
+		}
+		return Kind_Generic;
+	}
+
+	template <typename T>
+	uint64_t ArgToBits(T value, uint8_t& isFloat) {
+		isFloat = 0;
+		if constexpr (std::is_pointer_v<T>) {
+			return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value));
+		} else if constexpr (std::is_floating_point_v<T>) {
+			isFloat = 1;
+			double asDouble = static_cast<double>(value);
+			uint64_t result;
+			memcpy(&result, &asDouble, sizeof(result));
+			return result;
+		} else {
+			return static_cast<uint64_t>(value);
+		}
+	}
+
+	template <typename T>
+	void PackArg(GLTraceEntry& entry, T value) {
+		if (entry.ArgCount < 6) {
+			uint8_t isFloat;
+			entry.Args[entry.ArgCount] = ArgToBits(value, isFloat);
+			entry.FloatMask |= isFloat << entry.ArgCount;
+			entry.ArgCount++;
+		}
+	}
+
+	template <typename... Args>
+	void PackArgs(GLTraceEntry& entry, Args... args) {
+		(PackArg(entry, args), ...);
+	}
+
+	// Wraps a single glad function pointer, the signature is deduced from the pointer type
+	template <auto* Fn, typename Sig = std::remove_pointer_t<decltype(Fn)>>
+	struct GLHook;
+
+	template <auto* Fn, typename R, typename... Args>
+	struct GLHook<Fn, R(APIENTRYP)(Args...)> {
+		static inline R(APIENTRYP Original)(Args...) = nullptr;
+		static inline const char* Name = nullptr;
+		static inline uint8_t Kind = Kind_Generic;
+
+		static R APIENTRY Invoke(Args... args) {
+			GLTraceEntry& entry = GLTrace::_BeginCall(Name, Kind);
+			PackArgs(entry, args...);
+			if constexpr (std::is_void_v<R>) {
+				Original(args...);
+				GLTrace::_EndCall(entry);
+			} else {
+				R result = Original(args...);
+				GLTrace::_EndCall(entry);
+				return result;
+			}
+		}
+
+		static void Install(const char* name) {
+			// Functions the driver does not support will be null, we leave those alone
+			if (*Fn != nullptr && Original == nullptr) {
+				Original = *Fn;
+				Name = name;
+				Kind = ClassifyCall(name);
+				*Fn = &Invoke;
+			}
+		}
+	};
+
+	// Note that we paste the glad_ prefix on, which prevents glad's #define from expanding the name
+	#define GL_TRACE_HOOK(name) GLHook<&glad_##name>::Install(#name)
+
+	int StallIndex(GLTraceStall stall) {
+		switch (stall) {
+			case GLTraceStall_Query:          return 0;
+			case GLTraceStall_StateSave:      return 1;
+			case GLTraceStall_ReadAfterWrite: return 2;
+			case GLTraceStall_RedundantBind:  return 3;
+			default:                          return -1;
+		}
+	}
+
+	const char* StallName(int index) {
+		static const char* names[4] = { "Query in frame", "State save/restore", "Read after write", "Redundant bind" };
+		return names[index];
+	}
+
+	// Returns true if the bind is redundant, and records the new binding
+	bool CheckBind(uint8_t kind, uint64_t slot, uint64_t object) {
+		uint64_t key = (static_cast<uint64_t>(kind) << 56) | (slot & 0x00FFFFFFFFFFFFFF);
+		auto it = BoundObjects.find(key);
+		bool redundant = it != BoundObjects.end() && it->second == object;
+		BoundObjects[key] = object;
+		return redundant;
+	}
+
+	uint64_t BufferForTarget(uint64_t target) {
+		auto it = BoundObjects.find((static_cast<uint64_t>(Kind_BindBuffer) << 56) | target);
+		return it == BoundObjects.end() ? 0 : it->second;
+	}
+
+	bool IsReadAfterWrite(uint64_t buffer) {
+		auto it = LastBufferWrite.find(buffer);
+		return it != LastBufferWrite.end() && it->second == Frame;
+	}
+
+	void Analyze(GLTraceEntry& entry) {
+		uint8_t stalls = GLTraceStall_None;
+		const uint64_t* args = entry.Args;
+
+		switch (entry.Kind) {
+			case Kind_Query:
+				if (InFrame) stalls |= GLTraceStall_Query;
+				break;
+			case Kind_GetIntegerv:
+				if (InFrame) stalls |= GLTraceStall_Query;
+				switch (args[0]) {
+					case GL_CURRENT_PROGRAM:
+					case GL_VERTEX_ARRAY_BINDING:
+					case GL_ARRAY_BUFFER_BINDING:
+					case GL_FRAMEBUFFER_BINDING:
+					case GL_TEXTURE_BINDING_2D:
+					case GL_ACTIVE_TEXTURE:
+						stalls |= GLTraceStall_StateSave;
+						break;
+					default: break;
+				}
+				break;
+			case Kind_BindBuffer:
+			case Kind_BindFramebuffer:
+			case Kind_BindTextureUnit:
+				if (CheckBind(entry.Kind, args[0], args[1])) stalls |= GLTraceStall_RedundantBind;
+				break;
+			case Kind_BindVertexArray:
+			case Kind_UseProgram:
+				if (CheckBind(entry.Kind, 0, args[0])) stalls |= GLTraceStall_RedundantBind;
+				break;
+			case Kind_ActiveTexture:
+				ActiveTextureUnit = args[0];
+				break;
+			case Kind_BindTexture:
+				if (CheckBind(entry.Kind, (ActiveTextureUnit << 32) | args[0], args[1])) stalls |= GLTraceStall_RedundantBind;
+				break;
+			case Kind_NamedWrite:
+				LastBufferWrite[args[0]] = Frame;
+				break;
+			case Kind_TargetWrite:
+				LastBufferWrite[BufferForTarget(args[0])] = Frame;
+				break;
+			case Kind_NamedRead:
+				if (IsReadAfterWrite(args[0])) stalls |= GLTraceStall_ReadAfterWrite;
+				break;
+			case Kind_TargetRead:
+				if (IsReadAfterWrite(BufferForTarget(args[0]))) stalls |= GLTraceStall_ReadAfterWrite;
+				break;
+			case Kind_MapNamedRange:
+			case Kind_MapTargetRange:
+			{
+				uint64_t buffer = entry.Kind == Kind_MapNamedRange ? args[0] : BufferForTarget(args[0]);
+				if ((args[3] & GL_MAP_READ_BIT) && IsReadAfterWrite(buffer)) stalls |= GLTraceStall_ReadAfterWrite;
+				if (args[3] & GL_MAP_WRITE_BIT) LastBufferWrite[buffer] = Frame;
+				break;
+			}
+			case Kind_MapNamed:
+			case Kind_MapTarget:
+			{
+				uint64_t buffer = entry.Kind == Kind_MapNamed ? args[0] : BufferForTarget(args[0]);
+				if (args[1] != GL_WRITE_ONLY && IsReadAfterWrite(buffer)) stalls |= GLTraceStall_ReadAfterWrite;
+				if (args[1] != GL_READ_ONLY) LastBufferWrite[buffer] = Frame;
+				break;
+			}
+			default: break;
+		}
+
+		entry.Stalls = stalls;
+		for (int ix = 0; ix < 4; ix++) {
+			if (stalls & (1 << ix)) {
+				FrameStalls[ix]++;
+			}
+		}
+	}
+}
+
+void GLTrace::Install(size_t capacity) {
+	LOG_ASSERT(Entries.empty(), "GL tracer has already been installed!");
+	Entries.resize(capacity);
+	NextEntry = 0;
+	StartTime = Clock::now();
+
+	GL_TRACE_HOOK(glActiveTexture);
+	GL_TRACE_HOOK(glAttachShader);
+	GL_TRACE_HOOK(glBeginQuery);
+	GL_TRACE_HOOK(glBindBuffer);
+	GL_TRACE_HOOK(glBindBufferBase);
+	GL_TRACE_HOOK(glBindBufferRange);
+	GL_TRACE_HOOK(glBindFramebuffer);
+	GL_TRACE_HOOK(glBindSampler);
+	GL_TRACE_HOOK(glBindTexture);
+	GL_TRACE_HOOK(glBindTextureUnit);
+	GL_TRACE_HOOK(glBindVertexArray);
+	GL_TRACE_HOOK(glBlendEquation);
+	GL_TRACE_HOOK(glBlendEquationSeparate);
+	GL_TRACE_HOOK(glBlendFunc);
+	GL_TRACE_HOOK(glBlendFuncSeparate);
+	GL_TRACE_HOOK(glBlitFramebuffer);
+	GL_TRACE_HOOK(glBlitNamedFramebuffer);
+	GL_TRACE_HOOK(glBufferData);
+	GL_TRACE_HOOK(glBufferSubData);
+	GL_TRACE_HOOK(glCheckFramebufferStatus);
+	GL_TRACE_HOOK(glClear);
+	GL_TRACE_HOOK(glClearColor);
+	GL_TRACE_HOOK(glClearDepth);
+	GL_TRACE_HOOK(glClearTexImage);
+	GL_TRACE_HOOK(glClientWaitSync);
+	GL_TRACE_HOOK(glCompileShader);
+	GL_TRACE_HOOK(glCreateBuffers);
+	GL_TRACE_HOOK(glCreateProgram);
+	GL_TRACE_HOOK(glCreateShader);
+	GL_TRACE_HOOK(glCreateTextures);
+	GL_TRACE_HOOK(glCreateVertexArrays);
+	GL_TRACE_HOOK(glCreateQueries);
+	GL_TRACE_HOOK(glDeleteBuffers);
+	GL_TRACE_HOOK(glDeleteFramebuffers);
+	GL_TRACE_HOOK(glDeleteProgram);
+	GL_TRACE_HOOK(glDeleteQueries);
+	GL_TRACE_HOOK(glDeleteRenderbuffers);
+	GL_TRACE_HOOK(glDeleteShader);
+	GL_TRACE_HOOK(glDeleteSync);
+	GL_TRACE_HOOK(glDeleteTextures);
+	GL_TRACE_HOOK(glDeleteVertexArrays);
+	GL_TRACE_HOOK(glDepthFunc);
+	GL_TRACE_HOOK(glDepthMask);
+	GL_TRACE_HOOK(glDetachShader);
+	GL_TRACE_HOOK(glDisable);
+	GL_TRACE_HOOK(glDrawArrays);
+	GL_TRACE_HOOK(glDrawBuffers);
+	GL_TRACE_HOOK(glDrawElements);
+	GL_TRACE_HOOK(glDrawElementsBaseVertex);
+	GL_TRACE_HOOK(glEnable);
+	GL_TRACE_HOOK(glEnableVertexArrayAttrib);
+	GL_TRACE_HOOK(glEnableVertexAttribArray);
+	GL_TRACE_HOOK(glEndQuery);
+	GL_TRACE_HOOK(glFenceSync);
+	GL_TRACE_HOOK(glFinish);
+	GL_TRACE_HOOK(glFlush);
+	GL_TRACE_HOOK(glFlushMappedNamedBufferRange);
+	GL_TRACE_HOOK(glFramebufferTexture2D);
+	GL_TRACE_HOOK(glGenBuffers);
+	GL_TRACE_HOOK(glGenFramebuffers);
+	GL_TRACE_HOOK(glGenTextures);
+	GL_TRACE_HOOK(glGenVertexArrays);
+	GL_TRACE_HOOK(glGenerateTextureMipmap);
+	GL_TRACE_HOOK(glGetBooleanv);
+	GL_TRACE_HOOK(glGetBufferSubData);
+	GL_TRACE_HOOK(glGetError);
+	GL_TRACE_HOOK(glGetFloatv);
+	GL_TRACE_HOOK(glGetIntegerv);
+	GL_TRACE_HOOK(glGetNamedBufferSubData);
+	GL_TRACE_HOOK(glGetProgramInfoLog);
+	GL_TRACE_HOOK(glGetProgramiv);
+	GL_TRACE_HOOK(glGetQueryObjectiv);
+	GL_TRACE_HOOK(glGetQueryObjectui64v);
+	GL_TRACE_HOOK(glGetShaderInfoLog);
+	GL_TRACE_HOOK(glGetShaderiv);
+	GL_TRACE_HOOK(glGetTexImage);
+	GL_TRACE_HOOK(glGetTextureImage);
+	GL_TRACE_HOOK(glGetUniformLocation);
+	GL_TRACE_HOOK(glInvalidateBufferData);
+	GL_TRACE_HOOK(glIsEnabled);
+	GL_TRACE_HOOK(glIsProgram);
+	GL_TRACE_HOOK(glIsTexture);
+	GL_TRACE_HOOK(glLinkProgram);
+	GL_TRACE_HOOK(glMapBuffer);
+	GL_TRACE_HOOK(glMapBufferRange);
+	GL_TRACE_HOOK(glMapNamedBuffer);
+	GL_TRACE_HOOK(glMapNamedBufferRange);
+	GL_TRACE_HOOK(glNamedBufferData);
+	GL_TRACE_HOOK(glNamedBufferStorage);
+	GL_TRACE_HOOK(glNamedBufferSubData);
+	GL_TRACE_HOOK(glObjectLabel);
+	GL_TRACE_HOOK(glPixelStorei);
+	GL_TRACE_HOOK(glPolygonMode);
+	GL_TRACE_HOOK(glProgramUniform1fv);
+	GL_TRACE_HOOK(glProgramUniform1i);
+	GL_TRACE_HOOK(glProgramUniform1iv);
+	GL_TRACE_HOOK(glProgramUniform2fv);
+	GL_TRACE_HOOK(glProgramUniform2i);
+	GL_TRACE_HOOK(glProgramUniform2iv);
+	GL_TRACE_HOOK(glProgramUniform3fv);
+	GL_TRACE_HOOK(glProgramUniform3i);
+	GL_TRACE_HOOK(glProgramUniform3iv);
+	GL_TRACE_HOOK(glProgramUniform4fv);
+	GL_TRACE_HOOK(glProgramUniform4i);
+	GL_TRACE_HOOK(glProgramUniform4iv);
+	GL_TRACE_HOOK(glProgramUniformMatrix3fv);
+	GL_TRACE_HOOK(glProgramUniformMatrix4fv);
+	GL_TRACE_HOOK(glQueryCounter);
+	GL_TRACE_HOOK(glReadPixels);
+	GL_TRACE_HOOK(glScissor);
+	GL_TRACE_HOOK(glShaderSource);
+	GL_TRACE_HOOK(glTexImage2D);
+	GL_TRACE_HOOK(glTexImage3D);
+	GL_TRACE_HOOK(glTexParameteri);
+	GL_TRACE_HOOK(glTexStorage2D);
+	GL_TRACE_HOOK(glTexSubImage2D);
+	GL_TRACE_HOOK(glTextureParameterf);
+	GL_TRACE_HOOK(glTextureParameteri);
+	GL_TRACE_HOOK(glTextureStorage2D);
+	GL_TRACE_HOOK(glTextureSubImage2D);
+	GL_TRACE_HOOK(glTextureSubImage3D);
+	GL_TRACE_HOOK(glUniform1i);
+	GL_TRACE_HOOK(glUniformMatrix4fv);
+	GL_TRACE_HOOK(glUnmapBuffer);
+	GL_TRACE_HOOK(glUnmapNamedBuffer);
+	GL_TRACE_HOOK(glUseProgram);
+	GL_TRACE_HOOK(glVertexArrayAttribBinding);
+	GL_TRACE_HOOK(glVertexArrayAttribFormat);
+	GL_TRACE_HOOK(glVertexArrayElementBuffer);
+	GL_TRACE_HOOK(glVertexArrayVertexBuffer);
+	GL_TRACE_HOOK(glVertexAttribPointer);
+	GL_TRACE_HOOK(glViewport);
+
+	LOG_INFO("GL tracer installed, recording the last {} calls", capacity);
+}
+
+void GLTrace::BeginFrame() {
+	Frame++;
+	InFrame = true;
+	FrameCalls = 0;
+	memset(FrameStalls, 0, sizeof(FrameStalls));
+}
+
+void GLTrace::EndFrame() {
+	InFrame = false;
+	LastFrameCalls = FrameCalls;
+	memcpy(LastFrameStalls, FrameStalls, sizeof(FrameStalls));
+}
+
+uint32_t GLTrace::GetLastFrameStallCount(GLTraceStall stall) {
+	int index = StallIndex(stall);
+	return index < 0 ? 0 : LastFrameStalls[index];
+}
+
+uint32_t GLTrace::GetLastFrameCallCount() {
+	return LastFrameCalls;
+}
+
+GLTrace::Scope::Scope(const char* name) :
+	Previous(CurrentSubsystem)
+{
+	CurrentSubsystem = name;
+}
+
+GLTrace::Scope::~Scope() {
+	CurrentSubsystem = Previous;
+}
+
+GLTraceEntry& GLTrace::_BeginCall(const char* function, uint8_t kind) {
+	GLTraceEntry& entry = Entries[NextEntry % Entries.size()];
+	NextEntry++;
+	entry.Frame = Frame;
+	entry.Function = function;
+	entry.Subsystem = CurrentSubsystem;
+	entry.ArgCount = 0;
+	entry.FloatMask = 0;
+	entry.Stalls = 0;
+	entry.Kind = kind;
+	entry.StartNs = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - StartTime).count();
+	return entry;
+}
+
+void GLTrace::_EndCall(GLTraceEntry& entry) {
+	entry.DurationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - StartTime).count() - entry.StartNs;
+	FrameCalls++;
+	Analyze(entry);
+}
+
+bool GLTrace::Dump(const std::string& path) {
+	std::ofstream file(path);
+	if (!file.is_open()) {
+		LOG_ERROR("Failed to open GL trace file: {}", path);
+		return false;
+	}
+
+	size_t count = NextEntry < Entries.size() ? NextEntry : Entries.size();
+	size_t first = NextEntry - count;
+
+	// Summary of stalls, grouped by function, subsystem and pattern
+	std::map<std::tuple<std::string, std::string, int>, size_t> stallCounts;
+
+	file << "frame\tstart_us\tduration_us\tsubsystem\tcall\tstalls\n";
+	for (size_t ix = first; ix < NextEntry; ix++) {
+		const GLTraceEntry& entry = Entries[ix % Entries.size()];
+		file << entry.Frame << '\t' << (entry.StartNs / 1000.0) << '\t' << (entry.DurationNs / 1000.0) << '\t'
+			 << entry.Subsystem << '\t' << entry.Function << '(';
+		for (int arg = 0; arg < entry.ArgCount; arg++) {
+			if (arg > 0) file << ", ";
+			if (entry.FloatMask & (1 << arg)) {
+				double value;
+				memcpy(&value, &entry.Args[arg], sizeof(value));
+				file << value;
+			} else {
+				file << "0x" << std::hex << entry.Args[arg] << std::dec;
+			}
+		}
+		file << ")\t";
+		for (int stall = 0; stall < 4; stall++) {
+			if (entry.Stalls & (1 << stall)) {
+				file << '[' << StallName(stall) << ']';
+				stallCounts[std::make_tuple(entry.Function, entry.Subsystem, stall)]++;
+			}
+		}
+		file << '\n';
+	}
+
+	file << "\n==== Stall summary (" << count << " calls) ====\n";
+	for (auto& kvp : stallCounts) {
+		file << StallName(std::get<2>(kvp.first)) << "\t" << std::get<1>(kvp.first) << "\t" << std::get<0>(kvp.first) << "\t" << kvp.second << '\n';
+	}
+
+	LOG_INFO("Wrote {} GL calls to {}", count, path);
+	return true;
+}
+
+#endif
@@ -0,0 +1,126 @@
+#include "GpuDeletionQueue.h"
+#include "Logging.h"
+
+std::mutex GpuDeletionQueue::_mutex;
+GpuDeletionQueue::Batch GpuDeletionQueue::_pending = GpuDeletionQueue::Batch();
+std::deque<GpuDeletionQueue::Batch> GpuDeletionQueue::_inFlight;
+uint64_t GpuDeletionQueue::_frame = 0;
+uint32_t GpuDeletionQueue::_frameLatency = 2;
+
+void GpuDeletionQueue::Enqueue(GpuResourceType type, GLuint handle) {
+	if (handle == 0) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(_mutex);
+	_pending.Handles[(size_t)type].push_back(handle);
+}
+
+void GpuDeletionQueue::Enqueue(GLsync sync) {
+	if (sync == nullptr) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(_mutex);
+	_pending.Syncs.push_back(sync);
+}
+
+void GpuDeletionQueue::EndFrame() {
+	_frame++;
+
+	// Take everything that was enqueued this frame, and guard it with a fence behind all the commands we have submitted
+	Batch batch;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		std::swap(batch, _pending);
+	}
+	bool isEmpty = batch.Syncs.empty();
+	for (auto& handles : batch.Handles) {
+		isEmpty &= handles.empty();
+	}
+	if (!isEmpty) {
+		batch.Frame = _frame;
+		batch.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		_inFlight.push_back(std::move(batch));
+	}
+
+	// Batches are in submission order, so we can stop at the first one that is not ready yet
+	while (!_inFlight.empty()) {
+		Batch& front = _inFlight.front();
+		if (_frame - front.Frame < _frameLatency) {
+			break;
+		}
+		GLenum status = glClientWaitSync(front.Fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+			break;
+		}
+		_Release(front);
+		_inFlight.pop_front();
+	}
+}
+
+void GpuDeletionQueue::Flush() {
+	glFinish();
+	Batch batch;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		std::swap(batch, _pending);
+	}
+	batch.Fence = nullptr;
+	_inFlight.push_back(std::move(batch));
+	for (Batch& inFlight : _inFlight) {
+		_Release(inFlight);
+	}
+	_inFlight.clear();
+}
+
+size_t GpuDeletionQueue::GetPendingCount() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	size_t result = _pending.Syncs.size();
+	for (auto& handles : _pending.Handles) {
+		result += handles.size();
+	}
+	for (Batch& batch : _inFlight) {
+		result += batch.Syncs.size();
+		for (auto& handles : batch.Handles) {
+			result += handles.size();
+		}
+	}
+	return result;
+}
+
+void GpuDeletionQueue::_Release(Batch& batch) {
+	auto& buffers = batch.Handles[(size_t)GpuResourceType::Buffer];
+	if (!buffers.empty()) {
+		glDeleteBuffers((GLsizei)buffers.size(), buffers.data());
+	}
+	auto& textures = batch.Handles[(size_t)GpuResourceType::Texture];
+	if (!textures.empty()) {
+		glDeleteTextures((GLsizei)textures.size(), textures.data());
+	}
+	auto& vaos = batch.Handles[(size_t)GpuResourceType::VertexArray];
+	if (!vaos.empty()) {
+		glDeleteVertexArrays((GLsizei)vaos.size(), vaos.data());
+	}
+	auto& framebuffers = batch.Handles[(size_t)GpuResourceType::Framebuffer];
+	if (!framebuffers.empty()) {
+		glDeleteFramebuffers((GLsizei)framebuffers.size(), framebuffers.data());
+	}
+	auto& renderbuffers = batch.Handles[(size_t)GpuResourceType::Renderbuffer];
+	if (!renderbuffers.empty()) {
+		glDeleteRenderbuffers((GLsizei)renderbuffers.size(), renderbuffers.data());
+	}
+	auto& queries = batch.Handles[(size_t)GpuResourceType::Query];
+	if (!queries.empty()) {
+		glDeleteQueries((GLsizei)queries.size(), queries.data());
+	}
+	// Programs don't have a batched delete
+	for (GLuint program : batch.Handles[(size_t)GpuResourceType::Program]) {
+		glDeleteProgram(program);
+	}
+	for (GLsync sync : batch.Syncs) {
+		glDeleteSync(sync);
+	}
+	if (batch.Fence != nullptr) {
+		glDeleteSync(batch.Fence);
+		batch.Fence = nullptr;
+	}
+}
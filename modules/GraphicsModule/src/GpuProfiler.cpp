@@ -0,0 +1,132 @@
+#include "GpuProfiler.h"
+#include "GpuDeletionQueue.h"
+#include "Logging.h"
+
+bool GpuProfiler::_enabled = true;
+uint64_t GpuProfiler::_frameIndex = 0;
+GpuProfiler::FrameData GpuProfiler::_frames[GpuProfiler::FrameLatency];
+std::vector<size_t> GpuProfiler::_openRegions;
+std::unordered_map<std::string, GpuProfiler::History> GpuProfiler::_history;
+std::vector<GpuProfiler::RegionStats> GpuProfiler::_results;
+std::mutex GpuProfiler::_resultsMutex;
+std::atomic<uint64_t> GpuProfiler::_droppedSamples{ 0 };
+
+void GpuProfiler::BeginFrame() {
+	_frameIndex++;
+	FrameData& frame = _frames[_frameIndex % FrameLatency];
+
+	// This query set was last used FrameLatency frames ago, so it's results should be ready by now
+	if (frame.Pending) {
+		_Resolve(frame);
+	}
+	frame.Regions.clear();
+	frame.QueriesUsed = 0;
+	frame.Pending = false;
+	_openRegions.clear();
+}
+
+void GpuProfiler::EndFrame() {
+	LOG_ASSERT(_openRegions.empty(), "Not all GPU profiler regions were closed!");
+	FrameData& frame = _frames[_frameIndex % FrameLatency];
+	frame.Pending = !frame.Regions.empty();
+}
+
+void GpuProfiler::BeginRegion(const std::string& name) {
+	if (!_enabled) {
+		return;
+	}
+	FrameData& frame = _frames[_frameIndex % FrameLatency];
+
+	Region region;
+	region.Name = name;
+	region.Depth = static_cast<int>(_openRegions.size());
+	region.Path = _openRegions.empty() ? name : frame.Regions[_openRegions.back()].Path + "/" + name;
+	region.BeginQuery = _NextQuery(frame);
+	region.EndQuery = 0;
+	glQueryCounter(region.BeginQuery, GL_TIMESTAMP);
+
+	_openRegions.push_back(frame.Regions.size());
+	frame.Regions.push_back(region);
+}
+
+void GpuProfiler::EndRegion() {
+	if (!_enabled || _openRegions.empty()) {
+		return;
+	}
+	FrameData& frame = _frames[_frameIndex % FrameLatency];
+	Region& region = frame.Regions[_openRegions.back()];
+	region.EndQuery = _NextQuery(frame);
+	glQueryCounter(region.EndQuery, GL_TIMESTAMP);
+	_openRegions.pop_back();
+}
+
+void GpuProfiler::Shutdown() {
+	for (FrameData& frame : _frames) {
+		for (GLuint query : frame.Queries) {
+			GpuDeletionQueue::Enqueue(GpuResourceType::Query, query);
+		}
+		frame.Queries.clear();
+		frame.Regions.clear();
+		frame.QueriesUsed = 0;
+		frame.Pending = false;
+	}
+}
+
+std::vector<GpuProfiler::RegionStats> GpuProfiler::CopyResults() {
+	std::lock_guard<std::mutex> lock(_resultsMutex);
+	return _results;
+}
+
+GLuint GpuProfiler::_NextQuery(FrameData& frame) {
+	// Grow the pool for this frame if we have more regions than last time
+	if (frame.QueriesUsed >= frame.Queries.size()) {
+		size_t oldSize = frame.Queries.size();
+		size_t newSize = oldSize == 0 ? 32 : oldSize * 2;
+		frame.Queries.resize(newSize);
+		glCreateQueries(GL_TIMESTAMP, static_cast<GLsizei>(newSize - oldSize), frame.Queries.data() + oldSize);
+	}
+	return frame.Queries[frame.QueriesUsed++];
+}
+
+void GpuProfiler::_Resolve(FrameData& frame) {
+	// Timestamps complete in order, so if the last query is available all of them are
+	GLint available = 0;
+	glGetQueryObjectiv(frame.Queries[frame.QueriesUsed - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available) {
+		// This can happen every frame when the GPU is behind, so we count them for the timings panel instead of logging
+		_droppedSamples.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(_resultsMutex);
+	_results.clear();
+	_results.reserve(frame.Regions.size());
+	for (const Region& region : frame.Regions) {
+		if (region.EndQuery == 0) {
+			continue;
+		}
+		GLuint64 begin = 0, end = 0;
+		glGetQueryObjectui64v(region.BeginQuery, GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(region.EndQuery, GL_QUERY_RESULT, &end);
+		float ms = static_cast<float>(end - begin) / 1000000.0f;
+
+		// Update the rolling average for this region
+		History& history = _history[region.Path];
+		if (history.Count == SampleCount) {
+			history.Sum -= history.Samples[history.Next];
+		} else {
+			history.Count++;
+		}
+		history.Samples[history.Next] = ms;
+		history.Sum += ms;
+		history.Next = (history.Next + 1) % SampleCount;
+
+		RegionStats stats;
+		stats.Name = region.Name;
+		stats.Path = region.Path;
+		stats.Depth = region.Depth;
+		stats.LastMs = ms;
+		stats.AverageMs = history.Sum / history.Count;
+		_results.push_back(stats);
+	}
+}
@@ -1,9 +1,13 @@
 #include "IBuffer.h"
+#include "GpuDeletionQueue.h"
 
 IBuffer::IBuffer(GLenum type, GLenum usage) :
 	_elementCount(0),
 	_elementSize(0),
-	_handle(0)
+	_handle(0),
+	_isImmutable(false),
+	_storageFlags(BufferStorageFlags::None),
+	_mappedPtr(nullptr)
 {
 	_type = type;
 	_usage = usage;
@@ -12,18 +16,76 @@ IBuffer::IBuffer(GLenum type, GLenum usage) :
 
 IBuffer::~IBuffer() {
 	if (_handle != 0) {
-		glDeleteBuffers(1, &_handle);
+		// Deleting a buffer implicitly unmaps it, so we don't need to touch GL here
+		GpuDeletionQueue::Enqueue(GpuResourceType::Buffer, _handle);
+		_mappedPtr = nullptr;
 		_handle = 0;
 	}
 }
 
 void IBuffer::LoadData(const void* data, size_t elementSize, size_t elementCount) {
+	LOG_ASSERT(!_isImmutable, "Cannot re-specify a buffer with immutable storage, use UpdateRange instead!");
 	// Note, this is part of the bindless state access stuff added in 4.5    
 	glNamedBufferData(_handle, elementSize * elementCount, data, _usage);
 	_elementCount = elementCount;
 	_elementSize = elementSize;
 }
 
+void IBuffer::AllocateStorage(const void* data, size_t elementSize, size_t elementCount, BufferStorageFlags flags) {
+	LOG_ASSERT(!_isImmutable, "Buffer storage has already been allocated!");
+	glNamedBufferStorage(_handle, elementSize * elementCount, data, *flags);
+	_elementCount = elementCount;
+	_elementSize = elementSize;
+	_storageFlags = flags;
+	_isImmutable = true;
+}
+
+void IBuffer::UpdateRange(const void* data, size_t elementOffset, size_t elementCount) {
+	LOG_ASSERT(elementOffset + elementCount <= _elementCount, "Range is outside of the buffer!");
+	LOG_ASSERT(!_isImmutable || *(_storageFlags & BufferStorageFlags::DynamicStorage), "Immutable buffer was not created with DynamicStorage!");
+	glNamedBufferSubData(_handle, elementOffset * _elementSize, elementCount * _elementSize, data);
+}
+
+void IBuffer::Orphan() {
+	LOG_ASSERT(_mappedPtr == nullptr, "Cannot orphan a mapped buffer!");
+	if (_isImmutable) {
+		glInvalidateBufferData(_handle);
+	} else {
+		// Re-specifying with the same size and a null pointer lets the driver allocate a new block for us
+		glNamedBufferData(_handle, GetTotalSize(), nullptr, _usage);
+	}
+}
+
+void* IBuffer::MapRange(size_t offset, size_t length, BufferMapFlags flags) {
+	LOG_ASSERT(_mappedPtr == nullptr, "Buffer is already mapped!");
+	LOG_ASSERT(offset + length <= GetTotalSize(), "Range is outside of the buffer!");
+	_mappedPtr = glMapNamedBufferRange(_handle, offset, length, *flags);
+	if (_mappedPtr == nullptr) {
+		LOG_ERROR("Failed to map buffer {} (offset: {}, length: {})", _handle, offset, length);
+	}
+	return _mappedPtr;
+}
+
+void* IBuffer::MapPersistent(bool coherent) {
+	LOG_ASSERT(_isImmutable && *(_storageFlags & BufferStorageFlags::MapPersistent), "Persistent mapping requires immutable storage with MapPersistent!");
+	LOG_ASSERT(!coherent || *(_storageFlags & BufferStorageFlags::MapCoherent), "Coherent mapping requires immutable storage with MapCoherent!");
+	BufferMapFlags flags = BufferMapFlags::Write | BufferMapFlags::Persistent;
+	flags |= coherent ? BufferMapFlags::Coherent : BufferMapFlags::FlushExplicit;
+	return MapRange(0, GetTotalSize(), flags);
+}
+
+void IBuffer::FlushRange(size_t offset, size_t length) {
+	LOG_ASSERT(_mappedPtr != nullptr, "Buffer must be mapped to flush!");
+	glFlushMappedNamedBufferRange(_handle, offset, length);
+}
+
+void IBuffer::Unmap() {
+	if (_mappedPtr != nullptr) {
+		glUnmapNamedBuffer(_handle);
+		_mappedPtr = nullptr;
+	}
+}
+
 void IBuffer::Bind() {
 	glBindBuffer(_type, _handle);
 }
@@ -1,6 +1,7 @@
 #include "ITexture.h"
 
 #include "Logging.h"
+#include "GpuDeletionQueue.h"
 
 ITexture::Limits ITexture::_limits = ITexture::Limits();
 bool ITexture::_isStaticInit = false;
@@ -30,8 +31,9 @@ ITexture::ITexture()
 }
 
 ITexture::~ITexture() {
-	if (glIsTexture(_handle)) {
-		glDeleteTextures(1, &_handle);
+	if (_handle != 0) {
+		GpuDeletionQueue::Enqueue(GpuResourceType::Texture, _handle);
+		_handle = 0;
 	}
 }
 
@@ -0,0 +1,309 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <thread>
+
+#include "Logging.h"
+
+// The queue that the current thread pushes to and pops from. Workers each have their own, everything else shares 0
+static thread_local size_t s_queueIndex = 0;
+
+struct JobSystem::Queue {
+	std::mutex Mutex;
+	std::deque<Job> Jobs;
+};
+
+struct JobSystem::State {
+	// Guards starting and stopping the workers
+	std::mutex StartMutex;
+	std::atomic<bool> IsRunning = false;
+	std::vector<std::thread> Workers;
+	// One queue per worker, plus the shared queue at index 0
+	std::unique_ptr<Queue[]> Queues;
+	size_t QueueCount = 0;
+
+	// The number of jobs sitting in the queues, workers only go to sleep when this is 0
+	std::atomic<uint32_t> Queued = 0;
+	std::atomic<uint32_t> Sleeping = 0;
+	std::mutex SleepMutex;
+	std::condition_variable Wake;
+	bool IsStopping = false;
+
+	std::atomic<uint64_t> Executed = 0;
+	std::atomic<uint64_t> Stolen = 0;
+
+	~State() {
+		// Make sure the workers are gone before the queues are if Shutdown was never called
+		Stop();
+	}
+
+	void Stop() {
+		{
+			std::lock_guard<std::mutex> lock(SleepMutex);
+			IsStopping = true;
+		}
+		Wake.notify_all();
+		// The workers empty every queue before they exit, so nothing that was queued gets lost
+		for (std::thread& worker : Workers) {
+			worker.join();
+		}
+		Workers.clear();
+		IsRunning = false;
+	}
+};
+
+JobCounter::~JobCounter() {
+	// The thread that released the counter may still be holding the lock after we see it finish
+	std::lock_guard<std::mutex> lock(_mutex);
+}
+
+JobSystem::State& JobSystem::_GetState() {
+	static State state;
+	return state;
+}
+
+void JobSystem::Init(size_t workerCount) {
+	State& state = _GetState();
+	std::lock_guard<std::mutex> lock(state.StartMutex);
+	if (state.IsRunning) {
+		return;
+	}
+	if (workerCount == 0) {
+		const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	state.QueueCount = workerCount + 1;
+	state.Queues = std::make_unique<Queue[]>(state.QueueCount);
+	state.Queued = 0;
+	state.IsStopping = false;
+	state.Executed = 0;
+	state.Stolen = 0;
+	state.Workers.reserve(workerCount);
+	for (size_t ix = 0; ix < workerCount; ix++) {
+		state.Workers.emplace_back(&JobSystem::_WorkerLoop, ix + 1);
+	}
+	state.IsRunning = true;
+}
+
+void JobSystem::Shutdown() {
+	State& state = _GetState();
+	std::lock_guard<std::mutex> lock(state.StartMutex);
+	if (!state.IsRunning) {
+		return;
+	}
+	state.Stop();
+	state.Queues.reset();
+	state.QueueCount = 0;
+}
+
+bool JobSystem::IsRunning() {
+	return _GetState().IsRunning;
+}
+
+size_t JobSystem::GetWorkerCount() {
+	State& state = _GetState();
+	return state.IsRunning ? state.Workers.size() : 0;
+}
+
+void JobSystem::Run(JobFunc&& job, JobCounter* counter) {
+	if (counter != nullptr) {
+		counter->_pending.fetch_add(1);
+	}
+	_Push(std::move(job), counter);
+}
+
+void JobSystem::Run(JobFunc&& job, JobCounter* counter, JobCounter& after) {
+	if (counter != nullptr) {
+		counter->_pending.fetch_add(1);
+	}
+	{
+		// The last job on the counter flushes the deferred jobs under this lock, so if it's not done yet the job
+		// will be picked up when it is
+		std::lock_guard<std::mutex> lock(after._mutex);
+		if (!after.IsDone()) {
+			after._deferred.push_back(JobCounter::Deferred{ std::move(job), counter });
+			return;
+		}
+	}
+	_Push(std::move(job), counter);
+}
+
+void JobSystem::Wait(JobCounter& counter) {
+	while (!counter.IsDone()) {
+		if (!TryRunOne()) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+bool JobSystem::TryRunOne() {
+	State& state = _GetState();
+	if (!state.IsRunning) {
+		return false;
+	}
+	return _RunOne(state, s_queueIndex);
+}
+
+void JobSystem::ParallelFor(size_t count, size_t chunkSize, const std::function<void(size_t, size_t)>& func) {
+	chunkSize = std::max<size_t>(chunkSize, 1);
+	const size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+	if (chunkCount <= 1) {
+		if (count > 0) {
+			func(0, count);
+		}
+		return;
+	}
+	if (!IsRunning()) {
+		Init();
+	}
+
+	// Chunks are handed out as they're asked for rather than up front, so a slow chunk doesn't hold up the rest
+	std::atomic<size_t> nextChunk(0);
+	auto work = [&]() {
+		size_t chunk;
+		while ((chunk = nextChunk.fetch_add(1)) < chunkCount) {
+			func(chunk * chunkSize, std::min(count, (chunk + 1) * chunkSize));
+		}
+	};
+
+	JobCounter helpers;
+	const size_t helperCount = std::min(GetWorkerCount(), chunkCount - 1);
+	for (size_t ix = 0; ix < helperCount; ix++) {
+		Run(work, &helpers);
+	}
+	std::exception_ptr error;
+	try {
+		work();
+	} catch (...) {
+		// Stop handing out chunks, the helpers will finish whatever they are on
+		nextChunk.store(chunkCount);
+		error = std::current_exception();
+	}
+
+	// The helpers reference our stack, so we can't leave until every one of them has finished, even if we are throwing
+	Wait(helpers);
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
+
+JobSystem::Stats JobSystem::GetStats() {
+	State& state = _GetState();
+	Stats result;
+	result.Executed = state.Executed;
+	result.Stolen = state.Stolen;
+	return result;
+}
+
+void JobSystem::_Push(JobFunc&& job, JobCounter* counter) {
+	State& state = _GetState();
+	if (!state.IsRunning) {
+		Init();
+	}
+	{
+		Queue& queue = state.Queues[s_queueIndex];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		queue.Jobs.push_back(Job{ std::move(job), counter });
+	}
+	state.Queued.fetch_add(1);
+	// Workers bump Sleeping before they check Queued, so if we don't see them here they will see our job
+	if (state.Sleeping.load() > 0) {
+		std::lock_guard<std::mutex> lock(state.SleepMutex);
+		state.Wake.notify_one();
+	}
+}
+
+bool JobSystem::_RunOne(State& state, size_t queue) {
+	Job job;
+	bool found = false;
+
+	// Our own work comes off the back, it's the most recently queued and most likely to still be in cache
+	{
+		Queue& own = state.Queues[queue];
+		std::lock_guard<std::mutex> lock(own.Mutex);
+		if (!own.Jobs.empty()) {
+			job = std::move(own.Jobs.back());
+			own.Jobs.pop_back();
+			found = true;
+		}
+	}
+
+	// Otherwise steal the oldest job from someone else, starting from our neighbour so thieves spread out
+	for (size_t ix = 1; !found && ix < state.QueueCount; ix++) {
+		Queue& victim = state.Queues[(queue + ix) % state.QueueCount];
+		std::lock_guard<std::mutex> lock(victim.Mutex);
+		if (!victim.Jobs.empty()) {
+			job = std::move(victim.Jobs.front());
+			victim.Jobs.pop_front();
+			found = true;
+			state.Stolen.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	if (!found) {
+		return false;
+	}
+	state.Queued.fetch_sub(1);
+	_Execute(job);
+	state.Executed.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+void JobSystem::_Execute(Job& job) {
+	try {
+		job.Func();
+	} catch (const std::exception& e) {
+		LOG_ERROR("Job failed: {}", e.what());
+	}
+	// Release the job before the counter, anything it captured may reference the waiting thread's stack
+	job.Func = nullptr;
+	if (job.Counter != nullptr) {
+		_Release(job.Counter);
+	}
+}
+
+void JobSystem::_Release(JobCounter* counter) {
+	// We only need the lock if we might be the last job on the counter
+	uint32_t pending = counter->_pending.load();
+	while (pending > 1) {
+		if (counter->_pending.compare_exchange_weak(pending, pending - 1)) {
+			return;
+		}
+	}
+
+	std::vector<JobCounter::Deferred> ready;
+	{
+		std::lock_guard<std::mutex> lock(counter->_mutex);
+		if (counter->_pending.fetch_sub(1) == 1) {
+			ready.swap(counter->_deferred);
+		}
+	}
+	// The counter may be gone as soon as the lock is released, so we only touch what we moved out of it
+	for (JobCounter::Deferred& deferred : ready) {
+		_Push(std::move(deferred.Func), deferred.Counter);
+	}
+}
+
+void JobSystem::_WorkerLoop(size_t queue) {
+	State& state = _GetState();
+	s_queueIndex = queue;
+	while (true) {
+		if (_RunOne(state, queue)) {
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(state.SleepMutex);
+		state.Sleeping.fetch_add(1);
+		state.Wake.wait(lock, [&state]() { return state.IsStopping || state.Queued.load() > 0; });
+		state.Sleeping.fetch_sub(1);
+		if (state.IsStopping && state.Queued.load() == 0) {
+			break;
+		}
+	}
+	s_queueIndex = 0;
+}
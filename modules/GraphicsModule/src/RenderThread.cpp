@@ -0,0 +1,203 @@
+#include "RenderThread.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "Logging.h"
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static float MsSince(const Clock::time_point& start) {
+	return std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+}
+
+struct RenderThread::State {
+	struct Item {
+		Command Func;
+		bool    IsFrame;
+	};
+
+	GLFWwindow* Window = nullptr;
+	std::thread Thread;
+	std::thread::id ThreadId;
+	// Read from any thread that wants to queue work, but only changed by Start and Stop
+	std::atomic<bool> IsRunning = false;
+	bool IsStopping = false;
+
+	std::mutex Mutex;
+	// Signalled when there is something in the queue (or we are stopping)
+	std::condition_variable HasWork;
+	// Signalled when the render thread finishes an item
+	std::condition_variable Finished;
+	std::deque<Item> Queue;
+	bool IsBusy = false;
+
+	uint64_t Submitted = 0;
+	uint64_t Completed = 0;
+	Stats LastStats;
+};
+
+RenderThread::State& RenderThread::_GetState() {
+	static State state;
+	return state;
+}
+
+void RenderThread::Start(GLFWwindow* window) {
+	State& state = _GetState();
+	if (state.IsRunning) {
+		return;
+	}
+	// A context can only be current on one thread at a time
+	glfwMakeContextCurrent(nullptr);
+	state.Window = window;
+	state.IsRunning = true;
+	state.IsStopping = false;
+	state.Thread = std::thread(&RenderThread::_ThreadLoop, window);
+	state.ThreadId = state.Thread.get_id();
+}
+
+void RenderThread::Stop() {
+	State& state = _GetState();
+	if (!state.IsRunning) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(state.Mutex);
+		state.IsStopping = true;
+	}
+	state.HasWork.notify_all();
+	state.Thread.join();
+	state.IsRunning = false;
+	state.ThreadId = std::thread::id();
+	glfwMakeContextCurrent(state.Window);
+}
+
+bool RenderThread::IsRunning() {
+	return _GetState().IsRunning;
+}
+
+bool RenderThread::IsRenderThread() {
+	const State& state = _GetState();
+	return state.IsRunning && std::this_thread::get_id() == state.ThreadId;
+}
+
+void RenderThread::Enqueue(Command&& command) {
+	State& state = _GetState();
+	if (!state.IsRunning || IsRenderThread()) {
+		command();
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(state.Mutex);
+		state.Queue.push_back(State::Item{ std::move(command), false });
+	}
+	state.HasWork.notify_one();
+}
+
+uint32_t RenderThread::BeginFrame() {
+	State& state = _GetState();
+	if (!state.IsRunning) {
+		return 0;
+	}
+	const Clock::time_point start = Clock::now();
+	std::unique_lock<std::mutex> lock(state.Mutex);
+	state.Finished.wait(lock, [&state]() { return state.Submitted - state.Completed <= 1; });
+	state.LastStats.WaitMs = MsSince(start);
+	return static_cast<uint32_t>(state.Submitted & 1);
+}
+
+void RenderThread::SubmitFrame(Command&& frame) {
+	State& state = _GetState();
+	if (!state.IsRunning) {
+		const Clock::time_point start = Clock::now();
+		frame();
+		std::lock_guard<std::mutex> lock(state.Mutex);
+		state.Submitted++;
+		state.Completed++;
+		state.LastStats.RenderMs = MsSince(start);
+		state.LastStats.Frames++;
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(state.Mutex);
+		state.Queue.push_back(State::Item{ std::move(frame), true });
+		state.Submitted++;
+	}
+	state.HasWork.notify_one();
+}
+
+void RenderThread::WaitIdle() {
+	State& state = _GetState();
+	if (!state.IsRunning || IsRenderThread()) {
+		return;
+	}
+	std::unique_lock<std::mutex> lock(state.Mutex);
+	state.Finished.wait(lock, [&state]() { return state.Queue.empty() && !state.IsBusy; });
+}
+
+uint64_t RenderThread::GetBuildingFrame() {
+	State& state = _GetState();
+	std::lock_guard<std::mutex> lock(state.Mutex);
+	return state.Submitted + 1;
+}
+
+uint64_t RenderThread::GetCompletedFrames() {
+	State& state = _GetState();
+	std::lock_guard<std::mutex> lock(state.Mutex);
+	return state.Completed;
+}
+
+RenderThread::Stats RenderThread::GetStats() {
+	State& state = _GetState();
+	std::lock_guard<std::mutex> lock(state.Mutex);
+	return state.LastStats;
+}
+
+void RenderThread::_ThreadLoop(GLFWwindow* window) {
+	State& state = _GetState();
+	glfwMakeContextCurrent(window);
+
+	Clock::time_point idleStart = Clock::now();
+	while (true) {
+		State::Item item;
+		{
+			std::unique_lock<std::mutex> lock(state.Mutex);
+			state.HasWork.wait(lock, [&state]() { return state.IsStopping || !state.Queue.empty(); });
+			// We always finish the queue before stopping, so nothing that was submitted gets lost
+			if (state.Queue.empty()) {
+				break;
+			}
+			item = std::move(state.Queue.front());
+			state.Queue.pop_front();
+			state.IsBusy = true;
+		}
+
+		const Clock::time_point start = Clock::now();
+		try {
+			item.Func();
+		} catch (const std::exception& e) {
+			LOG_ERROR("Render thread command failed: {}", e.what());
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(state.Mutex);
+			state.IsBusy = false;
+			if (item.IsFrame) {
+				state.Completed++;
+				state.LastStats.RenderMs = MsSince(start);
+				state.LastStats.IdleMs = std::chrono::duration<float, std::milli>(start - idleStart).count();
+				state.LastStats.Frames++;
+				idleStart = Clock::now();
+			}
+		}
+		state.Finished.notify_all();
+	}
+
+	glfwMakeContextCurrent(nullptr);
+}
@@ -0,0 +1,61 @@
+#include "RingBuffer.h"
+#include "GpuDeletionQueue.h"
+
+RingBuffer::RingBuffer(GLenum type, size_t segmentSize, int segmentCount) :
+	IBuffer(type, GL_STREAM_DRAW),
+	_segmentSize(segmentSize),
+	_segmentCount(segmentCount),
+	_currentSegment(segmentCount - 1),
+	_segmentUsed(0),
+	_fences(segmentCount, nullptr)
+{
+	LOG_ASSERT(segmentCount > 0, "Ring buffer must have at least one segment!");
+	AllocateStorage(nullptr, 1, segmentSize * segmentCount,
+		BufferStorageFlags::MapWrite | BufferStorageFlags::MapPersistent | BufferStorageFlags::MapCoherent);
+	MapPersistent(true);
+}
+
+RingBuffer::~RingBuffer() {
+	for (GLsync& fence : _fences) {
+		GpuDeletionQueue::Enqueue(fence);
+		fence = nullptr;
+	}
+}
+
+void* RingBuffer::BeginSegment() {
+	_currentSegment = (_currentSegment + 1) % _segmentCount;
+	_segmentUsed = 0;
+
+	// If the GPU may still be reading from this segment, we need to wait for it to finish
+	GLsync& fence = _fences[_currentSegment];
+	if (fence != nullptr) {
+		GLenum result = glClientWaitSync(fence, 0, 0);
+		while (result == GL_TIMEOUT_EXPIRED) {
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		}
+		if (result == GL_WAIT_FAILED) {
+			LOG_WARN("Failed to wait on ring buffer fence");
+		}
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	return static_cast<uint8_t*>(_mappedPtr) + GetSegmentOffset();
+}
+
+void* RingBuffer::Allocate(size_t size, size_t alignment, size_t* outOffset) {
+	size_t start = (_segmentUsed + alignment - 1) / alignment * alignment;
+	if (start + size > _segmentSize) {
+		return nullptr;
+	}
+	_segmentUsed = start + size;
+	if (outOffset != nullptr) {
+		*outOffset = GetSegmentOffset() + start;
+	}
+	return static_cast<uint8_t*>(_mappedPtr) + GetSegmentOffset() + start;
+}
+
+void RingBuffer::EndSegment() {
+	LOG_ASSERT(_fences[_currentSegment] == nullptr, "Segment has already been ended!");
+	_fences[_currentSegment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
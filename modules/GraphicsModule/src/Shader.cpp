@@ -1,25 +1,34 @@
 #include "Shader.h"
 #include "Logging.h"
+#include "GpuDeletionQueue.h"
 #include <fstream>
 #include <sstream>
 
 Shader::Shader() :
 	_vs(0),
 	_fs(0),
-	_handle(0)
+	_handle(0),
+	_features(0)
 {
 	_handle = glCreateProgram();
 }
 
 Shader::~Shader() {
 	if (_handle != 0) {
-		glDeleteProgram(_handle);
+		GpuDeletionQueue::Enqueue(GpuResourceType::Program, _handle);
 		_handle = 0;
 		LOG_INFO("Deleting shader program");
 	}
 }
 
 bool Shader::LoadShaderPart(const char* source, GLenum type)
+{
+	// Store the source so that we can compile permutations of this stage later
+	_stageSources[type] = source;
+	return _CompileShaderPart(source, type);
+}
+
+bool Shader::_CompileShaderPart(const char* source, GLenum type)
 {
 	// Creates a new shader part (VS, FS, GS, etc...)
 	GLuint handle = glCreateShader(type);
@@ -116,6 +125,73 @@ bool Shader::Link()
 	return status != GL_FALSE;
 }
 
+void Shader::SetPermutationDefines(const std::vector<std::string>& defines) {
+	LOG_ASSERT(defines.size() <= 32, "Shaders only support up to 32 permutation features!");
+	LOG_ASSERT(_variants.empty(), "Cannot change permutation defines after variants have been compiled!");
+	_permutationDefines = defines;
+}
+
+Shader::sptr Shader::GetVariant(uint32_t features) {
+	// The base shader is always the variant with no features enabled
+	if (features == _features) {
+		return shared_from_this();
+	}
+	LOG_ASSERT(_features == 0, "Variants can only be requested from the base shader!");
+
+	// If we've already compiled (or failed to compile) this variant, return the cached result
+	auto it = _variants.find(features);
+	if (it != _variants.end()) {
+		return it->second;
+	}
+
+	LOG_ASSERT(_stageSources.size() > 0, "Shader has no sources to build a variant from!");
+	LOG_INFO("Compiling shader variant 0x{:08x}", features);
+
+	sptr result = Create();
+	result->_features = features;
+	bool success = true;
+	for (auto& kvp : _stageSources) {
+		std::string source = _InjectDefines(kvp.second, _permutationDefines, features);
+		success &= result->_CompileShaderPart(source.c_str(), kvp.first);
+	}
+	success = success && result->Link();
+
+	if (success) {
+		// Bring the new variant up to date with all the shared uniforms that have been set so far
+		for (auto& kvp : _sharedUniforms) {
+			kvp.second(*result);
+		}
+	} else {
+		LOG_ERROR("Failed to build shader variant 0x{:08x}", features);
+		result = nullptr;
+	}
+
+	// We store failures as well, so we don't try to re-compile a broken variant every frame
+	_variants[features] = result;
+	return result;
+}
+
+std::string Shader::_InjectDefines(const std::string& source, const std::vector<std::string>& defines, uint32_t features) {
+	std::stringstream defineBlock;
+	for (size_t ix = 0; ix < defines.size(); ix++) {
+		if (features & (1u << ix)) {
+			defineBlock << "#define " << defines[ix] << "\n";
+		}
+	}
+
+	// The #version directive must be the first thing in the shader, so we insert directly after that line
+	size_t insertPos = 0;
+	size_t versionPos = source.find("#version");
+	if (versionPos != std::string::npos) {
+		size_t lineEnd = source.find('\n', versionPos);
+		insertPos = lineEnd == std::string::npos ? source.size() : lineEnd + 1;
+	}
+
+	std::string result = source;
+	result.insert(insertPos, defineBlock.str());
+	return result;
+}
+
 void Shader::Bind() {
 	glUseProgram(_handle);
 }
@@ -1,21 +1,34 @@
 #include "ShaderMaterial.h"
 
 template<typename T>
-void SubmitUniforms(const Shader::sptr& shader, const std::unordered_map<ShaderParamName, T>& values) {
+void SubmitUniforms(Shader* shader, const std::unordered_map<ShaderParamName, T>& values) {
 	for (auto& kvp : values) {
 		shader->SetUniform(kvp.first.Location, kvp.second);
 	}
 }
 
 template<typename T>
-void SubmitUniformsMat(const Shader::sptr& shader, const std::unordered_map<ShaderParamName, T>& values) {
+void SubmitUniformsMat(Shader* shader, const std::unordered_map<ShaderParamName, T>& values) {
 	for (auto& kvp : values) {
 		shader->SetUniformMatrix(kvp.first.Location, kvp.second);
 	}
 }
 
+template<typename T>
+void ResolveLocations(Shader* shader, std::unordered_map<ShaderParamName, T>& values) {
+	// Map keys are const, so we need to rebuild the map with the new locations
+	std::unordered_map<ShaderParamName, T> result;
+	result.reserve(values.size());
+	for (auto& kvp : values) {
+		ShaderParamName pName = kvp.first;
+		pName.Location = shader->GetUniformLocation(pName.Name);
+		result[pName] = kvp.second;
+	}
+	values = std::move(result);
+}
+
 ShaderMaterial::ShaderMaterial()
-	: Shader(nullptr),  RenderLayer(0)
+	: RenderLayer(0), _shader(ShaderHandle()), _baseShader(ShaderHandle())
 {
 }
 
@@ -25,68 +38,104 @@ ShaderMaterial::~ShaderMaterial() {
 
 void ShaderMaterial::Apply()
 {	
+	Shader* shader = GetShader();
 	int slot = 1;
 	for (auto& kvp : Textures) {
-		if (kvp.first.Location != -1 && kvp.second != nullptr) {
-			Shader->SetUniform(kvp.first.Location, slot);
-			kvp.second->Bind(slot);
+		ITexture* texture = ResourcePool<ITexture>::Get(kvp.second);
+		if (kvp.first.Location != -1 && texture != nullptr) {
+			shader->SetUniform(kvp.first.Location, slot);
+			texture->Bind(slot);
 			slot++;
 		}
 	}
 
-	SubmitUniforms(Shader, FloatParams);
-	SubmitUniforms(Shader, Vec2Params);
-	SubmitUniforms(Shader, Vec3Params);
-	SubmitUniforms(Shader, Vec4Params);
-	SubmitUniformsMat(Shader, Mat4Params);
-	SubmitUniformsMat(Shader, Mat3Params);
+	SubmitUniforms(shader, FloatParams);
+	SubmitUniforms(shader, Vec2Params);
+	SubmitUniforms(shader, Vec3Params);
+	SubmitUniforms(shader, Vec4Params);
+	SubmitUniformsMat(shader, Mat4Params);
+	SubmitUniformsMat(shader, Mat3Params);
+}
+
+void ShaderMaterial::SetShader(const Shader::sptr& shader) {
+	_shader = ResourcePool<Shader>::Add(shader);
+}
+
+void ShaderMaterial::SetVariant(uint32_t features) {
+	LOG_ASSERT(GetShader() != nullptr, "Must set Material shader before selecting a variant");
+	// If the shader was assigned directly, it becomes our new base
+	if (GetShader()->GetFeatures() == 0) {
+		_baseShader = _shader;
+	}
+
+	Shader::sptr variant = ResourcePool<Shader>::Get(_baseShader)->GetVariant(features);
+	if (variant == nullptr || variant.get() == GetShader()) {
+		return;
+	}
+
+	_shader = ResourcePool<Shader>::Add(variant);
+	Shader* shader = variant.get();
+	ResolveLocations(shader, Textures);
+	ResolveLocations(shader, FloatParams);
+	ResolveLocations(shader, Vec2Params);
+	ResolveLocations(shader, Vec3Params);
+	ResolveLocations(shader, Vec4Params);
+	ResolveLocations(shader, Mat4Params);
+	ResolveLocations(shader, Mat3Params);
 }
 
 void ShaderMaterial::Set(const std::string& name, const ITexture::sptr& texture) {
-	LOG_ASSERT(Shader != nullptr, "Must set Material shader before setting params");
+	Shader* shader = GetShader();
+	LOG_ASSERT(shader != nullptr, "Must set Material shader before setting params");
 	ShaderParamName pName = name;
-	pName.Location = Shader->GetUniformLocation(name);
-	Textures[pName] = texture;
+	pName.Location = shader->GetUniformLocation(name);
+	Textures[pName] = ResourcePool<ITexture>::Add(texture);
 }
 
 void ShaderMaterial::Set(const std::string& name, float value) {
-	LOG_ASSERT(Shader != nullptr, "Must set Material shader before setting params");
+	Shader* shader = GetShader();
+	LOG_ASSERT(shader != nullptr, "Must set Material shader before setting params");
 	ShaderParamName pName = name;
-	pName.Location = Shader->GetUniformLocation(name);
+	pName.Location = shader->GetUniformLocation(name);
 	FloatParams[pName] = value;
 }
 
 void ShaderMaterial::Set(const std::string& name, const glm::vec2& value) {
-	LOG_ASSERT(Shader != nullptr, "Must set Material shader before setting params");
+	Shader* shader = GetShader();
+	LOG_ASSERT(shader != nullptr, "Must set Material shader before setting params");
 	ShaderParamName pName = name;
-	pName.Location = Shader->GetUniformLocation(name);
+	pName.Location = shader->GetUniformLocation(name);
 	Vec2Params[pName] = value;
 }
 
 void ShaderMaterial::Set(const std::string& name, const glm::vec3& value) {
-	LOG_ASSERT(Shader != nullptr, "Must set Material shader before setting params");
+	Shader* shader = GetShader();
+	LOG_ASSERT(shader != nullptr, "Must set Material shader before setting params");
 	ShaderParamName pName = name;
-	pName.Location = Shader->GetUniformLocation(name);
+	pName.Location = shader->GetUniformLocation(name);
 	Vec3Params[pName] = value;
 }
 
 void ShaderMaterial::Set(const std::string& name, const glm::vec4& value) {
-	LOG_ASSERT(Shader != nullptr, "Must set Material shader before setting params");
+	Shader* shader = GetShader();
+	LOG_ASSERT(shader != nullptr, "Must set Material shader before setting params");
 	ShaderParamName pName = name;
-	pName.Location = Shader->GetUniformLocation(name);
+	pName.Location = shader->GetUniformLocation(name);
 	Vec4Params[pName] = value;
 }
 
 void ShaderMaterial::Set(const std::string& name, const glm::mat4& value) {
-	LOG_ASSERT(Shader != nullptr, "Must set Material shader before setting params");
+	Shader* shader = GetShader();
+	LOG_ASSERT(shader != nullptr, "Must set Material shader before setting params");
 	ShaderParamName pName = name;
-	pName.Location = Shader->GetUniformLocation(name);
+	pName.Location = shader->GetUniformLocation(name);
 	Mat4Params[pName] = value;
 }
 
 void ShaderMaterial::Set(const std::string& name, const glm::mat3& value) {
-	LOG_ASSERT(Shader != nullptr, "Must set Material shader before setting params");
+	Shader* shader = GetShader();
+	LOG_ASSERT(shader != nullptr, "Must set Material shader before setting params");
 	ShaderParamName pName = name;
-	pName.Location = Shader->GetUniformLocation(name);
+	pName.Location = shader->GetUniformLocation(name);
 	Mat3Params[pName] = value;
 }
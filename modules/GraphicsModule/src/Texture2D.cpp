@@ -1,4 +1,5 @@
 #include "Texture2D.h"
+#include "GpuDeletionQueue.h"
 
 Texture2D::Texture2D(const Texture2DDescription& description) :
 	ITexture(), _description(description)
@@ -9,7 +10,7 @@ Texture2D::Texture2D(const Texture2DDescription& description) :
 
 void Texture2D::_RecreateTexture() {
 	if (_handle != 0) {
-		glDeleteTextures(1, &_handle);
+		GpuDeletionQueue::Enqueue(GpuResourceType::Texture, _handle);
 		_handle = 0;
 	}
 
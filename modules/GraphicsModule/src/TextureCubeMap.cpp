@@ -1,4 +1,5 @@
 #include "TextureCubeMap.h"
+#include "GpuDeletionQueue.h"
 
 TextureCubeMap::TextureCubeMap(const TextureCubeDesc& description) :
 	ITexture(), _description(description)
@@ -9,7 +10,7 @@ TextureCubeMap::TextureCubeMap(const TextureCubeDesc& description) :
 
 void TextureCubeMap::_RecreateTexture() {
 	if (_handle != 0) {
-		glDeleteTextures(1, &_handle);
+		GpuDeletionQueue::Enqueue(GpuResourceType::Texture, _handle);
 		_handle = 0;
 	}
 
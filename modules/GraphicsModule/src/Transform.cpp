@@ -6,44 +6,46 @@
 
 #include "Logging.h"
 
-const glm::mat4 IDENTITY = glm::mat4(1.0f);
+Transform::Transform(entt::handle gameObject) :
+	_gameObject(gameObject),
+	_store(&TransformStore::Get(gameObject.registry())),
+	_index(TransformStore::InvalidIndex)
+{
+	_index = _store->Allocate(gameObject.entity());
+}
 
 Transform& Transform::SetLocalRotation(const glm::vec3 eulerDegrees) {
-	_rotationEulerDeg = eulerDegrees;
-	_rotation = glm::quat(glm::radians(eulerDegrees));
-	_isLocalDirty = true;
+	_store->_eulerDeg[_index] = eulerDegrees;
+	_SetRotation(glm::quat(glm::radians(eulerDegrees)));
 	return *this;
 }
 
 Transform& Transform::SetLocalRotation(const glm::quat& quaternion) {
-	_rotation = quaternion;
-	_rotationEulerDeg = glm::degrees(glm::eulerAngles(_rotation));
-	_isLocalDirty = true;
+	_store->_eulerDeg[_index] = glm::degrees(glm::eulerAngles(quaternion));
+	_SetRotation(quaternion);
 	return *this;
 }
 
 Transform& Transform::SetLocalRotation(float yawDeg, float pitchDeg, float rollDeg) {
-	_rotationEulerDeg.x = yawDeg;
-	_rotationEulerDeg.y = pitchDeg;
-	_rotationEulerDeg.z = rollDeg;
-	_rotation = glm::quat(glm::radians(_rotationEulerDeg));
-	_isLocalDirty = true;
+	SetLocalRotation(glm::vec3(yawDeg, pitchDeg, rollDeg));
 	return *this;
 }
 
 Transform& Transform::SetLocalPosition(float x, float y, float z) {
-	_position.x = x;
-	_position.y = y;
-	_position.z = z;
-	_isLocalDirty = true;
+	_store->_SaveFixedState(_index);
+	_store->_posX[_index] = x;
+	_store->_posY[_index] = y;
+	_store->_posZ[_index] = z;
+	_store->_MarkDirty(_index, TransformStore::Flag_LocalDirty);
 	return *this;
 }
 
 Transform& Transform::SetLocalScale(float x, float y, float z) {
-	_scale.x = x;
-	_scale.y = y;
-	_scale.z = z;
-	_isLocalDirty = true;
+	_store->_SaveFixedState(_index);
+	_store->_scaleX[_index] = x;
+	_store->_scaleY[_index] = y;
+	_store->_scaleZ[_index] = z;
+	_store->_MarkDirty(_index, TransformStore::Flag_LocalDirty);
 	return *this;
 }
 
@@ -53,9 +55,7 @@ Transform& Transform::RotateLocal(float yawDeg, float pitchDeg, float rollDeg) {
 }
 
 Transform& Transform::RotateLocalFixed(const glm::vec3& rotationDeg) {
-	_rotation = glm::quat(glm::radians(rotationDeg)) * _rotation;
-	_rotationEulerDeg = glm::degrees(glm::eulerAngles(_rotation));
-	_isLocalDirty = true;
+	SetLocalRotation(glm::quat(glm::radians(rotationDeg)) * GetLocalRotationQuat());
 	return *this;
 }
 
@@ -65,28 +65,23 @@ Transform& Transform::RotateLocalFixed(float yawDeg, float pitchDeg, float rollD
 }
 
 Transform& Transform::SetLocalPosition(const glm::vec3 value) {
-	_position = value;
-	_isLocalDirty = true;
+	SetLocalPosition(value.x, value.y, value.z);
 	return *this;
 }
 
 Transform& Transform::SetLocalScale(const glm::vec3 value) {
-	_scale = value;
-	_isLocalDirty = true;
+	SetLocalScale(value.x, value.y, value.z);
 	return *this;
 }
 
 Transform& Transform::RotateLocal(const glm::vec3& rotation) {
-	_rotation = _rotation * glm::quat(glm::radians(rotation));
-	_rotationEulerDeg = glm::degrees(glm::eulerAngles(_rotation));
-	_isLocalDirty = true;
+	SetLocalRotation(GetLocalRotationQuat() * glm::quat(glm::radians(rotation)));
 	return *this;
 }
 
 Transform& Transform::MoveLocal(const glm::vec3& localMovement)
 {
-	_position += _rotation * localMovement;
-	_isLocalDirty = true;
+	SetLocalPosition(GetLocalPosition() + GetLocalRotationQuat() * localMovement);
 	return *this;
 }
 
@@ -97,81 +92,71 @@ Transform& Transform::MoveLocal(float x, float y, float z) {
 
 Transform& Transform::MoveLocalFixed(const glm::vec3& localMovement)
 {
-	_position += localMovement;
-	_isLocalDirty = true;
+	SetLocalPosition(GetLocalPosition() + localMovement);
 	return *this;
 }
 
 Transform& Transform::MoveLocalFixed(float x, float y, float z) {
-	_position.x += x;
-	_position.y += y;
-	_position.z += z;
-	_isLocalDirty = true;
+	MoveLocalFixed(glm::vec3(x, y, z));
 	return *this;
 }
 
 Transform& Transform::LookAt(const glm::vec3& localSpace)
 {
-	_rotation = glm::quatLookAt(-glm::normalize(_position - localSpace), glm::normalize(_rotation * glm::vec3(0, 0, 1)));
-	_rotationEulerDeg = glm::degrees(glm::eulerAngles(_rotation));
-	_isLocalDirty = true;
+	const glm::vec3 position = GetLocalPosition();
+	const glm::quat rotation = GetLocalRotationQuat();
+	SetLocalRotation(glm::quatLookAt(-glm::normalize(position - localSpace), glm::normalize(rotation * glm::vec3(0, 0, 1))));
 	return *this;
 }
 
 void Transform::Recalculate() const {
-	_UpdateLocalTransformIfDirty();
+	_store->_ComposeLocal(_index);
 }
 
 const glm::mat4& Transform::LocalTransform() const {
 	_UpdateLocalTransformIfDirty();
-	return _localTransform;
+	return _store->_local[_index];
 }
 
 const glm::mat3& Transform::NormalMatrix() const {
 	_UpdateLocalTransformIfDirty();
-	return _normalMatrix;	
+	return _store->_localNormal[_index];
 }
 
 void Transform::SetParent(entt::handle parent)
 {
-	_parent = parent;
 	// If we passed in a handle, make sure it has a transform and belongs to the same scene
 	if (&parent.registry() != nullptr && parent.entity() != entt::null) {
 		LOG_ASSERT(parent.has<Transform>(), "Parent entity must have a transform component");
 		LOG_ASSERT(&parent.registry() == &_gameObject.registry(), "Parent entity must be in same registry!");
-		_hierarchyDepth = parent.get<Transform>()._hierarchyDepth + 1;
+		_store->SetParent(_index, parent.get<Transform>()._index);
 	} else {
-		_hierarchyDepth = 0;
+		_store->SetParent(_index, TransformStore::InvalidIndex);
 	}
-	
-	// Re-calculate hierarchy depth for all children recursively
-	_gameObject.registry().view<Transform>().each([&](entt::entity entity, Transform& t) {
-		if (t._parent == _gameObject) {
-			t.SetParent(entt::handle(parent.registry(), _gameObject));
-		}
-	});
-	// Re-sort components
-	_gameObject.registry().sort<Transform>([](const Transform& l, const Transform& r) {
-		return l.GetHierarchyDepth() < r.GetHierarchyDepth();
-	});
+}
+
+entt::handle Transform::GetParent() const
+{
+	const uint32_t parent = _store->GetParent(_index);
+	return entt::handle(_gameObject.registry(), parent != TransformStore::InvalidIndex ? _store->GetEntity(parent) : entt::null);
 }
 
 void Transform::UpdateWorldMatrix() const {
-	if (_parent != entt::null) {
-		_worldTransform = _gameObject.registry().get<Transform>(_parent)._worldTransform * LocalTransform();
-		_worldNormalMatrix = glm::mat3(glm::transpose(glm::inverse(_worldTransform)));
-	} else {
-		_worldTransform = LocalTransform();
-		_worldNormalMatrix = _normalMatrix;
-	}
+	_UpdateLocalTransformIfDirty();
+	_store->_UpdateWorld(_index);
 }
 
-void Transform::_UpdateLocalTransformIfDirty() const {
-	if (_isLocalDirty) {
-		// TRS
-		_localTransform = glm::translate(IDENTITY, _position) * glm::toMat4(_rotation) * glm::scale(IDENTITY, _scale);
-		_normalMatrix = glm::mat3(glm::transpose(glm::inverse(_localTransform)));
+void Transform::_SetRotation(const glm::quat& rotation) {
+	_store->_SaveFixedState(_index);
+	_store->_rotX[_index] = rotation.x;
+	_store->_rotY[_index] = rotation.y;
+	_store->_rotZ[_index] = rotation.z;
+	_store->_rotW[_index] = rotation.w;
+	_store->_MarkDirty(_index, TransformStore::Flag_LocalDirty);
+}
 
-		_isLocalDirty = false;
+void Transform::_UpdateLocalTransformIfDirty() const {
+	if (_store->_flags[_index] & TransformStore::Flag_LocalDirty) {
+		_store->_ComposeLocal(_index);
 	}
 }
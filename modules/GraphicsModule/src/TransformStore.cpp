@@ -0,0 +1,566 @@
+#include "TransformStore.h"
+
+#include <algorithm>
+#include <GLM/gtc/matrix_inverse.hpp>
+
+#include "Transform.h"
+#include "JobSystem.h"
+#include "Logging.h"
+
+// Reporting writes through the registry is on by default in debug builds
+#if defined(_DEBUG) && !defined(TRANSFORM_STORE_REPORT_WRITES)
+#define TRANSFORM_STORE_REPORT_WRITES 1
+#endif
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define TRANSFORM_STORE_SSE 1
+#include <xmmintrin.h>
+#else
+#define TRANSFORM_STORE_SSE 0
+#endif
+
+// The SIMD compose writes straight into the matrix storage, so make sure GLM hasn't padded anything
+static_assert(sizeof(glm::mat4) == sizeof(float) * 16, "glm::mat4 must be tightly packed");
+static_assert(sizeof(glm::mat3) == sizeof(float) * 9, "glm::mat3 must be tightly packed");
+
+// The number of slots composed per job when composing local matrices in parallel (must be a multiple of 4)
+static constexpr uint32_t ComposeBlockSize = 1024;
+// The number of slots evaluated per job when evaluating a level of world matrices in parallel
+static constexpr uint32_t WorldBlockSize = 512;
+
+TransformStore::TransformStore(entt::registry& registry) :
+	_registry(&registry),
+	_isFixedStep(false),
+	_fixedSaved(std::vector<uint32_t>()),
+	_interpolated(std::vector<uint32_t>()),
+	_indexCount(0),
+	_freeList(std::vector<uint32_t>()),
+	_levels(std::vector<std::vector<uint32_t>>()),
+	_stack(std::vector<uint32_t>()),
+	_dirty(std::vector<uint32_t>()),
+	_dirtyLevels(std::vector<std::vector<uint32_t>>()),
+	_changed(std::vector<uint32_t>()),
+	_changedEntities(std::vector<entt::entity>())
+{
+	// Slots are released when the component is removed, not when the facade is destroyed, since
+	// entt will happily move components around within it's storage
+	_registry->on_destroy<Transform>().connect<&TransformStore::_OnTransformDestroyed>(*this);
+	_Reserve(64);
+}
+
+TransformStore::~TransformStore() {
+	_registry->on_destroy<Transform>().disconnect<&TransformStore::_OnTransformDestroyed>(*this);
+}
+
+TransformStore& TransformStore::Get(entt::registry& registry) {
+	return registry.ctx_or_set<TransformStore>(registry);
+}
+
+uint32_t TransformStore::Allocate(entt::entity entity) {
+	uint32_t index;
+	if (!_freeList.empty()) {
+		index = _freeList.back();
+		_freeList.pop_back();
+	} else {
+		if (_indexCount == _flags.size()) {
+			_Reserve(_flags.size() * 2);
+		}
+		index = _indexCount++;
+	}
+
+	_ResetSlot(index);
+	_entity[index] = entity;
+	_flags[index] = Flag_Alive;
+	_AddToLevel(index, 0);
+	_MarkDirty(index, Flag_LocalDirty);
+	return index;
+}
+
+void TransformStore::Free(uint32_t index) {
+	LOG_ASSERT(index < _indexCount && (_flags[index] & Flag_Alive), "Transform slot is not allocated!");
+
+	// Orphan any children, they become roots
+	while (_firstChild[index] != InvalidIndex) {
+		const uint32_t child = _firstChild[index];
+		_Unlink(child);
+		_UpdateSubtreeDepth(child);
+		_MarkDirty(child);
+	}
+	_Unlink(index);
+	_RemoveFromLevel(index);
+
+	_ResetSlot(index);
+	_freeList.push_back(index);
+}
+
+void TransformStore::SetParent(uint32_t index, uint32_t parent) {
+	if (parent == _parent[index]) {
+		return;
+	}
+	if (parent != InvalidIndex) {
+		// Walk up from the new parent to make sure we are not creating a cycle
+		for (uint32_t ix = parent; ix != InvalidIndex; ix = _parent[ix]) {
+			LOG_ASSERT(ix != index, "Cannot parent a transform to itself or one of it's descendants!");
+		}
+	}
+	_Unlink(index);
+	_Link(index, parent);
+	_UpdateSubtreeDepth(index);
+	_MarkDirty(index);
+}
+
+void TransformStore::UpdateWorldMatrices() {
+	// Clear out the results from the last update
+	for (uint32_t index : _changed) {
+		_flags[index] &= ~Flag_Changed;
+	}
+	_changed.clear();
+	_changedEntities.clear();
+
+	if (_dirty.empty()) {
+		return;
+	}
+
+	// If a large part of the store is dirty (ex: on the first frame) it's faster to stream through everything
+	if (_dirty.size() * 4 >= _indexCount) {
+		_ComposeAll();
+	} else {
+		for (uint32_t index : _dirty) {
+			if (_flags[index] & Flag_LocalDirty) {
+				_ComposeLocal(index);
+			}
+		}
+	}
+
+	// Bucket the dirty slots by depth, so that parents are always evaluated before their children
+	_dirtyLevels.resize(_levels.size());
+	for (std::vector<uint32_t>& level : _dirtyLevels) {
+		level.clear();
+	}
+	for (uint32_t index : _dirty) {
+		// Slots may have been freed (or freed and re-used) since they were queued
+		if ((_flags[index] & (Flag_Alive | Flag_Queued)) == (Flag_Alive | Flag_Queued)) {
+			_flags[index] &= ~Flag_Queued;
+			_flags[index] |= Flag_Changed;
+			_dirtyLevels[_depth[index]].push_back(index);
+		}
+	}
+	_dirty.clear();
+
+	// Walk down the hierarchy one level at a time. A level needs to be evaluated for any slots that were
+	// modified, and any children of slots that changed on the level above
+	for (size_t depth = 0; depth < _dirtyLevels.size(); depth++) {
+		std::vector<uint32_t>& work = _dirtyLevels[depth];
+		if (work.size() >= ParallelThreshold) {
+			JobSystem::ParallelForEach(work.data(), work.size(), WorldBlockSize, [this](uint32_t index) {
+				_UpdateWorld(index);
+			});
+		} else {
+			for (uint32_t index : work) {
+				_UpdateWorld(index);
+			}
+		}
+
+		for (uint32_t index : work) {
+			_changed.push_back(index);
+			_changedEntities.push_back(_entity[index]);
+
+			// Leaves don't have anything to propagate to, so this only visits the subtrees of slots that moved
+			for (uint32_t child = _firstChild[index]; child != InvalidIndex; child = _nextSibling[child]) {
+				if (!(_flags[child] & Flag_Changed)) {
+					_flags[child] |= Flag_Changed;
+					_dirtyLevels[depth + 1].push_back(child);
+				}
+			}
+		}
+	}
+}
+
+void TransformStore::BeginFixedStep() {
+	// We only interpolate across the most recent tick, so forget about anything saved during the last one
+	for (uint32_t index : _fixedSaved) {
+		_flags[index] &= ~Flag_FixedSaved;
+	}
+	_fixedSaved.clear();
+	_isFixedStep = true;
+}
+
+void TransformStore::EndFixedStep() {
+	_isFixedStep = false;
+}
+
+void TransformStore::Interpolate(float alpha) {
+	for (uint32_t index : _interpolated) {
+		_flags[index] &= ~Flag_Interpolated;
+	}
+	_interpolated.clear();
+
+	// Process the saved slots from the top of the hierarchy down, so that by the time we reach a slot that is
+	// already interpolated (because an ancestor moved), it's subtree has been handled
+	std::sort(_fixedSaved.begin(), _fixedSaved.end(), [this](uint32_t a, uint32_t b) { return _depth[a] < _depth[b]; });
+	for (uint32_t root : _fixedSaved) {
+		// Slots may have been freed (or freed and re-used) during the tick
+		if (!(_flags[root] & Flag_FixedSaved) || (_flags[root] & Flag_Interpolated)) {
+			continue;
+		}
+
+		_stack.clear();
+		_stack.push_back(root);
+		while (!_stack.empty()) {
+			const uint32_t index = _stack.back();
+			_stack.pop_back();
+
+			glm::mat4 local = _local[index];
+			if (_flags[index] & Flag_FixedSaved) {
+				const glm::vec3 pos = glm::mix(_prevPos[index], glm::vec3(_posX[index], _posY[index], _posZ[index]), alpha);
+				const glm::quat rot = glm::slerp(_prevRot[index], glm::quat(_rotW[index], _rotX[index], _rotY[index], _rotZ[index]), alpha);
+				const glm::vec3 scale = glm::mix(_prevScale[index], glm::vec3(_scaleX[index], _scaleY[index], _scaleZ[index]), alpha);
+				const glm::mat3 rotation = glm::mat3_cast(rot);
+				local[0] = glm::vec4(rotation[0] * scale.x, 0.0f);
+				local[1] = glm::vec4(rotation[1] * scale.y, 0.0f);
+				local[2] = glm::vec4(rotation[2] * scale.z, 0.0f);
+				local[3] = glm::vec4(pos, 1.0f);
+			}
+
+			const uint32_t parent = _parent[index];
+			_renderWorld[index] = parent != InvalidIndex ? GetRenderMatrix(parent) * local : local;
+			_renderNormal[index] = glm::inverseTranspose(glm::mat3(_renderWorld[index]));
+			_flags[index] |= Flag_Interpolated;
+			_interpolated.push_back(index);
+
+			for (uint32_t child = _firstChild[index]; child != InvalidIndex; child = _nextSibling[child]) {
+				_stack.push_back(child);
+			}
+		}
+	}
+}
+
+void TransformStore::_Reserve(size_t count) {
+	// Keep everything padded to a multiple of 4 so the SIMD compose never needs a tail loop
+	count = (count + 3) & ~size_t(3);
+	if (count <= _flags.size()) {
+		return;
+	}
+
+	_posX.resize(count, 0.0f);
+	_posY.resize(count, 0.0f);
+	_posZ.resize(count, 0.0f);
+	_rotX.resize(count, 0.0f);
+	_rotY.resize(count, 0.0f);
+	_rotZ.resize(count, 0.0f);
+	_rotW.resize(count, 1.0f);
+	_scaleX.resize(count, 1.0f);
+	_scaleY.resize(count, 1.0f);
+	_scaleZ.resize(count, 1.0f);
+
+	_local.resize(count, glm::mat4(1.0f));
+	_localNormal.resize(count, glm::mat3(1.0f));
+	_world.resize(count, glm::mat4(1.0f));
+	_worldNormal.resize(count, glm::mat3(1.0f));
+	_worldInverse.resize(count, glm::mat4(1.0f));
+
+	_parent.resize(count, InvalidIndex);
+	_firstChild.resize(count, InvalidIndex);
+	_nextSibling.resize(count, InvalidIndex);
+	_prevSibling.resize(count, InvalidIndex);
+	_depth.resize(count, 0);
+	_levelPos.resize(count, InvalidIndex);
+	_flags.resize(count, Flag_None);
+
+	_prevPos.resize(count, glm::vec3(0.0f));
+	_prevRot.resize(count, glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+	_prevScale.resize(count, glm::vec3(1.0f));
+	_renderWorld.resize(count, glm::mat4(1.0f));
+	_renderNormal.resize(count, glm::mat3(1.0f));
+
+	_eulerDeg.resize(count, glm::vec3(0.0f));
+	_entity.resize(count, entt::null);
+}
+
+void TransformStore::_ResetSlot(uint32_t index) {
+	_posX[index] = _posY[index] = _posZ[index] = 0.0f;
+	_rotX[index] = _rotY[index] = _rotZ[index] = 0.0f;
+	_rotW[index] = 1.0f;
+	_scaleX[index] = _scaleY[index] = _scaleZ[index] = 1.0f;
+
+	_local[index] = glm::mat4(1.0f);
+	_localNormal[index] = glm::mat3(1.0f);
+	_world[index] = glm::mat4(1.0f);
+	_worldNormal[index] = glm::mat3(1.0f);
+	_worldInverse[index] = glm::mat4(1.0f);
+
+	_parent[index] = InvalidIndex;
+	_firstChild[index] = InvalidIndex;
+	_nextSibling[index] = InvalidIndex;
+	_prevSibling[index] = InvalidIndex;
+	_depth[index] = 0;
+	_levelPos[index] = InvalidIndex;
+	_flags[index] = Flag_None;
+
+	_eulerDeg[index] = glm::vec3(0.0f);
+	_entity[index] = entt::null;
+}
+
+void TransformStore::_Link(uint32_t index, uint32_t parent) {
+	_parent[index] = parent;
+	if (parent != InvalidIndex) {
+		// Push to the front of the parent's child list
+		const uint32_t next = _firstChild[parent];
+		_nextSibling[index] = next;
+		_prevSibling[index] = InvalidIndex;
+		if (next != InvalidIndex) {
+			_prevSibling[next] = index;
+		}
+		_firstChild[parent] = index;
+	}
+}
+
+void TransformStore::_Unlink(uint32_t index) {
+	const uint32_t parent = _parent[index];
+	if (parent != InvalidIndex) {
+		const uint32_t prev = _prevSibling[index];
+		const uint32_t next = _nextSibling[index];
+		if (prev != InvalidIndex) {
+			_nextSibling[prev] = next;
+		} else {
+			_firstChild[parent] = next;
+		}
+		if (next != InvalidIndex) {
+			_prevSibling[next] = prev;
+		}
+	}
+	_parent[index] = InvalidIndex;
+	_nextSibling[index] = InvalidIndex;
+	_prevSibling[index] = InvalidIndex;
+}
+
+void TransformStore::_AddToLevel(uint32_t index, uint32_t depth) {
+	if (depth >= _levels.size()) {
+		_levels.resize(depth + 1);
+		_dirtyLevels.resize(depth + 1);
+	}
+	_depth[index] = depth;
+	_levelPos[index] = static_cast<uint32_t>(_levels[depth].size());
+	_levels[depth].push_back(index);
+}
+
+void TransformStore::_RemoveFromLevel(uint32_t index) {
+	// Swap and pop, so the removal is O(1)
+	std::vector<uint32_t>& level = _levels[_depth[index]];
+	const uint32_t pos = _levelPos[index];
+	const uint32_t last = level.back();
+	level[pos] = last;
+	_levelPos[last] = pos;
+	level.pop_back();
+	_levelPos[index] = InvalidIndex;
+}
+
+void TransformStore::_UpdateSubtreeDepth(uint32_t index) {
+	// Parents are always visited before their children, so we can just look at the parent's depth. If a
+	// slot's depth didn't change, neither did any of it's descendants
+	_stack.clear();
+	_stack.push_back(index);
+	while (!_stack.empty()) {
+		const uint32_t current = _stack.back();
+		_stack.pop_back();
+
+		const uint32_t parent = _parent[current];
+		const uint32_t depth = parent != InvalidIndex ? _depth[parent] + 1 : 0;
+		if (depth == _depth[current]) {
+			continue;
+		}
+		_RemoveFromLevel(current);
+		_AddToLevel(current, depth);
+
+		for (uint32_t child = _firstChild[current]; child != InvalidIndex; child = _nextSibling[child]) {
+			_stack.push_back(child);
+		}
+	}
+}
+
+void TransformStore::_MarkDirty(uint32_t index, uint8_t flags) {
+	#if TRANSFORM_STORE_REPORT_WRITES
+	// Every write to a slot ends up here, so this is where we let anything watching for Transform updates know. The
+	// slot is allocated while the component is being constructed, so the entity may not have it yet
+	if (_registry->has<Transform>(_entity[index])) {
+		_registry->patch<Transform>(_entity[index]);
+	}
+	#endif
+	_flags[index] |= flags;
+	if (!(_flags[index] & Flag_Queued)) {
+		_flags[index] |= Flag_Queued;
+		_dirty.push_back(index);
+	}
+}
+
+void TransformStore::_SaveFixedState(uint32_t index) {
+	if (_isFixedStep && !(_flags[index] & Flag_FixedSaved)) {
+		_prevPos[index] = glm::vec3(_posX[index], _posY[index], _posZ[index]);
+		_prevRot[index] = glm::quat(_rotW[index], _rotX[index], _rotY[index], _rotZ[index]);
+		_prevScale[index] = glm::vec3(_scaleX[index], _scaleY[index], _scaleZ[index]);
+		_flags[index] |= Flag_FixedSaved;
+		_fixedSaved.push_back(index);
+	}
+}
+
+void TransformStore::_ComposeLocal(uint32_t index) {
+	// TRS, the columns of the rotation matrix are scaled, and the translation goes in the last column
+	const glm::mat3 rotation = glm::mat3_cast(glm::quat(_rotW[index], _rotX[index], _rotY[index], _rotZ[index]));
+	const glm::vec3 scale = glm::vec3(_scaleX[index], _scaleY[index], _scaleZ[index]);
+
+	glm::mat4& local = _local[index];
+	local[0] = glm::vec4(rotation[0] * scale.x, 0.0f);
+	local[1] = glm::vec4(rotation[1] * scale.y, 0.0f);
+	local[2] = glm::vec4(rotation[2] * scale.z, 0.0f);
+	local[3] = glm::vec4(_posX[index], _posY[index], _posZ[index], 1.0f);
+
+	// The inverse transpose of R * S is R * S^-1, so we don't need a full matrix inverse
+	_localNormal[index] = glm::mat3(rotation[0] / scale.x, rotation[1] / scale.y, rotation[2] / scale.z);
+
+	_flags[index] &= ~Flag_LocalDirty;
+}
+
+#if TRANSFORM_STORE_SSE
+// Stores the first 3 lanes of a register
+static inline void StoreVec3(float* dest, __m128 value) {
+	_mm_storel_pi(reinterpret_cast<__m64*>(dest), value);
+	_mm_store_ss(dest + 2, _mm_movehl_ps(value, value));
+}
+#endif
+
+void TransformStore::_ComposeRange(uint32_t first, uint32_t count) {
+	#if TRANSFORM_STORE_SSE
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one  = _mm_set1_ps(1.0f);
+	const __m128 two  = _mm_set1_ps(2.0f);
+
+	// Each iteration handles 4 transforms, with each lane of a register belonging to a different transform
+	for (uint32_t ix = first; ix < first + count; ix += 4) {
+		const __m128 qx = _mm_loadu_ps(&_rotX[ix]);
+		const __m128 qy = _mm_loadu_ps(&_rotY[ix]);
+		const __m128 qz = _mm_loadu_ps(&_rotZ[ix]);
+		const __m128 qw = _mm_loadu_ps(&_rotW[ix]);
+
+		// Quaternion to rotation matrix, same as glm::mat3_cast
+		const __m128 xx = _mm_mul_ps(qx, qx), yy = _mm_mul_ps(qy, qy), zz = _mm_mul_ps(qz, qz);
+		const __m128 xy = _mm_mul_ps(qx, qy), xz = _mm_mul_ps(qx, qz), yz = _mm_mul_ps(qy, qz);
+		const __m128 wx = _mm_mul_ps(qw, qx), wy = _mm_mul_ps(qw, qy), wz = _mm_mul_ps(qw, qz);
+
+		const __m128 r00 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz)));
+		const __m128 r01 = _mm_mul_ps(two, _mm_add_ps(xy, wz));
+		const __m128 r02 = _mm_mul_ps(two, _mm_sub_ps(xz, wy));
+		const __m128 r10 = _mm_mul_ps(two, _mm_sub_ps(xy, wz));
+		const __m128 r11 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz)));
+		const __m128 r12 = _mm_mul_ps(two, _mm_add_ps(yz, wx));
+		const __m128 r20 = _mm_mul_ps(two, _mm_add_ps(xz, wy));
+		const __m128 r21 = _mm_mul_ps(two, _mm_sub_ps(yz, wx));
+		const __m128 r22 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy)));
+
+		const __m128 sx = _mm_loadu_ps(&_scaleX[ix]);
+		const __m128 sy = _mm_loadu_ps(&_scaleY[ix]);
+		const __m128 sz = _mm_loadu_ps(&_scaleZ[ix]);
+		const __m128 isx = _mm_div_ps(one, sx);
+		const __m128 isy = _mm_div_ps(one, sy);
+		const __m128 isz = _mm_div_ps(one, sz);
+
+		// Transpose from "one element of 4 matrices" to "one column of each matrix"
+		__m128 c0 = _mm_mul_ps(r00, sx), c1 = _mm_mul_ps(r01, sx), c2 = _mm_mul_ps(r02, sx), c3 = zero;
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+		_mm_storeu_ps(&_local[ix + 0][0].x, c0);
+		_mm_storeu_ps(&_local[ix + 1][0].x, c1);
+		_mm_storeu_ps(&_local[ix + 2][0].x, c2);
+		_mm_storeu_ps(&_local[ix + 3][0].x, c3);
+
+		c0 = _mm_mul_ps(r10, sy), c1 = _mm_mul_ps(r11, sy), c2 = _mm_mul_ps(r12, sy), c3 = zero;
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+		_mm_storeu_ps(&_local[ix + 0][1].x, c0);
+		_mm_storeu_ps(&_local[ix + 1][1].x, c1);
+		_mm_storeu_ps(&_local[ix + 2][1].x, c2);
+		_mm_storeu_ps(&_local[ix + 3][1].x, c3);
+
+		c0 = _mm_mul_ps(r20, sz), c1 = _mm_mul_ps(r21, sz), c2 = _mm_mul_ps(r22, sz), c3 = zero;
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+		_mm_storeu_ps(&_local[ix + 0][2].x, c0);
+		_mm_storeu_ps(&_local[ix + 1][2].x, c1);
+		_mm_storeu_ps(&_local[ix + 2][2].x, c2);
+		_mm_storeu_ps(&_local[ix + 3][2].x, c3);
+
+		c0 = _mm_loadu_ps(&_posX[ix]), c1 = _mm_loadu_ps(&_posY[ix]), c2 = _mm_loadu_ps(&_posZ[ix]), c3 = one;
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+		_mm_storeu_ps(&_local[ix + 0][3].x, c0);
+		_mm_storeu_ps(&_local[ix + 1][3].x, c1);
+		_mm_storeu_ps(&_local[ix + 2][3].x, c2);
+		_mm_storeu_ps(&_local[ix + 3][3].x, c3);
+
+		// Normal matrices are R * S^-1
+		c0 = _mm_mul_ps(r00, isx), c1 = _mm_mul_ps(r01, isx), c2 = _mm_mul_ps(r02, isx), c3 = zero;
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+		StoreVec3(&_localNormal[ix + 0][0].x, c0);
+		StoreVec3(&_localNormal[ix + 1][0].x, c1);
+		StoreVec3(&_localNormal[ix + 2][0].x, c2);
+		StoreVec3(&_localNormal[ix + 3][0].x, c3);
+
+		c0 = _mm_mul_ps(r10, isy), c1 = _mm_mul_ps(r11, isy), c2 = _mm_mul_ps(r12, isy), c3 = zero;
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+		StoreVec3(&_localNormal[ix + 0][1].x, c0);
+		StoreVec3(&_localNormal[ix + 1][1].x, c1);
+		StoreVec3(&_localNormal[ix + 2][1].x, c2);
+		StoreVec3(&_localNormal[ix + 3][1].x, c3);
+
+		c0 = _mm_mul_ps(r20, isz), c1 = _mm_mul_ps(r21, isz), c2 = _mm_mul_ps(r22, isz), c3 = zero;
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+		StoreVec3(&_localNormal[ix + 0][2].x, c0);
+		StoreVec3(&_localNormal[ix + 1][2].x, c1);
+		StoreVec3(&_localNormal[ix + 2][2].x, c2);
+		StoreVec3(&_localNormal[ix + 3][2].x, c3);
+
+		for (uint32_t lane = 0; lane < 4; lane++) {
+			_flags[ix + lane] &= ~Flag_LocalDirty;
+		}
+	}
+	#else
+	for (uint32_t ix = first; ix < first + count; ix++) {
+		_ComposeLocal(ix);
+	}
+	#endif
+}
+
+void TransformStore::_ComposeAll() {
+	// Compose all of the local matrices, padding slots included, since branching is more expensive than
+	// composing an identity matrix
+	const uint32_t count = (_indexCount + 3) & ~3u;
+	if (count >= ParallelThreshold) {
+		JobSystem::ParallelFor(count, ComposeBlockSize, [this](size_t first, size_t last) {
+			_ComposeRange(static_cast<uint32_t>(first), static_cast<uint32_t>(last - first));
+		});
+	} else {
+		_ComposeRange(0, count);
+	}
+}
+
+void TransformStore::_UpdateWorld(uint32_t index) {
+	const uint32_t parent = _parent[index];
+	_world[index] = parent != InvalidIndex ? _world[parent] * _local[index] : _local[index];
+	// The normal and inverse matrices are calculated on demand, since most transforms never need them
+	_flags[index] |= Flag_NormalDirty | Flag_InverseDirty;
+}
+
+const glm::mat3& TransformStore::_GetWorldNormal(uint32_t index) {
+	if (_flags[index] & Flag_NormalDirty) {
+		_worldNormal[index] = glm::inverseTranspose(glm::mat3(_world[index]));
+		_flags[index] &= ~Flag_NormalDirty;
+	}
+	return _worldNormal[index];
+}
+
+const glm::mat4& TransformStore::_GetWorldInverse(uint32_t index) {
+	if (_flags[index] & Flag_InverseDirty) {
+		_worldInverse[index] = glm::affineInverse(_world[index]);
+		_flags[index] &= ~Flag_InverseDirty;
+	}
+	return _worldInverse[index];
+}
+
+void TransformStore::_OnTransformDestroyed(entt::registry& registry, entt::entity entity) {
+	Free(registry.get<Transform>(entity).GetStoreIndex());
+}
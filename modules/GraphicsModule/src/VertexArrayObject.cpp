@@ -1,6 +1,7 @@
 #include "VertexArrayObject.h"
 #include "IndexBuffer.h"
 #include "Logging.h"
+#include "GpuDeletionQueue.h"
 #include "VertexBuffer.h"
 
 VertexArrayObject::VertexArrayObject() :
@@ -14,7 +15,7 @@ VertexArrayObject::VertexArrayObject() :
 VertexArrayObject::~VertexArrayObject()
 {
 	if (_handle != 0) {
-		glDeleteVertexArrays(1, &_handle);
+		GpuDeletionQueue::Enqueue(GpuResourceType::VertexArray, _handle);
 		_handle = 0;
 	}
 }
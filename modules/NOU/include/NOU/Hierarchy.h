@@ -0,0 +1,73 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+
+Hierarchy.h
+Flattened, linear-time evaluation of a transform hierarchy.
+*/
+
+#pragma once
+
+#include "GLM/glm.hpp"
+
+#include <vector>
+
+namespace nou
+{
+	class Transform;
+
+	//A flattened copy of a transform hierarchy.
+	//Nodes are stored breadth-first, so a node's parent always comes
+	//before it - that means we can evaluate the whole hierarchy with
+	//a single loop over contiguous arrays, instead of recursing through
+	//pointers to each child.
+	//The flattened form is rebuilt automatically the next time it is
+	//evaluated after any parent changes.
+	class Hierarchy
+	{
+		public:
+
+		Hierarchy(Transform* root);
+		~Hierarchy() = default;
+
+		//Computes the global transform of every node in the hierarchy,
+		//and copies it back into each Transform.
+		//If joints have been set, this also updates the bone palette.
+		void Evaluate();
+
+		//Global transforms, in the same order as GetNodes().
+		const std::vector<glm::mat4>& GetGlobals() const;
+		//Index of each node's parent, or -1 for the root.
+		const std::vector<int>& GetParents() const;
+		const std::vector<Transform*>& GetNodes() const;
+
+		//Returns the index of a node within the flattened arrays,
+		//or -1 if it is not part of this hierarchy.
+		int IndexOf(const Transform* node) const;
+
+		//Sets the joints of a skin, along with their inverse bind matrices.
+		//The joints must be part of this hierarchy.
+		void SetJoints(const std::vector<Transform*>& joints,
+					   const std::vector<glm::mat4>& inverseBind);
+
+		//The bone palette (joint global * inverse bind) for each joint,
+		//in the order the joints were given to SetJoints.
+		//This can be uploaded straight to a uniform array for skinning.
+		const std::vector<glm::mat4>& GetPalette() const;
+
+		protected:
+
+		Transform* m_root;
+		size_t m_version;
+
+		std::vector<Transform*> m_nodes;
+		std::vector<int> m_parents;
+		std::vector<glm::mat4> m_globals;
+
+		std::vector<Transform*> m_joints;
+		std::vector<int> m_jointIndices;
+		std::vector<glm::mat4> m_inverseBind;
+		std::vector<glm::mat4> m_palette;
+
+		void Rebuild();
+	};
+}
@@ -14,6 +14,9 @@ Simple class for managing object transforms with basic hierarchy support.
 #include "GLM/gtx/quaternion.hpp"
 
 #include <vector>
+#include <memory>
+
+#include "Hierarchy.h"
 
 //Simple implementation of a transform component.
 
@@ -28,7 +31,7 @@ namespace nou
 		glm::quat m_rotation;
 
 		Transform();
-		Transform(const Transform& other) = default;
+		Transform(const Transform& other);
 		virtual ~Transform();
 
 		//This will update the transform on the object
@@ -37,8 +40,19 @@ namespace nou
 		//call this once per frame before making all of your draw
 		//calls on the root node of your Scene.
 		//(FK stands for "forward kinematics", by the way.)
+		//The first call flattens the hierarchy below this object
+		//(see Hierarchy.h), after that it's a single linear pass
+		//until a parent changes somewhere.
 		void DoFK();
 
+		//Returns the flattened hierarchy used by DoFK, creating
+		//it if needed. Use this to set up joints for skinning.
+		Hierarchy& GetHierarchy();
+
+		//This is incremented whenever any object's parent changes,
+		//so flattened hierarchies know when to rebuild.
+		static size_t GetHierarchyVersion();
+
 		//This will recompute and return the global transform
 		//of this object.
 		const glm::mat4& RecomputeGlobal();
@@ -60,11 +74,18 @@ namespace nou
 
 		protected:
 
+		friend class Hierarchy;
+
+		static size_t s_hierarchyVersion;
+
 		Transform* m_parent;
 		std::vector<Transform*> m_children;
 
 		glm::mat4 m_global;
 
+		//Cached flattened hierarchy with this object as the root.
+		std::unique_ptr<Hierarchy> m_hierarchy;
+
 		//These functions are protected since they will be handled
 		//by SetParent - we don't want to have to manually update this ourselves
 		//whenever we switch an object's parent!
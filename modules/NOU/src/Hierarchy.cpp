@@ -0,0 +1,130 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+
+Hierarchy.cpp
+Flattened, linear-time evaluation of a transform hierarchy.
+*/
+
+#include "NOU/Hierarchy.h"
+#include "NOU/Transform.h"
+
+#include "GLM/gtx/transform.hpp"
+
+namespace nou
+{
+	Hierarchy::Hierarchy(Transform* root)
+	{
+		m_root = root;
+		//Force a rebuild on the first evaluation.
+		m_version = Transform::GetHierarchyVersion() - 1;
+	}
+
+	void Hierarchy::Evaluate()
+	{
+		if (m_version != Transform::GetHierarchyVersion())
+			Rebuild();
+
+		//The root's parent (if it has one) isn't part of this hierarchy,
+		//so we use whatever global transform it already has.
+		glm::mat4 rootParent = (m_root->m_parent != nullptr) ?
+							   m_root->m_parent->m_global : glm::mat4(1.0f);
+
+		//Parents always come before their children, so by the time we
+		//get to a node, its parent's global transform is already done.
+		for (size_t i = 0; i < m_nodes.size(); ++i)
+		{
+			Transform* node = m_nodes[i];
+
+			glm::mat4 local = glm::translate(node->m_pos) *
+							  glm::toMat4(glm::normalize(node->m_rotation)) *
+							  glm::scale(node->m_scale);
+
+			const int parent = m_parents[i];
+			m_globals[i] = ((parent >= 0) ? m_globals[parent] : rootParent) * local;
+			node->m_global = m_globals[i];
+		}
+
+		for (size_t i = 0; i < m_jointIndices.size(); ++i)
+		{
+			m_palette[i] = m_globals[m_jointIndices[i]] * m_inverseBind[i];
+		}
+	}
+
+	const std::vector<glm::mat4>& Hierarchy::GetGlobals() const
+	{
+		return m_globals;
+	}
+
+	const std::vector<int>& Hierarchy::GetParents() const
+	{
+		return m_parents;
+	}
+
+	const std::vector<Transform*>& Hierarchy::GetNodes() const
+	{
+		return m_nodes;
+	}
+
+	int Hierarchy::IndexOf(const Transform* node) const
+	{
+		for (size_t i = 0; i < m_nodes.size(); ++i)
+		{
+			if (m_nodes[i] == node)
+				return static_cast<int>(i);
+		}
+
+		return -1;
+	}
+
+	void Hierarchy::SetJoints(const std::vector<Transform*>& joints,
+							  const std::vector<glm::mat4>& inverseBind)
+	{
+		m_joints = joints;
+		m_inverseBind = inverseBind;
+		m_inverseBind.resize(m_joints.size(), glm::mat4(1.0f));
+		m_palette.assign(m_joints.size(), glm::mat4(1.0f));
+
+		//Joint indices are resolved when we rebuild.
+		m_version = Transform::GetHierarchyVersion() - 1;
+	}
+
+	const std::vector<glm::mat4>& Hierarchy::GetPalette() const
+	{
+		return m_palette;
+	}
+
+	void Hierarchy::Rebuild()
+	{
+		m_nodes.clear();
+		m_parents.clear();
+
+		//Breadth-first walk - we use the node array itself as our queue,
+		//which also guarantees parents come before children.
+		m_nodes.push_back(m_root);
+		m_parents.push_back(-1);
+
+		for (size_t i = 0; i < m_nodes.size(); ++i)
+		{
+			for (auto* child : m_nodes[i]->m_children)
+			{
+				m_nodes.push_back(child);
+				m_parents.push_back(static_cast<int>(i));
+			}
+		}
+
+		m_globals.resize(m_nodes.size(), glm::mat4(1.0f));
+
+		m_jointIndices.resize(m_joints.size());
+		for (size_t i = 0; i < m_joints.size(); ++i)
+		{
+			m_jointIndices[i] = IndexOf(m_joints[i]);
+
+			//A joint that isn't under our root would index out of bounds,
+			//so we just bind it to the root instead.
+			if (m_jointIndices[i] < 0)
+				m_jointIndices[i] = 0;
+		}
+
+		m_version = Transform::GetHierarchyVersion();
+	}
+}
@@ -12,6 +12,8 @@ Simple class for managing object transforms with basic hierarchy support.
 
 namespace nou
 {
+	size_t Transform::s_hierarchyVersion = 0;
+
 	Transform::Transform()
 	{
 		m_parent = nullptr;
@@ -23,35 +25,47 @@ namespace nou
 		m_global = glm::mat4(1.0f);
 	}
 
+	Transform::Transform(const Transform& other)
+	{
+		m_pos = other.m_pos;
+		m_scale = other.m_scale;
+		m_rotation = other.m_rotation;
+		m_global = other.m_global;
+
+		//The copy gets the same parent, but not the children
+		//(they can only have one parent) or the flattened cache.
+		m_parent = nullptr;
+		SetParent(other.m_parent);
+	}
+
 	Transform::~Transform()
 	{
 		SetParent(nullptr);
+
+		//Any children we leave behind become roots.
+		while (!m_children.empty())
+			m_children.back()->SetParent(nullptr);
 	}
 
 	void Transform::DoFK()
 	{
-		//First, grab our local transform...
-		glm::mat4 local = glm::translate(m_pos) *
-						  glm::toMat4(glm::normalize(m_rotation)) *
-						  glm::scale(m_scale);
+		//Rather than computing our local transform and recursing into
+		//each child, we flatten the hierarchy once so parents always come
+		//before children, and then update the whole thing in one loop.
+		GetHierarchy().Evaluate();
+	}
 
-		//If we have a parent, we need to multiply by our parent's
-		//global transform.
-		if (m_parent != nullptr)
-			m_global = m_parent->m_global * local;
+	Hierarchy& Transform::GetHierarchy()
+	{
+		if (m_hierarchy == nullptr)
+			m_hierarchy = std::make_unique<Hierarchy>(this);
 
-		//If we have no parent object, our global transform is our
-		//local transform!
-		else
-			m_global = local;
+		return *m_hierarchy;
+	}
 
-		//FK is recursive - we now repeat this process on our child nodes.
-		//Eventually, we'll be at the bottom of the hierarchy and this will
-		//return.
-		for (auto* child : m_children)
-		{
-			child->DoFK();
-		}
+	size_t Transform::GetHierarchyVersion()
+	{
+		return s_hierarchyVersion;
 	}
 
 	const glm::mat4& Transform::RecomputeGlobal()
@@ -109,7 +123,10 @@ namespace nou
 
 		//If we have a parent now, add this as a child to that object.
 		if(m_parent != nullptr)
-			m_parent->AddChild(this);			
+			m_parent->AddChild(this);
+
+		//Any flattened hierarchies will need to be rebuilt.
+		++s_hierarchyVersion;
 	}
 
 	void Transform::AddChild(Transform* child)
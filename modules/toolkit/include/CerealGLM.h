@@ -4,7 +4,8 @@
 #include <cstdint>
 #include <cstddef>
 #include <cereal/cereal.hpp>
-#include <glm/glm.hpp>
+#include <GLM/glm.hpp>
+#include <GLM/gtc/quaternion.hpp>
 
 namespace glm
 {
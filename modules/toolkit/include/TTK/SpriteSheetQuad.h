@@ -118,6 +118,7 @@ namespace TTK {
 		};
 
 		int   m_CurrentFrame;
+		int   m_UploadedFrame;
 		float m_FrameTime;
 		bool  m_DoesLoop;
 		Texture2D m_Texture;
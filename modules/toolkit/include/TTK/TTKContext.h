@@ -87,13 +87,24 @@ namespace TTK
 
 		GLuint m_ShaderHandle;
 		GLuint m_PointShaderHandle;
+		// The vertex buffers are persistently mapped rings, each flush writes into the next segment so
+		// we never have to wait on the GPU unless it is a full ring behind. A batch can flush several times
+		// in a frame when it fills up, so the ring has room for that many flushes for every frame the GPU
+		// can be working on (the frame pacer allows 2 in flight, plus the one we are building)
+		static const int MaxFramesInFlight = 3;
+		static const int MaxFlushesPerFrame = 4;
+		static const int RingSegments = MaxFramesInFlight * MaxFlushesPerFrame;
 		struct GLBuff {
 			GLuint VBO, VAO;
 			size_t Count;
 			size_t ElemSize;
+			size_t MaxElems;
 			GLenum Mode;
 			void*  Data;
 			GLuint Shader;
+			void*  Mapped;
+			int    Segment;
+			GLsync Fences[RingSegments];
 		};
 		GLBuff m_Tris, m_Lines, m_Points;
 
@@ -102,6 +113,7 @@ namespace TTK
 
 		GLBuff __InitBuff(GLenum mode, GLuint shader, void* dataSource, size_t elemSize, size_t maxElems);
 		void __Flush(GLBuff& buff);
+		void __FreeBuff(GLBuff& buff);
 		GLuint __CompileShader(const char* vsSource, const char* fsSource);
 
 		static const size_t MaxPointVerts = 512;
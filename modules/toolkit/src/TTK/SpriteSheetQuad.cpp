@@ -17,6 +17,7 @@ TTK::SpriteSheetQuad::SpriteSheetQuad()
 	m_CurrentFrame = 0;
 	m_FrameTime = 0;
 	m_Color = glm::vec4(1.0f);
+	m_UploadedFrame = -1;
 	m_FrameLength = std::vector<float>();
 	m_SpriteCoordinates = std::vector<SpriteCoordinates>();
 	m_Texture = TTK::Texture2D();
@@ -32,10 +33,11 @@ TTK::SpriteSheetQuad::SpriteSheetQuad()
 	glBindVertexArray(m_VAO);
 	glCreateBuffers(1, &m_VBO);
 	glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(QuadVert) * 4, m_Vertices, GL_STREAM_DRAW);
+	// The quad never changes size, so we use immutable storage and only update the contents when our frame changes
+	glNamedBufferStorage(m_VBO, sizeof(QuadVert) * 4, m_Vertices, GL_DYNAMIC_STORAGE_BIT);
 	glCreateBuffers(1, &m_EBO);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint32_t) * 6, indices, GL_STATIC_DRAW);
+	glNamedBufferStorage(m_EBO, sizeof(uint32_t) * 6, indices, 0);
 	#pragma warning(push)
 	#pragma warning(disable: 6011)
 	QuadVert* nullVert = nullptr;
@@ -97,6 +99,7 @@ void TTK::SpriteSheetQuad::SliceSpriteSheet(const char* fileName, float spriteSi
 void TTK::SpriteSheetQuad::SliceSpriteSheet(const char* fileName, int numSpritesPerRow, int numRows, float animTime)
 {
 	m_Texture.LoadTextureFromFile(fileName);
+	m_UploadedFrame = -1;
 
 	float spriteWidth = static_cast<float>(m_Texture.GetWidth()) / numSpritesPerRow;
 	float spriteHeight = static_cast<float>(m_Texture.GetHeight()) / numRows;
@@ -158,14 +161,19 @@ void TTK::SpriteSheetQuad::SetLooping(bool loop) {
 
 void TTK::SpriteSheetQuad::Draw(const glm::mat4& matrix)
 {
-	SpriteCoordinates sc = m_SpriteCoordinates[m_CurrentFrame];
-
-	// set the UVs for the quad
-	// quad.textureCoordinates //messy
-	m_Vertices[0].Texture = { sc.uMin, sc.vMin };
-	m_Vertices[1].Texture = { sc.uMax, sc.vMin };
-	m_Vertices[2].Texture = { sc.uMin, sc.vMax };
-	m_Vertices[3].Texture = { sc.uMax, sc.vMax };
+	// Only upload new UVs when the frame has changed since our last draw
+	if (m_UploadedFrame != m_CurrentFrame) {
+		SpriteCoordinates sc = m_SpriteCoordinates[m_CurrentFrame];
+
+		// set the UVs for the quad
+		// quad.textureCoordinates //messy
+		m_Vertices[0].Texture = { sc.uMin, sc.vMin };
+		m_Vertices[1].Texture = { sc.uMax, sc.vMin };
+		m_Vertices[2].Texture = { sc.uMin, sc.vMax };
+		m_Vertices[3].Texture = { sc.uMax, sc.vMax };
+		glNamedBufferSubData(m_VBO, 0, sizeof(QuadVert) * 4, m_Vertices);
+		m_UploadedFrame = m_CurrentFrame;
+	}
 	
 	int currentProgram, currentVAO;
 	glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
@@ -175,7 +183,6 @@ void TTK::SpriteSheetQuad::Draw(const glm::mat4& matrix)
 	glProgramUniformMatrix4fv(m_Shader, 0, 1, false, &matrix[0][0]);
 	m_Texture.Bind();
 	glBindVertexArray(m_VAO);
-	glNamedBufferData(m_VBO, sizeof(QuadVert) * 4, m_Vertices, GL_STREAM_DRAW);
 	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
 	m_Texture.Unbind();
 	glBindVertexArray(currentVAO);
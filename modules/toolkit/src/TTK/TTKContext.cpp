@@ -13,6 +13,7 @@
 #include "TTK/TTKContext.h"
 #include <GLM/gtc/matrix_transform.hpp>
 #include <string>
+#include <cstring>
 #include "Logging.h"
 #include "TTK/MeshHelper.h"
 
@@ -21,12 +22,9 @@ TTK::Context* TTK::Context::m_Instance = nullptr;
 TTK::Context::~Context() {
 	delete m_MeshHelper;
 	delete m_DefaultFont;
-	glDeleteBuffers(1, &m_Tris.VBO);
-	glDeleteBuffers(1, &m_Lines.VBO);
-	glDeleteBuffers(1, &m_Points.VBO);
-	glDeleteVertexArrays(1, &m_Tris.VAO);
-	glDeleteVertexArrays(1, &m_Lines.VAO);
-	glDeleteVertexArrays(1, &m_Points.VAO);
+	__FreeBuff(m_Tris);
+	__FreeBuff(m_Lines);
+	__FreeBuff(m_Points);
 	glDeleteProgram(m_ShaderHandle);
 }
 
@@ -171,7 +169,7 @@ TTK::Context::Context() {
 	glVertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(SimpleVert), (void*)offsetof(SimpleVert, Position));
 	glVertexAttribPointer(1, 4, GL_FLOAT, false, sizeof(SimpleVert), (void*)offsetof(SimpleVert, Color));
 
-	m_Points = __InitBuff(GL_POINTS, m_PointShaderHandle, m_PointVerts, sizeof(PointVert), MaxLineVerts);
+	m_Points = __InitBuff(GL_POINTS, m_PointShaderHandle, m_PointVerts, sizeof(PointVert), MaxPointVerts);
 	glEnableVertexAttribArray(0);
 	glEnableVertexAttribArray(1);
 	glEnableVertexAttribArray(2);
@@ -195,28 +193,60 @@ TTK::Context::GLBuff TTK::Context::__InitBuff(GLenum mode, GLuint shader, void*
 	result.Count = 0;
 	result.Data = dataSource;
 	result.ElemSize = elemSize;
+	result.MaxElems = maxElems;
 	result.Shader = shader;
+	result.Segment = 0;
+	for (int ix = 0; ix < RingSegments; ix++) {
+		result.Fences[ix] = nullptr;
+	}
 
 	glCreateVertexArrays(1, &result.VAO);
 	glBindVertexArray(result.VAO);
 	glCreateBuffers(1, &result.VBO);
 	glBindBuffer(GL_ARRAY_BUFFER, result.VBO);
-	glNamedBufferData(result.VBO, elemSize * maxElems, nullptr, GL_STREAM_DRAW);
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glNamedBufferStorage(result.VBO, elemSize * maxElems * RingSegments, nullptr, flags);
+	result.Mapped = glMapNamedBufferRange(result.VBO, 0, elemSize * maxElems * RingSegments, flags);
 
 	return result;
 }
 
 void TTK::Context::__Flush(GLBuff& buff) {
 	if (buff.Count > 0) {
+		// Make sure the GPU is done reading from the segment we are about to overwrite
+		GLsync& fence = buff.Fences[buff.Segment];
+		if (fence != nullptr) {
+			while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) { }
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+
+		size_t firstElem = buff.Segment * buff.MaxElems;
+		memcpy(static_cast<char*>(buff.Mapped) + firstElem * buff.ElemSize, buff.Data, buff.Count * buff.ElemSize);
+
 		glUseProgram(buff.Shader);
 		glUniformMatrix4fv(0, 1, false, &m_ViewProjection[0][0]);
-		glNamedBufferSubData(buff.VBO, 0, buff.Count * buff.ElemSize, buff.Data);
 		glBindVertexArray(buff.VAO);
-		glDrawArrays(buff.Mode, 0, static_cast<GLsizei>(buff.Count));
+		glDrawArrays(buff.Mode, static_cast<GLint>(firstElem), static_cast<GLsizei>(buff.Count));
+
+		fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		buff.Segment = (buff.Segment + 1) % RingSegments;
 		buff.Count = 0;
 	}
 }
 
+void TTK::Context::__FreeBuff(GLBuff& buff) {
+	for (int ix = 0; ix < RingSegments; ix++) {
+		if (buff.Fences[ix] != nullptr) {
+			glDeleteSync(buff.Fences[ix]);
+			buff.Fences[ix] = nullptr;
+		}
+	}
+	glUnmapNamedBuffer(buff.VBO);
+	glDeleteBuffers(1, &buff.VBO);
+	glDeleteVertexArrays(1, &buff.VAO);
+}
+
 GLuint TTK::Context::__CompileShader(const char* vsSource, const char* fsSource)
 {
 	GLuint result = glCreateProgram();
@@ -27,11 +27,11 @@ uniform float u_TextureMix;
 
 uniform vec3  u_CamPos;
 
-uniform int u_Mode;
-
+// Lighting mode and rim lighting are compile-time permutations, the defines are injected by the Shader class
+// LIGHTING_NONE, LIGHTING_AMBIENT_ONLY, LIGHTING_SPECULAR_ONLY select the mode, otherwise ambient + specular
+// RIM_LIGHTING enables the rim light
 
 //rim lighting 
-uniform int u_rim;
 vec3 rimLightPos = vec3(1,1,1);//
 float rimPower = 2;//power
 float rimScale = 2;//area reached
@@ -74,42 +74,33 @@ void main() {
 
 	vec3 result = inColor * textureColor.rgb;
 	
+	vec3 rimResult = vec3(0);
+#ifdef RIM_LIGHTING
 	//Rim Light	calculation from https://www.shadertoy.com/view/wdtcDX
 	float rim= clamp(1-dot(viewDir,N),0,1);
 	vec3 rimColor = (pow(rim,rimPower)*rimLightPos)*rimScale;
 	float NdL=1-dot(lightDir,N);
 
-	vec3 rimResult=vec3(0.4,0.4,1.0)*rimColor*NdL;
-
-	if(u_rim==1)
-		rimResult=vec3(0.4,0.4,1.0)*rimColor*NdL;
-	else
-		rimResult=vec3(0);
-
-	if(u_Mode == 1)
-	{
-		result = inColor * textureColor.rgb; // Object color
-	}
-	else if(u_Mode == 2)
-	{
-		result = (
-		(u_AmbientCol * u_AmbientStrength) + // global ambient light
-		(ambient) * attenuation // light factors from our single light
-		) * inColor * textureColor.rgb; // Object color
-	}
-	else if(u_Mode == 3)
-	{
-		result = (
-		(specular) * attenuation // light factors from our single light
-		) * inColor * textureColor.rgb; // Object color
-	}
-	else
-	{
-		result = (
-		(u_AmbientCol * u_AmbientStrength) + // global ambient light
-		(ambient + diffuse + specular) * attenuation // light factors from our single light
-		) * inColor * textureColor.rgb; // Object color	
-	}
+	rimResult=vec3(0.4,0.4,1.0)*rimColor*NdL;
+#endif
+
+#if defined(LIGHTING_NONE)
+	result = inColor * textureColor.rgb; // Object color
+#elif defined(LIGHTING_AMBIENT_ONLY)
+	result = (
+	(u_AmbientCol * u_AmbientStrength) + // global ambient light
+	(ambient) * attenuation // light factors from our single light
+	) * inColor * textureColor.rgb; // Object color
+#elif defined(LIGHTING_SPECULAR_ONLY)
+	result = (
+	(specular) * attenuation // light factors from our single light
+	) * inColor * textureColor.rgb; // Object color
+#else
+	result = (
+	(u_AmbientCol * u_AmbientStrength) + // global ambient light
+	(ambient + diffuse + specular) * attenuation // light factors from our single light
+	) * inColor * textureColor.rgb; // Object color	
+#endif
 
 	frag_color = vec4(result+rimResult, textureColor.a);
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "Framebuffer.h"
+#include <GpuDeletionQueue.h>
 
 GLuint Framebuffer::_fullscreenQuadVBO = 0;
 GLuint Framebuffer::_fullscreenQuadVAO = 0;
@@ -14,8 +15,9 @@ DepthTarget::~DepthTarget()
 
 void DepthTarget::Unload()
 {
-	//Deletes the texture at the specific handle
-	glDeleteTextures(1, &_texture.GetHandle());
+	//Queues the texture at the specific handle for deletion once the GPU is done with it
+	GpuDeletionQueue::Enqueue(GpuResourceType::Texture, _texture.GetHandle());
+	_texture.GetHandle() = 0;
 }
 
 ColorTarget::~ColorTarget()
@@ -26,7 +28,11 @@ ColorTarget::~ColorTarget()
 
 void ColorTarget::Unload()
 {
-	glDeleteTextures(_numAttachments, &_textures[0].GetHandle());
+	//Queues each of the attachments for deletion once the GPU is done with them
+	for (unsigned i = 0; i < _numAttachments && i < _textures.size(); i++) {
+		GpuDeletionQueue::Enqueue(GpuResourceType::Texture, _textures[i].GetHandle());
+		_textures[i].GetHandle() = 0;
+	}
 }
 
 Framebuffer::Framebuffer()
@@ -40,8 +46,9 @@ Framebuffer::~Framebuffer()
 
 void Framebuffer::Unload()
 {
-	//Deletes the framebuffer
-	glDeleteFramebuffers(1, &_FBO);
+	//Queues the framebuffer for deletion once the GPU is done with it
+	GpuDeletionQueue::Enqueue(GpuResourceType::Framebuffer, _FBO);
+	_FBO = 0;
 	//Sets init to false
 	_isInit = false;
 }
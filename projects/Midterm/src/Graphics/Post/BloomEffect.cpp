@@ -65,6 +65,7 @@ void BloomEffect::Init(unsigned width, unsigned height)
 void BloomEffect::ApplyEffect(PostEffect* buffer)
 {
 	//Draws previous buffer to first render target
+	GpuProfiler::BeginRegion("Copy");
 	BindShader(0);
 
 	buffer->BindColorAsTexture(0, 0, 0);
@@ -74,9 +75,11 @@ void BloomEffect::ApplyEffect(PostEffect* buffer)
 	buffer->UnbindTexture(0);
 
 	UnbindShader();
+	GpuProfiler::EndRegion();
 
 
 	//Performs high pass on the first render target using the BloomBrightPass fragment shader
+	GpuProfiler::BeginRegion("Bright Pass");
 	BindShader(1);
 	_shaders[1]->SetUniform("u_Threshold", _threshold);
 
@@ -87,9 +90,11 @@ void BloomEffect::ApplyEffect(PostEffect* buffer)
 	UnbindTexture(0);
 
 	UnbindShader();
+	GpuProfiler::EndRegion();
 
 
 	//Computes blur, vertical and horizontal with the respective Blur fragment shaders
+	GpuProfiler::BeginRegion("Blur");
 	for (unsigned i = 0; i < _passes; i++)
 	{
 		//Horizontal pass
@@ -116,9 +121,11 @@ void BloomEffect::ApplyEffect(PostEffect* buffer)
 
 		UnbindShader();
 	}
+	GpuProfiler::EndRegion();
 
 
 	//Composite the scene and the bloom with the BloomComposite.frag
+	GpuProfiler::BeginRegion("Composite");
 	BindShader(4);
 
 	buffer->BindColorAsTexture(0, 0, 0);
@@ -130,6 +137,7 @@ void BloomEffect::ApplyEffect(PostEffect* buffer)
 	UnbindTexture(0);
 
 	UnbindShader();
+	GpuProfiler::EndRegion();
 }
 
 void BloomEffect::Reshape(unsigned width, unsigned height)
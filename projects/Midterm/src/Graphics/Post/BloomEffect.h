@@ -8,6 +8,8 @@ public:
 
 	void ApplyEffect(PostEffect* buffer) override;
 
+	const char* GetName() const override { return "Bloom"; }
+
 	void Reshape(unsigned width, unsigned height) override;
 
 	float GetDownscale() const;
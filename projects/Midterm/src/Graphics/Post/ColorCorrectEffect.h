@@ -15,6 +15,8 @@ public:
 	//passes the previous framebuffer with the texture to apply as parameter
 	void ApplyEffect(PostEffect* buffer) override;
 
+	const char* GetName() const override { return "Color Correction (LUT)"; }
+
 	//Getters
 	LUT3D GetLUT() const;
 
@@ -19,6 +19,12 @@ void PostEffect::Init(unsigned width, unsigned height)
 
 }
 
+void PostEffect::Apply(PostEffect* previousBuffer)
+{
+	GPU_PROFILE_SCOPE(GetName());
+	ApplyEffect(previousBuffer);
+}
+
 void PostEffect::ApplyEffect(PostEffect* previousBuffer)
 {
 	BindShader(_shaders.size() - 1);
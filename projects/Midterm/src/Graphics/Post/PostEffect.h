@@ -2,6 +2,7 @@
 
 #include "Graphics/Framebuffer.h"
 #include "Shader.h"
+#include "GpuProfiler.h"
 
 class PostEffect
 {
@@ -9,10 +10,16 @@ public:
 	//Initialize this effects (will be overriden in each derived class)
 	virtual void Init(unsigned width, unsigned height);
 
+	//Applies the effect, timing it's GPU work under the effect's name
+	void Apply(PostEffect* previousBuffer);
+
 	//Applies the effect
 	virtual void ApplyEffect(PostEffect* previousBuffer);
 	virtual void DrawToScreen();
 
+	//The name the effect shows up as in the GPU timings
+	virtual const char* GetName() const { return "Passthrough"; }
+
 	//Reshapes the buffer
 	virtual void Reshape(unsigned width, unsigned height);
 
@@ -11,6 +11,8 @@ public:
 	//Applies effect to this buffer
 	void ApplyEffect(PostEffect* buffer) override;
 
+	const char* GetName() const override { return "Sepia"; }
+
 	//Getters
 	float GetIntensity() const;
 
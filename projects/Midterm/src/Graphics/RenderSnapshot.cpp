@@ -0,0 +1,55 @@
+#include "Graphics/RenderSnapshot.h"
+
+ImGuiSnapshot::~ImGuiSnapshot()
+{
+	for (ImDrawList* list : _lists) {
+		IM_DELETE(list);
+	}
+	_lists.clear();
+	_data.Clear();
+}
+
+void ImGuiSnapshot::Capture(const ImDrawData* data)
+{
+	_data.Clear();
+	if (data == nullptr || !data->Valid) {
+		return;
+	}
+
+	//Grow our lists to match, we only need the buffers the renderer reads
+	while (_lists.size() < (size_t)data->CmdListsCount) {
+		_lists.push_back(IM_NEW(ImDrawList)(data->CmdLists[_lists.size()]->_Data));
+	}
+	for (int ix = 0; ix < data->CmdListsCount; ix++) {
+		const ImDrawList* source = data->CmdLists[ix];
+		ImDrawList* target = _lists[ix];
+		target->CmdBuffer = source->CmdBuffer;
+		target->IdxBuffer = source->IdxBuffer;
+		target->VtxBuffer = source->VtxBuffer;
+		target->Flags = source->Flags;
+	}
+
+	_data.Valid = true;
+	_data.CmdLists = _lists.data();
+	_data.CmdListsCount = data->CmdListsCount;
+	_data.TotalIdxCount = data->TotalIdxCount;
+	_data.TotalVtxCount = data->TotalVtxCount;
+	_data.DisplayPos = data->DisplayPos;
+	_data.DisplaySize = data->DisplaySize;
+	_data.FramebufferScale = data->FramebufferScale;
+}
+
+void RenderSnapshot::Clear()
+{
+	Packets.clear();
+}
+
+void RenderSnapshot::AddPacket(MeshHandle mesh, MaterialHandle material, const glm::mat4& model, const glm::mat3& normalMatrix)
+{
+	const VertexArrayObject* meshPtr = ResourcePool<VertexArrayObject>::Get(mesh);
+	ShaderMaterial* materialPtr = ResourcePool<ShaderMaterial>::Get(material);
+	if (meshPtr == nullptr || materialPtr == nullptr) {
+		return;
+	}
+	Packets.push_back({ meshPtr, materialPtr, model, normalMatrix });
+}
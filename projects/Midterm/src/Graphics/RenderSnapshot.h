@@ -0,0 +1,68 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <GLM/glm.hpp>
+#include <ShaderMaterial.h>
+#include <VertexArrayObject.h>
+#include <RendererComponent.h>
+
+#include "imgui.h"
+
+//Everything needed to draw one renderer, copied out of the scene so the render thread never touches the registry.
+//The mesh and material are owned by their pools, which hold on to them until any frames using them are done
+struct DrawPacket
+{
+	const VertexArrayObject* Mesh;
+	ShaderMaterial* Material;
+	glm::mat4 Model;
+	glm::mat3 NormalMatrix;
+};
+
+//The post processing settings for a frame, these are applied to the effects by the render thread
+struct PostSettings
+{
+	int ActiveEffect = 0;
+	float BloomThreshold = 0.01f;
+	unsigned BloomPasses = 10;
+};
+
+//A copy of ImGui's draw lists for a frame, ImGui re-uses it's own lists as soon as the next frame starts
+class ImGuiSnapshot
+{
+public:
+	ImGuiSnapshot() = default;
+	~ImGuiSnapshot();
+	ImGuiSnapshot(const ImGuiSnapshot& other) = delete;
+	ImGuiSnapshot& operator=(const ImGuiSnapshot& other) = delete;
+
+	//Copies the draw data from ImGui::Render, re-using the lists from the last time this snapshot was filled
+	void Capture(const ImDrawData* data);
+	//Gets the copied draw data, ready for ImGui_ImplOpenGL3_RenderDrawData
+	ImDrawData* GetDrawData() { return &_data; }
+
+private:
+	ImDrawData _data;
+	std::vector<ImDrawList*> _lists;
+};
+
+//Everything the render thread needs to draw a frame. The main thread fills one of these in while the render
+//thread draws the other
+struct RenderSnapshot
+{
+	std::vector<DrawPacket> Packets;
+
+	glm::mat4 View = glm::mat4(1.0f);
+	glm::mat4 Projection = glm::mat4(1.0f);
+
+	PostSettings Post;
+	ImGuiSnapshot Gui;
+	// The frame number from FramePacer::BeginFrame, so the render thread can report when the frame is done
+	uint64_t FrameId = 0;
+	// How long the render thread's time sliced tasks (see BackendHandler::renderTasks) may take this frame, in ms
+	float TaskBudgetMs = 1.0f;
+
+	//Empties out the packets, keeping their memory around for the next frame
+	void Clear();
+	//Adds a renderer to the frame, renderers without a mesh or material are skipped
+	void AddPacket(MeshHandle mesh, MaterialHandle material, const glm::mat4& model, const glm::mat3& normalMatrix);
+};
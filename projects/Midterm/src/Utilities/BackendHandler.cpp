@@ -1,6 +1,11 @@
 #include "BackendHandler.h"
 
 GLFWwindow* BackendHandler::window = nullptr;
+bool BackendHandler::useRenderThread = false;
+TimeSliceScheduler BackendHandler::renderTasks;
+
+//The buffer resizing that's in progress on the render thread, if there is one
+static TaskHandle s_reshapeTask;
 std::vector<std::function<void()>> BackendHandler::imGuiCallbacks;
 
 
@@ -33,6 +38,9 @@ bool BackendHandler::InitAll()
 	Logger::Init();
 	Util::Init();
 
+	//Only hand rendering off to it's own thread if there's another core for it to run on
+	useRenderThread = std::thread::hardware_concurrency() > 1;
+
 	if (!InitGLFW())
 		return 1;
 	if (!InitGLAD())
@@ -45,35 +53,54 @@ bool BackendHandler::InitAll()
 
 void BackendHandler::GlfwWindowResizedCallback(GLFWwindow* window, int width, int height)
 {
-	glViewport(0, 0, width, height);
 	Application::Instance().ActiveScene->Registry().view<Camera>().each([=](Camera& cam) 
 	{
 		cam.ResizeWindow(width, height);
 	});
-	Application::Instance().ActiveScene->Registry().view<Framebuffer>().each([=](Framebuffer& buf)
+
+	//The buffers are only touched by the render thread, so we grab them here and resize them over there
+	std::vector<Framebuffer*> framebuffers;
+	Application::Instance().ActiveScene->Registry().view<Framebuffer>().each([&](Framebuffer& buf)
+	{
+		framebuffers.push_back(&buf);
+	});
+	std::vector<PostEffect*> postEffects;
+	Application::Instance().ActiveScene->Registry().view<PostEffect>().each([&](PostEffect& buf)
 	{
-		buf.Reshape(width, height);
+		postEffects.push_back(&buf);
 	});
-	Application::Instance().ActiveScene->Registry().view<PostEffect>().each([=](PostEffect& buf)
+	Application::Instance().ActiveScene->Registry().view<GreyscaleEffect>().each([&](GreyscaleEffect& buf)
 	{
-		buf.Reshape(width, height);
+		postEffects.push_back(&buf);
 	});
-	Application::Instance().ActiveScene->Registry().view<GreyscaleEffect>().each([=](GreyscaleEffect& buf)
+	Application::Instance().ActiveScene->Registry().view<SepiaEffect>().each([&](SepiaEffect& buf)
 	{
-		buf.Reshape(width, height);
+		postEffects.push_back(&buf);
 	});
-	Application::Instance().ActiveScene->Registry().view<SepiaEffect>().each([=](SepiaEffect& buf)
+	Application::Instance().ActiveScene->Registry().view<ColorCorrectEffect>().each([&](ColorCorrectEffect& buf)
 	{
-		buf.Reshape(width, height);
+		postEffects.push_back(&buf);
 	});
-	Application::Instance().ActiveScene->Registry().view<ColorCorrectEffect>().each([=](ColorCorrectEffect& buf)
+	Application::Instance().ActiveScene->Registry().view<BloomEffect>().each([&](BloomEffect& buf)
 	{
-		buf.Reshape(width, height);
+		postEffects.push_back(&buf);
+	});
+	RenderThread::Enqueue([=]() {
+		glViewport(0, 0, width, height);
+
+		//Re-allocating every buffer at once hitches, so they get resized one at a time over the next few frames.
+		//While the window is being dragged around we get a resize every frame, and only the latest size matters
+		renderTasks.Cancel(s_reshapeTask);
+		s_reshapeTask = renderTasks.Schedule("Reshape Buffers", [=, next = size_t(0)]() mutable {
+			if (next < framebuffers.size()) {
+				framebuffers[next]->Reshape(width, height);
+			} else if (next < framebuffers.size() + postEffects.size()) {
+				postEffects[next - framebuffers.size()]->Reshape(width, height);
+			}
+			next++;
+			return next < framebuffers.size() + postEffects.size() ? TaskStep::Continue : TaskStep::Done;
+		}, TaskPriority::High, 0.1f);
 	});
-	Application::Instance().ActiveScene->Registry().view<BloomEffect>().each([=](BloomEffect& buf)
-		{
-			buf.Reshape(width, height);
-		});
 }
 
 bool BackendHandler::InitGLFW()
@@ -97,6 +124,9 @@ bool BackendHandler::InitGLFW()
 	// Store the window in the application singleton
 	Application::Instance().Window = window;
 
+	// Hook up our input callbacks, this needs to happen before ImGui installs it's callbacks so that it chains to ours
+	InputSystem::Init(window);
+
 	return true;
 }
 
@@ -106,6 +136,8 @@ bool BackendHandler::InitGLAD()
 		LOG_ERROR("Failed to initialize Glad");
 		return false;
 	}
+	// Wraps glad's function pointers if the GL tracer is compiled in
+	GL_TRACE_INSTALL();
 	return true;
 }
 
@@ -119,8 +151,11 @@ void BackendHandler::InitImGui()
 	io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
 	// Allow docking to our window
 	io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
-	// Allow multiple viewports (so we can drag ImGui off our window)
-	io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;
+	// Allow multiple viewports (so we can drag ImGui off our window), the extra windows have to be made and
+	// drawn on the main thread, so this is only available without the render thread
+	if (!useRenderThread) {
+		io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;
+	}
 	// Allow our viewports to use transparent backbuffers
 	io.ConfigFlags |= ImGuiConfigFlags_TransparentBackbuffers;
 
@@ -138,6 +173,9 @@ void BackendHandler::InitImGui()
 		style.WindowRounding = 0.0f;
 		style.Colors[ImGuiCol_WindowBg].w = 0.8f;
 	}
+
+	// Create the font texture and shaders now, while the context is still current on the main thread
+	ImGui_ImplOpenGL3_NewFrame();
 }
 
 void BackendHandler::ShutdownImGui()
@@ -149,10 +187,9 @@ void BackendHandler::ShutdownImGui()
 	ImGui::DestroyContext();
 }
 
-void BackendHandler::RenderImGui()
+void BackendHandler::BuildImGui()
 {
-	// Implementation new frame
-	ImGui_ImplOpenGL3_NewFrame();
+	// Implementation new frame, the OpenGL side was set up in InitImGui
 	ImGui_ImplGlfw_NewFrame();
 	// ImGui context new frame
 	ImGui::NewFrame();
@@ -171,9 +208,17 @@ void BackendHandler::RenderImGui()
 	glfwGetWindowSize(window, &width, &height);
 	io.DisplaySize = ImVec2((float)width, (float)height);
 
-	// Render all of our ImGui elements
+	// Finish building the draw lists
 	ImGui::Render();
-	ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+}
+
+void BackendHandler::DrawImGui(ImDrawData* drawData)
+{
+	// Render all of our ImGui elements
+	GL_TRACE_SCOPE("ImGui");
+	ImGui_ImplOpenGL3_RenderDrawData(drawData);
+
+	ImGuiIO& io = ImGui::GetIO();
 
 	// If we have multiple viewports enabled (can drag into a new window)
 	if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable) {
@@ -187,19 +232,54 @@ void BackendHandler::RenderImGui()
 
 void BackendHandler::RenderVAO(const Shader::sptr& shader, const VertexArrayObject::sptr& vao, const glm::mat4& viewProjection, const Transform& transform)
 {
-	shader->SetUniformMatrix("u_ModelViewProjection", viewProjection * transform.WorldTransform());
-	shader->SetUniformMatrix("u_Model", transform.WorldTransform());
-	shader->SetUniformMatrix("u_NormalMatrix", transform.WorldNormalMatrix());
-	vao->Render();
+	RenderVAO(*shader, *vao, viewProjection, transform.RenderTransform(), transform.RenderNormalMatrix());
+}
+
+void BackendHandler::RenderVAO(Shader& shader, const VertexArrayObject& vao, const glm::mat4& viewProjection, const glm::mat4& model, const glm::mat3& normalMatrix)
+{
+	shader.SetUniformMatrix("u_ModelViewProjection", viewProjection * model);
+	shader.SetUniformMatrix("u_Model", model);
+	shader.SetUniformMatrix("u_NormalMatrix", normalMatrix);
+	vao.Render();
 }
 
-void BackendHandler::SetupShaderForFrame(const Shader::sptr& shader, const glm::mat4& view, const glm::mat4& projection)
+void BackendHandler::SetupShaderForFrame(Shader& shader, const glm::mat4& view, const glm::mat4& projection)
 {
-	shader->Bind();
+	shader.Bind();
 	// These are the uniforms that update only once per frame
-	shader->SetUniformMatrix("u_View", view);
-	shader->SetUniformMatrix("u_ViewProjection", projection * view);
-	shader->SetUniformMatrix("u_SkyboxMatrix", projection * glm::mat4(glm::mat3(view)));
+	shader.SetUniformMatrix("u_View", view);
+	shader.SetUniformMatrix("u_ViewProjection", projection * view);
+	shader.SetUniformMatrix("u_SkyboxMatrix", projection * glm::mat4(glm::mat3(view)));
 	glm::vec3 camPos = glm::inverse(view) * glm::vec4(0, 0, 0, 1);
-	shader->SetUniform("u_CamPos", camPos);
+	shader.SetUniform("u_CamPos", camPos);
+}
+
+void BackendHandler::RenderGpuTimings()
+{
+	// The results are written by the render thread, so we take a copy
+	const std::vector<GpuProfiler::RegionStats> results = GpuProfiler::CopyResults();
+	// The number of tree nodes we currently have pushed, children of collapsed nodes get skipped
+	int openDepth = 0;
+	for (size_t ix = 0; ix < results.size(); ix++) {
+		const GpuProfiler::RegionStats& region = results[ix];
+		if (region.Depth > openDepth) {
+			continue;
+		}
+		while (openDepth > region.Depth) {
+			ImGui::TreePop();
+			openDepth--;
+		}
+
+		bool hasChildren = ix + 1 < results.size() && results[ix + 1].Depth > region.Depth;
+		ImGuiTreeNodeFlags flags = hasChildren ? ImGuiTreeNodeFlags_DefaultOpen : (ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen);
+		bool isOpen = ImGui::TreeNodeEx(region.Path.c_str(), flags, "%s: %.3f ms (avg %.3f ms)", region.Name.c_str(), region.LastMs, region.AverageMs);
+		if (hasChildren && isOpen) {
+			openDepth++;
+		}
+	}
+	while (openDepth > 0) {
+		ImGui::TreePop();
+		openDepth--;
+	}
+	ImGui::Text("Dropped samples: %llu", static_cast<unsigned long long>(GpuProfiler::GetDroppedSamples()));
 }
@@ -9,6 +9,7 @@
 #include "Graphics/Post/BloomEffect.h"
 
 #include <iostream>
+#include <thread>
 #include <Logging.h>
 
 #include <glad/glad.h>
@@ -17,10 +18,15 @@
 #include <Transform.h>
 #include <VertexArrayObject.h>
 #include <Shader.h>
+#include <GLTrace.h>
+#include <GpuProfiler.h>
+#include <RenderThread.h>
 
 #include <Application.h>
+#include <InputSystem.h>
 #include <Camera.h>
 #include <Scene.h>
+#include <TimeSliceScheduler.h>
 
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
@@ -57,12 +63,22 @@ public:
 	//ImGui Init Functions
 	static void InitImGui();
 	static void ShutdownImGui();
-	static void RenderImGui();
+	//Builds the ImGui draw lists for the frame (main thread)
+	static void BuildImGui();
+	//Draws a frame's ImGui draw lists (on the thread that owns the context)
+	static void DrawImGui(ImDrawData* drawData);
+	//Draws the GPU profiler results as a tree
+	static void RenderGpuTimings();
 
 	//Render our VAO
 	static void RenderVAO(const Shader::sptr& shader, const VertexArrayObject::sptr& vao, const glm::mat4& viewProjection, const Transform& transform);
-	static void SetupShaderForFrame(const Shader::sptr& shader, const glm::mat4& view, const glm::mat4& projection);
+	static void RenderVAO(Shader& shader, const VertexArrayObject& vao, const glm::mat4& viewProjection, const glm::mat4& model, const glm::mat3& normalMatrix);
+	static void SetupShaderForFrame(Shader& shader, const glm::mat4& view, const glm::mat4& projection);
 
 	static GLFWwindow* window;
+	//Whether GL work is handed off to the render thread (see RenderThread), decided in InitAll
+	static bool useRenderThread;
+	//Spreads expensive GL work (like resizing buffers) over frames, only touched by the thread that owns the context
+	static TimeSliceScheduler renderTasks;
 	static std::vector<std::function<void()>> imGuiCallbacks;
 };
\ No newline at end of file
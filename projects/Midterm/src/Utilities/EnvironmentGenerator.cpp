@@ -16,6 +16,8 @@ std::vector<std::vector<glm::vec2>> EnvironmentGenerator::_avoidToAll;
 //The filenames of the objects to spawn
 std::vector<std::string> EnvironmentGenerator::_objectsToSpawn;
 
+TaskHandle EnvironmentGenerator::_regenerationTask;
+
 ////Not implemented//
 //std::vector<char> EnvironmentGenerator::_letterRepresentation;
 //std::vector<std::vector<char>> EnvironmentGenerator::_generatedMapPlacements;
@@ -28,45 +30,94 @@ void EnvironmentGenerator::RegenerateEnvironment()
 	GenerateEnvironment();
 }
 
+TaskHandle EnvironmentGenerator::ScheduleRegeneration(TimeSliceScheduler& scheduler, int objectsPerStep)
+{
+	//Only one regeneration at a time, anything the old one spawned gets cleaned up below
+	scheduler.Cancel(_regenerationTask);
+
+	//Removing is cheap since the entities are destroyed together at the end of the frame, so we do it right away
+	CleanEnvironment();
+
+	_regenerationTask = scheduler.Schedule("Regenerate Environment", [objectsPerStep, object = 0, placed = 0]() mutable {
+		if (object >= _objectsToSpawn.size())
+		{
+			return TaskStep::Done;
+		}
+
+		//Each object gets it's own list, which is filled in over a few steps
+		if (placed == 0)
+		{
+			_objectsSpawned.emplace_back();
+		}
+		const int count = std::min(objectsPerStep, _numToSpawn[object] - placed);
+		_SpawnObjects(object, count, _objectsSpawned.back());
+		placed += count;
+
+		//Move on to the next object once this one is all placed
+		if (placed >= _numToSpawn[object])
+		{
+			object++;
+			placed = 0;
+		}
+		return object < _objectsToSpawn.size() ? TaskStep::Continue : TaskStep::Done;
+	});
+	return _regenerationTask;
+}
+
 void EnvironmentGenerator::GenerateEnvironment()
 {
 	for (int i = 0; i < _objectsToSpawn.size(); i++)
 	{
 		std::vector<GameObject> temp;
-		{
-			//Load in this object vao
-			if (!_loadedIn[i])
-			{
-				VertexArrayObject::sptr vao = ObjLoader::LoadFromFile(_objectsToSpawn[i]);
-				_vaosToSpawn.push_back(vao);
-				_loadedIn[i] = true;
-			}
-
-			for (int j = 0; j < _numToSpawn[i]; j++)
-			{
-				temp.push_back(Application::Instance().ActiveScene->CreateEntity(_objectsToSpawn[i] + (std::to_string(j + 1))));
-				temp[j].emplace<RendererComponent>().SetMesh(_vaosToSpawn[i]).SetMaterial(_materialsForSpawning[i]);
-				//Randomly places
-				temp[j].get<Transform>().SetLocalPosition(glm::vec3(Util::GetRandomNumberBetween(_spawnFromAll[i],
-					_spawnToAll[i], _avoidFromAll[i], _avoidToAll[i]), 0.0f));
-				temp[j].get<Transform>().SetLocalRotation(Util::GetRandomNumberBetween(glm::vec3(0.f, 0.f, 0.f), glm::vec3(0.f, 0.f, 360.0f)));
-			}
-		}
+		_SpawnObjects(i, _numToSpawn[i], temp);
 
 		//Add object to the spawned list
 		_objectsSpawned.push_back(temp);
 	}
 }
 
+void EnvironmentGenerator::_SpawnObjects(int object, int count, std::vector<GameObject>& spawned)
+{
+	//Load in this object vao
+	if (!_loadedIn[object])
+	{
+		VertexArrayObject::sptr vao = AssetLibrary<VertexArrayObject>::Load(_objectsToSpawn[object]);
+		_vaosToSpawn.push_back(vao);
+		_loadedIn[object] = true;
+	}
+
+	//Make a prefab for this object, all the copies get stamped from it in one go
+	//It has no tag, since each copy gets it's own numbered name below
+	entt::registry& prefabs = GameScene::Prefabs();
+	entt::entity prefab = prefabs.create();
+	prefabs.emplace<RendererComponent>(prefab).SetMesh(_vaosToSpawn[object]).SetMaterial(_materialsForSpawning[object]);
+
+	//Randomly places
+	std::vector<InstanceTransform> transforms(count);
+	for (int j = 0; j < count; j++)
+	{
+		transforms[j].Position = glm::vec3(Util::GetRandomNumberBetween(_spawnFromAll[object],
+			_spawnToAll[object], _avoidFromAll[object], _avoidToAll[object]), 0.0f);
+		transforms[j].Rotation = glm::quat(glm::radians(Util::GetRandomNumberBetween(glm::vec3(0.f, 0.f, 0.f), glm::vec3(0.f, 0.f, 360.0f))));
+	}
+
+	//Name the copies tree1, tree2, etc. carrying on from any copies spawned in earlier batches
+	GameScene::sptr& scene = Application::Instance().ActiveScene;
+	for (entt::entity entity : scene->StampMany(prefab, transforms.size(), transforms.data()))
+	{
+		spawned.push_back(GameObject(scene->Registry(), entity));
+		scene->SetName(spawned.back(), _objectsToSpawn[object] + std::to_string(spawned.size()));
+	}
+	prefabs.destroy(prefab);
+}
+
 void EnvironmentGenerator::CleanEnvironment()
 {
 	//Remove all the entities
 	for (int i = 0; i < _objectsSpawned.size(); i++)
 	{
-		for (int j = 0; j < _objectsSpawned[i].size(); j++)
-		{
-			Application::Instance().ActiveScene->RemoveEntity(_objectsSpawned[i][j]);
-		}
+		//These are destroyed together at the end of the frame
+		Application::Instance().ActiveScene->RemoveEntities(_objectsSpawned[i].begin(), _objectsSpawned[i].end());
 	}
 
 	//Clear out objects spawned
@@ -94,7 +145,7 @@ void EnvironmentGenerator::AddObjectToGeneration(std::string fileName, ShaderMat
 	}
 
 	//Loads in the mesh and adds to list
-	VertexArrayObject::sptr vao = ObjLoader::LoadFromFile(fileName);
+	VertexArrayObject::sptr vao = AssetLibrary<VertexArrayObject>::Load(fileName);
 	_vaosToSpawn.push_back(vao);
 	//Adds material to list
 	_materialsForSpawning.push_back(objMat);
@@ -1,9 +1,12 @@
 #pragma once
 #include <Scene.h>
+#include <GameObjectTag.h>
 #include <Application.h>
+#include <AssetLibrary.h>
 #include <ObjLoader.h>
 #include <RendererComponent.h>
 #include <Transform.h>
+#include <TimeSliceScheduler.h>
 #include <vector>
 
 #include "Utilities/Util.h"
@@ -14,6 +17,9 @@ public:
 	
 	//Regenerates environment with your settings
 	static void RegenerateEnvironment();
+	//Regenerates environment with your settings a few objects at a time, so it doesn't hitch the frame it was asked for on.
+	//Starting a new regeneration cancels any that is still in progress
+	static TaskHandle ScheduleRegeneration(TimeSliceScheduler& scheduler, int objectsPerStep = 256);
 	//Generates an environment with your settings
 	static void GenerateEnvironment();
 	//Cleans up the environment using your settings
@@ -30,6 +36,12 @@ public:
 
 	static std::vector<std::string> GetObjectsOnList();
 private:
+	//Spawns a number of copies of an object on the list, adding them to spawned
+	static void _SpawnObjects(int object, int count, std::vector<GameObject>& spawned);
+
+	//The regeneration that's in progress, if there is one
+	static TaskHandle _regenerationTask;
+
 	//The gameobjects spawned here
 	static std::vector<std::vector<GameObject>> _objectsSpawned;
 
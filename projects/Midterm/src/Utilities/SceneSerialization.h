@@ -0,0 +1,59 @@
+#pragma once
+#include <AssetLibrary.h>
+#include <Camera.h>
+#include <CerealGLM.h>
+#include <RendererComponent.h>
+#include <cereal/types/string.hpp>
+
+// Serialization for the GraphicsModule components, so they can be saved with scenes (see SceneSerializer). These
+// live here since the graphics module can't see the asset libraries
+
+// Renderers are saved as the paths of their mesh and material, which are looked up in the asset libraries on load
+template <typename Archive>
+void save(Archive& archive, const RendererComponent& renderer) {
+	archive(
+		cereal::make_nvp("Mesh", AssetLibrary<VertexArrayObject>::GetPath(ResourcePool<VertexArrayObject>::GetShared(renderer.Mesh))),
+		cereal::make_nvp("Material", AssetLibrary<ShaderMaterial>::GetPath(ResourcePool<ShaderMaterial>::GetShared(renderer.Material)))
+	);
+}
+
+template <typename Archive>
+void load(Archive& archive, RendererComponent& renderer) {
+	std::string mesh, material;
+	archive(cereal::make_nvp("Mesh", mesh), cereal::make_nvp("Material", material));
+	renderer.SetMesh(mesh.empty() ? nullptr : AssetLibrary<VertexArrayObject>::Load(mesh));
+	renderer.SetMaterial(material.empty() ? nullptr : AssetLibrary<ShaderMaterial>::Load(material));
+}
+
+template <typename Archive>
+void save(Archive& archive, const Camera& camera) {
+	archive(
+		cereal::make_nvp("IsOrtho", camera.GetIsOrtho()),
+		cereal::make_nvp("OrthoHeight", camera.GetOrthoHeight()),
+		cereal::make_nvp("FovDegrees", camera.GetFovDegrees()),
+		cereal::make_nvp("Position", camera.GetPosition()),
+		cereal::make_nvp("Forward", camera.GetForward()),
+		cereal::make_nvp("Up", camera.GetUp())
+	);
+}
+
+template <typename Archive>
+void load(Archive& archive, Camera& camera) {
+	bool isOrtho;
+	float orthoHeight, fovDegrees;
+	glm::vec3 position, forward, up;
+	archive(
+		cereal::make_nvp("IsOrtho", isOrtho),
+		cereal::make_nvp("OrthoHeight", orthoHeight),
+		cereal::make_nvp("FovDegrees", fovDegrees),
+		cereal::make_nvp("Position", position),
+		cereal::make_nvp("Forward", forward),
+		cereal::make_nvp("Up", up)
+	);
+	camera.SetIsOrtho(isOrtho);
+	camera.SetOrthoHeight(orthoHeight);
+	camera.SetFovDegrees(fovDegrees);
+	camera.SetPosition(position);
+	camera.SetForward(forward);
+	camera.SetUp(up);
+}
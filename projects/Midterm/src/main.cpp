@@ -1,5 +1,7 @@
 //Just a simple handler for simple initialization stuffs
 #include "Utilities/BackendHandler.h"
+#include "Utilities/SceneSerialization.h"
+#include "Graphics/RenderSnapshot.h"
 
 #include <filesystem>
 #include <json.hpp>
@@ -16,16 +18,34 @@
 #include <RendererComponent.h>
 #include <TextureCubeMap.h>
 #include <TextureCubeMapData.h>
+#include <GpuDeletionQueue.h>
+#include <RenderThread.h>
+#include <JobSystem.h>
+#include <FramePacer.h>
 
 #include <Timing.h>
 #include <GameObjectTag.h>
 #include <InputHelpers.h>
 
 #include <IBehaviour.h>
+#include <AssetLibrary.h>
+#include <SceneSerializer.h>
+#include <WorldStreamer.h>
+#include <SystemScheduler.h>
+#include <TimeSliceScheduler.h>
+#include <EventBus.h>
 #include <CameraControlBehaviour.h>
 #include <FollowPathBehaviour.h>
 #include <SimpleMoveBehaviour.h>
 
+//Compile-time features for the blinn-phong shader, bit order matches the defines passed to SetPermutationDefines
+enum LightingFeature : uint32_t {
+	LightingNone         = 1 << 0,
+	LightingAmbientOnly  = 1 << 1,
+	LightingSpecularOnly = 1 << 2,
+	RimLighting          = 1 << 3
+};
+
 int main() {
 	int frameIx = 0;
 	float fpsBuffer[128];
@@ -56,6 +76,7 @@ int main() {
 		shader->LoadShaderPartFromFile("shaders/vertex_shader.glsl", GL_VERTEX_SHADER);
 		shader->LoadShaderPartFromFile("shaders/frag_blinn_phong_textured2.glsl", GL_FRAGMENT_SHADER);
 		shader->Link();
+		shader->SetPermutationDefines({ "LIGHTING_NONE", "LIGHTING_AMBIENT_ONLY", "LIGHTING_SPECULAR_ONLY", "RIM_LIGHTING" });
 		//
 		glm::vec3 lightPos = glm::vec3(0.0f, 0.0f, 10.0f);
 		glm::vec3 lightCol = glm::vec3(0.9f, 0.85f, 0.5f);
@@ -69,19 +90,20 @@ int main() {
 		
 		// These are our application / scene level uniforms that don't necessarily update
 		// every frame
-		shader->SetUniform("u_LightPos", lightPos);
-		shader->SetUniform("u_LightCol", lightCol);
-		shader->SetUniform("u_AmbientLightStrength", lightAmbientPow);
-		shader->SetUniform("u_SpecularLightStrength", lightSpecularPow);
-		shader->SetUniform("u_AmbientCol", ambientCol);
-		shader->SetUniform("u_AmbientStrength", ambientPow);
-		shader->SetUniform("u_LightAttenuationConstant", 1.0f);
-		shader->SetUniform("u_LightAttenuationLinear", lightLinearFalloff);
-		shader->SetUniform("u_LightAttenuationQuadratic", lightQuadraticFalloff);
+		shader->SetSharedUniform("u_LightPos", lightPos);
+		shader->SetSharedUniform("u_LightCol", lightCol);
+		shader->SetSharedUniform("u_AmbientLightStrength", lightAmbientPow);
+		shader->SetSharedUniform("u_SpecularLightStrength", lightSpecularPow);
+		shader->SetSharedUniform("u_AmbientCol", ambientCol);
+		shader->SetSharedUniform("u_AmbientStrength", ambientPow);
+		shader->SetSharedUniform("u_LightAttenuationConstant", 1.0f);
+		shader->SetSharedUniform("u_LightAttenuationLinear", lightLinearFalloff);
+		shader->SetSharedUniform("u_LightAttenuationQuadratic", lightQuadraticFalloff);
 
 		PostEffect* basicEffect;
 
-		int activeEffect = 0;
+		// The post processing settings, these are copied into each frame's snapshot and applied on the render thread
+		PostSettings postSettings;
 		std::vector<PostEffect*> effects;
 
 		GreyscaleEffect* greyscaleEffect;
@@ -92,6 +114,26 @@ int main() {
 		int rim = 0;
 
 		std::vector<ShaderMaterial::sptr> mats;
+
+		//Selects the shader permutation matching the current lighting mode and rim toggle for all our materials
+		auto applyShaderVariant = [&]() {
+			uint32_t features = 0;
+			switch (mode) {
+				case 1: features |= LightingNone; break;
+				case 2: features |= LightingAmbientOnly; break;
+				case 3: features |= LightingSpecularOnly; break;
+				default: break;
+			}
+			if (rim) {
+				features |= RimLighting;
+			}
+			//Switching variants can compile shaders, so it has to happen on the render thread
+			RenderThread::Enqueue([features, mats]() {
+				for (auto& mat : mats) {
+					mat->SetVariant(features);
+				}
+			});
+		};
 #pragma region TEXTURE LOADING
 
 		// Load some textures from files
@@ -129,71 +171,85 @@ int main() {
 		int width, height;
 		glfwGetWindowSize(BackendHandler::window, &width, &height);
 
+		// Runs the per-frame systems, the systems themselves are added once the scene is set up
+		SystemScheduler systems;
+		// Spreads expensive main thread work (like regenerating the environment) over a few frames
+		TimeSliceScheduler tasks;
+		float taskBudgetMs = 2.0f;
+		float renderTaskBudgetMs = 1.0f;
+		// Tallies of the engine events we listen for on the event bus
+		uint64_t destroyedEntities = 0;
+		uint64_t loadedCells = 0;
+		uint64_t failedCells = 0;
+		uint64_t loadedCellBytes = 0;
+		// The last input stream that was recorded or loaded, for replaying
+		InputRecording inputRecording;
+		std::string sceneRoundTrip;
+		// Streams a generated world in and out around the camera, once one has been generated
+		WorldStreamer::uptr worldStreamer;
+		int streamedProps = 20000;
+
 		// We'll add some ImGui controls to control our shader
 		BackendHandler::imGuiCallbacks.push_back([&]() {
 			if (ImGui::Button("No Lighting")) {
 				mode = 1;
-				shader->SetUniform("u_Mode", mode);
-				activeEffect = 0;
+				applyShaderVariant();
+				postSettings.ActiveEffect = 0;
 			}
 			if (ImGui::Button("Ambient Only")) {
 				mode = 2;
-				shader->SetUniform("u_Mode", mode);
-				activeEffect = 0;
+				applyShaderVariant();
+				postSettings.ActiveEffect = 0;
 			}
 			if (ImGui::Button("Specular Only")) {
 				mode = 3;
-				shader->SetUniform("u_Mode", mode);
-				activeEffect = 0;
+				applyShaderVariant();
+				postSettings.ActiveEffect = 0;
 			}//
 			if (ImGui::Button("Ambient + Specular")) {
 				mode = 0;
-				shader->SetUniform("u_Mode", mode);
-				activeEffect = 0;
+				applyShaderVariant();
+				postSettings.ActiveEffect = 0;
 			}
 			if (ImGui::Button("Ambient + Specular + Bloom")) {
 				mode = 7;
-				shader->SetUniform("u_Mode", mode);
-				activeEffect = 1;
+				applyShaderVariant();
+				postSettings.ActiveEffect = 1;
 			}
 			if (ImGui::CollapsingHeader("Effect controls")) {
-				BloomEffect* temp = (BloomEffect*)effects[activeEffect];
-				float threshold = temp->GetThreshold();
-				int pass = temp->GetPasses();
-								
-				if (ImGui::SliderFloat("Brightness Threshold", &threshold, 0.0f, 1.0f))
-				{//
-					temp->SetThreshold(threshold);
-				}
-				
+				ImGui::SliderFloat("Brightness Threshold", &postSettings.BloomThreshold, 0.0f, 1.0f);
+
+				int pass = static_cast<int>(postSettings.BloomPasses);
 				if (ImGui::SliderInt("Blur", &pass, 0, 10))
 				{
-					temp->SetPasses(pass);
+					postSettings.BloomPasses = static_cast<unsigned>(pass);
 				}
 			}
 		
 			if (ImGui::Button("Toggle Texture")) {
-				if (texOn)
-				{
-					texOn = false;
-					for (int i = 0; i < mats.size(); i++) {
-						mats[i]->Set("s_Diffuse", texture2);
+				texOn = !texOn;
+				//The materials are read by the render thread while it draws, so they get changed over there
+				RenderThread::Enqueue([=]() {
+					if (!texOn)
+					{
+						for (int i = 0; i < mats.size(); i++) {
+							mats[i]->Set("s_Diffuse", texture2);
+						}
+						mats[5]->Set("s_Diffuse2", texture2);
 					}
-					mats[5]->Set("s_Diffuse2", texture2);
-				}
-				else {
-					texOn = true;
-					mats[0]->Set("s_Diffuse", stone);
-					mats[1]->Set("s_Diffuse", grass);
-					mats[2]->Set("s_Diffuse", box);
-					mats[3]->Set("s_Diffuse", simpleFlora);
-					mats[4]->Set("s_Diffuse", shrineCol);
-					mats[5]->Set("s_Diffuse", crystalNor);
-					mats[6]->Set("s_Diffuse", crystalNor);
+					else {
+						mats[0]->Set("s_Diffuse", stone);
+						mats[1]->Set("s_Diffuse", grass);
+						mats[2]->Set("s_Diffuse", box);
+						mats[3]->Set("s_Diffuse", simpleFlora);
+						mats[4]->Set("s_Diffuse", shrineCol);
+						mats[5]->Set("s_Diffuse", crystalNor);
+						mats[6]->Set("s_Diffuse", crystalNor);
 
-					mats[5]->Set("s_Diffuse2", crystalGlow);
+						mats[5]->Set("s_Diffuse2", crystalGlow);
 
-				}
+					}
+				});
 				
 			}
 			if (ImGui::Button("Toggle Rim Lighting")) {
@@ -204,47 +260,60 @@ int main() {
 				else {
 					rim = 1;
 				}
-				shader->SetUniform("u_rim", rim);
+				applyShaderVariant();
 
 			}
-			/*if (ImGui::CollapsingHeader("Environment generation"))
+			if (ImGui::CollapsingHeader("Environment generation"))
 			{
 				if (ImGui::Button("Regenerate Environment", ImVec2(200.0f, 40.0f)))
 				{
-					EnvironmentGenerator::RegenerateEnvironment();
+					EnvironmentGenerator::ScheduleRegeneration(tasks);
 				}
-			}*/
+			}
+			// Uniform changes are queued up so they land between frames on the render thread
 			if (ImGui::CollapsingHeader("Scene Level Lighting Settings"))
 			{
 				if (ImGui::ColorPicker3("Ambient Color", glm::value_ptr(ambientCol))) {
-					shader->SetUniform("u_AmbientCol", ambientCol);
+					RenderThread::Enqueue([=]() { shader->SetSharedUniform("u_AmbientCol", ambientCol); });
 				}
 				if (ImGui::SliderFloat("Fixed Ambient Power", &ambientPow, 0.01f, 1.0f)) {
-					shader->SetUniform("u_AmbientStrength", ambientPow);
+					RenderThread::Enqueue([=]() { shader->SetSharedUniform("u_AmbientStrength", ambientPow); });
 				}
 			}
 			if (ImGui::CollapsingHeader("Light Level Lighting Settings"))
 			{
 				if (ImGui::DragFloat3("Light Pos", glm::value_ptr(lightPos), 0.01f, -10.0f, 10.0f)) {
-					shader->SetUniform("u_LightPos", lightPos);
+					RenderThread::Enqueue([=]() { shader->SetSharedUniform("u_LightPos", lightPos); });
 				}
 				if (ImGui::ColorPicker3("Light Col", glm::value_ptr(lightCol))) {
-					shader->SetUniform("u_LightCol", lightCol);
+					RenderThread::Enqueue([=]() { shader->SetSharedUniform("u_LightCol", lightCol); });
 				}
 				if (ImGui::SliderFloat("Light Ambient Power", &lightAmbientPow, 0.0f, 1.0f)) {
-					shader->SetUniform("u_AmbientLightStrength", lightAmbientPow);
+					RenderThread::Enqueue([=]() { shader->SetSharedUniform("u_AmbientLightStrength", lightAmbientPow); });
 				}
 				if (ImGui::SliderFloat("Light Specular Power", &lightSpecularPow, 0.0f, 1.0f)) {
-					shader->SetUniform("u_SpecularLightStrength", lightSpecularPow);
+					RenderThread::Enqueue([=]() { shader->SetSharedUniform("u_SpecularLightStrength", lightSpecularPow); });
 				}
 				if (ImGui::DragFloat("Light Linear Falloff", &lightLinearFalloff, 0.01f, 0.0f, 1.0f)) {
-					shader->SetUniform("u_LightAttenuationLinear", lightLinearFalloff);
+					RenderThread::Enqueue([=]() { shader->SetSharedUniform("u_LightAttenuationLinear", lightLinearFalloff); });
 				}
 				if (ImGui::DragFloat("Light Quadratic Falloff", &lightQuadraticFalloff, 0.01f, 0.0f, 1.0f)) {
-					shader->SetUniform("u_LightAttenuationQuadratic", lightQuadraticFalloff);
+					RenderThread::Enqueue([=]() { shader->SetSharedUniform("u_LightAttenuationQuadratic", lightQuadraticFalloff); });
 				}
 			}
 
+#ifdef GL_TRACE_ENABLED
+			if (ImGui::CollapsingHeader("GL Trace")) {
+				ImGui::Text("Calls last frame: %u", GLTrace::GetLastFrameCallCount());
+				ImGui::Text("Queries in frame: %u", GLTrace::GetLastFrameStallCount(GLTraceStall_Query));
+				ImGui::Text("State save/restore: %u", GLTrace::GetLastFrameStallCount(GLTraceStall_StateSave));
+				ImGui::Text("Read after write: %u", GLTrace::GetLastFrameStallCount(GLTraceStall_ReadAfterWrite));
+				ImGui::Text("Redundant binds: %u", GLTrace::GetLastFrameStallCount(GLTraceStall_RedundantBind));
+				if (ImGui::Button("Dump GL Trace")) {
+					RenderThread::Enqueue([]() { GL_TRACE_DUMP("gl_trace.txt"); });
+				}
+			}
+#endif
 			ImGui::Text("Q/E -> Yaw\nLeft/Right -> Roll\nUp/Down -> Pitch\nY -> Toggle Mode");
 		
 			minFps = FLT_MAX;
@@ -257,6 +326,186 @@ int main() {
 			}
 			ImGui::PlotLines("FPS", fpsBuffer, 128);
 			ImGui::Text("MIN: %f MAX: %f AVG: %f", minFps, maxFps, avgFps / 128.0f);
+
+			if (ImGui::CollapsingHeader("GPU Timings")) {
+				BackendHandler::RenderGpuTimings();
+			}
+
+			if (ImGui::CollapsingHeader("Frame Pacing")) {
+				FramePacer::Settings pacing = FramePacer::GetSettings();
+				bool changed = ImGui::SliderFloat("Target FPS (0 = unlimited)", &pacing.TargetFps, 0.0f, 240.0f);
+				int inFlight = static_cast<int>(pacing.MaxFramesInFlight);
+				if (ImGui::SliderInt("Max Frames In Flight", &inFlight, 0, 4)) {
+					pacing.MaxFramesInFlight = static_cast<uint32_t>(inFlight);
+					changed = true;
+				}
+				changed |= ImGui::Checkbox("Throttle When Idle", &pacing.ThrottleWhenIdle);
+				changed |= ImGui::SliderFloat("Idle FPS", &pacing.IdleFps, 1.0f, 30.0f);
+				changed |= ImGui::SliderFloat("Spin (ms)", &pacing.SpinMs, 0.0f, 4.0f);
+				if (changed) {
+					FramePacer::SetSettings(pacing);
+				}
+
+				const FramePacer::Stats pacingStats = FramePacer::GetStats();
+				ImGui::Text("Frame: %.2f ms  Paced: %.2f ms  GPU wait: %.2f ms%s", pacingStats.FrameMs, pacingStats.PacingWaitMs,
+					pacingStats.GpuWaitMs, pacingStats.IsIdle ? "  [idle]" : "");
+				ImGui::Text("Input to submit: %.2f ms  Input to present: %.2f ms  In flight: %u", pacingStats.InputToSubmitMs,
+					pacingStats.InputToPresentMs, pacingStats.FramesInFlight);
+			}
+
+			if (ImGui::CollapsingHeader("Time Sliced Tasks")) {
+				ImGui::SliderFloat("Main Budget (ms)", &taskBudgetMs, 0.1f, 8.0f);
+				ImGui::SliderFloat("Render Budget (ms)", &renderTaskBudgetMs, 0.1f, 8.0f);
+				const TimeSliceScheduler::Stats& taskStats = tasks.GetStats();
+				ImGui::Text("Used: %.2f ms  Steps: %u  Completed: %u", taskStats.UsedMs, taskStats.Steps, taskStats.Completed);
+				ImGui::Text("Pending: %u  Overdue: %u", taskStats.Pending, taskStats.Overdue);
+			}
+
+			if (ImGui::CollapsingHeader("Events")) {
+				const EventBus::Stats eventStats = EventBus::GetStats();
+				ImGui::Text("Published: %llu  Delivered: %llu  Overflowed: %llu  Types: %u", (unsigned long long)eventStats.Published,
+					(unsigned long long)eventStats.Delivered, (unsigned long long)eventStats.Overflowed, eventStats.Channels);
+				ImGui::Text("Entities destroyed: %llu", (unsigned long long)destroyedEntities);
+				ImGui::Text("Cells loaded: %llu (%.1f MB)  Failed: %llu", (unsigned long long)loadedCells,
+					loadedCellBytes / (1024.0 * 1024.0), (unsigned long long)failedCells);
+			}
+
+			if (ImGui::CollapsingHeader("Input")) {
+				if (InputSystem::IsRecording()) {
+					if (ImGui::Button("Stop Recording")) {
+						inputRecording = InputSystem::StopRecording();
+						inputRecording.SaveToFile("input.rec");
+					}
+				} else if (InputSystem::IsReplaying()) {
+					if (ImGui::Button("Stop Replay")) {
+						InputSystem::StopReplay();
+					}
+				} else {
+					if (ImGui::Button("Record")) {
+						InputSystem::StartRecording();
+					}
+					ImGui::SameLine();
+					if (ImGui::Button("Replay") && (!inputRecording.Frames.empty() || InputRecording::LoadFromFile("input.rec", inputRecording))) {
+						InputSystem::StartReplay(inputRecording);
+					}
+				}
+				ImGui::Text("Recorded frames: %u", (uint32_t)inputRecording.Frames.size());
+			}
+
+			if (ImGui::CollapsingHeader("Scene")) {
+				GameScene::sptr active = Application::Instance().ActiveScene;
+				if (active != nullptr) {
+					if (ImGui::Button("Save Binary")) {
+						SceneSerializer::SaveToFile(*active, "scene.bin", SceneFormat::CompressedBinary);
+					}
+					ImGui::SameLine();
+					if (ImGui::Button("Save JSON")) {
+						SceneSerializer::SaveToFile(*active, "scene.json", SceneFormat::Json);
+					}
+					ImGui::SameLine();
+					if (ImGui::Button("Round Trip")) {
+						// Saves and re-loads the scene in memory, without touching the active scene
+						const double start = glfwGetTime();
+						const std::string data = SceneSerializer::SaveToString(*active, SceneFormat::CompressedBinary);
+						const double saved = glfwGetTime();
+						GameScene::sptr copy = SceneSerializer::LoadFromString(data);
+						const double loaded = glfwGetTime();
+						char buffer[256];
+						snprintf(buffer, sizeof(buffer), "%s: %u bytes, saved in %.2f ms, loaded in %.2f ms, %u / %u entities",
+							copy != nullptr && copy->Registry().alive() == active->Registry().alive() ? "OK" : "FAILED",
+							(uint32_t)data.size(), (saved - start) * 1000.0, (loaded - saved) * 1000.0,
+							copy != nullptr ? (uint32_t)copy->Registry().alive() : 0u, (uint32_t)active->Registry().alive());
+						sceneRoundTrip = buffer;
+					}
+					ImGui::TextUnformatted(sceneRoundTrip.c_str());
+				}
+			}
+
+			if (ImGui::CollapsingHeader("World Streaming")) {
+				if (worldStreamer == nullptr) {
+					ImGui::SliderInt("Props", &streamedProps, 1000, 200000);
+					if (ImGui::Button("Generate Streamed World")) {
+						GameScene::sptr active = Application::Instance().ActiveScene;
+						WorldStreamer::Settings settings;
+						settings.CellSize = 16.0f;
+						settings.LoadRadius = 32.0f;
+						settings.UnloadRadius = 48.0f;
+						settings.EntityBudget = 256;
+						worldStreamer = std::make_unique<WorldStreamer>(active, settings);
+
+						// Scatter trees over a big area (leaving the shrine clear), then move them into cells so that
+						// only the ones near the camera are in the scene
+						entt::registry& prefabs = GameScene::Prefabs();
+						entt::entity prefab = prefabs.create();
+						prefabs.emplace<GameObjectTag>(prefab, "streamed_tree");
+						prefabs.emplace<RendererComponent>(prefab)
+							.SetMesh(AssetLibrary<VertexArrayObject>::Load("models/simpleTree.obj"))
+							.SetMaterial(AssetLibrary<ShaderMaterial>::Load("simple_flora"));
+						std::vector<InstanceTransform> transforms(streamedProps);
+						for (InstanceTransform& transform : transforms) {
+							transform.Position = glm::vec3(Util::GetRandomNumberBetween(glm::vec2(-256.0f), glm::vec2(256.0f),
+								{ glm::vec2(-8.0f) }, { glm::vec2(8.0f) }), 0.0f);
+							transform.Rotation = glm::quat(glm::vec3(glm::radians(90.0f), 0.0f, glm::radians(Util::GetRandomNumberBetween(0.0f, 360.0f))));
+						}
+						const std::vector<entt::entity> trees = active->StampMany(prefab, transforms.size(), transforms.data());
+						prefabs.destroy(prefab);
+						worldStreamer->BakeCells(trees);
+					}
+				} else {
+					const WorldStreamer::Stats& stats = worldStreamer->GetStats();
+					ImGui::Text("Cells: %u resident / %u total", stats.Resident, stats.Cells);
+					ImGui::Text("Loading: %u  Waiting on budget: %u", stats.Loading, stats.Waiting);
+					ImGui::Text("Resident entities: %u (%.1f KB of cell data)", stats.ResidentEntities, stats.ResidentBytes / 1024.0f);
+					ImGui::Text("This frame: +%u / -%u entities", stats.CreatedThisFrame, stats.RemovedThisFrame);
+					ImGui::Text("Loads: %llu  Unloads: %llu", (unsigned long long)stats.TotalLoads, (unsigned long long)stats.TotalUnloads);
+					WorldStreamer::Settings settings = worldStreamer->GetSettings();
+					bool changed = ImGui::DragFloat("Load Radius", &settings.LoadRadius, 1.0f, 0.0f, 256.0f);
+					changed |= ImGui::DragFloat("Unload Radius", &settings.UnloadRadius, 1.0f, 0.0f, 256.0f);
+					int budget = static_cast<int>(settings.EntityBudget);
+					if (ImGui::SliderInt("Entity Budget", &budget, 1, 4096)) {
+						settings.EntityBudget = static_cast<uint32_t>(budget);
+						changed = true;
+					}
+					if (changed) {
+						worldStreamer->SetSettings(settings);
+					}
+					if (ImGui::Button("Remove Streamed World")) {
+						worldStreamer->UnloadAll();
+						worldStreamer.reset();
+					}
+				}
+			}
+
+			if (ImGui::CollapsingHeader("Systems")) {
+				Timing& timer = Timing::Instance();
+				float fixedRate = 1.0f / timer.FixedTimeStep;
+				if (ImGui::SliderFloat("Fixed Rate", &fixedRate, 10.0f, 240.0f)) {
+					timer.SetFixedRate(fixedRate);
+				}
+				ImGui::SliderInt("Max Fixed Steps", &timer.MaxFixedStepsPerFrame, 1, 20);
+
+				const RenderThread::Stats renderStats = RenderThread::GetStats();
+				ImGui::Text("Render thread: %s  Render: %.3f ms  Idle: %.3f ms  Waited: %.3f ms", RenderThread::IsRunning() ? "on" : "off",
+					renderStats.RenderMs, renderStats.IdleMs, renderStats.WaitMs);
+
+				const JobSystem::Stats jobStats = JobSystem::GetStats();
+				ImGui::Text("Jobs: %llu run, %llu stolen", (unsigned long long)jobStats.Executed, (unsigned long long)jobStats.Stolen);
+
+				const SystemScheduler::FrameReport& report = systems.GetLastReport();
+				ImGui::Text("Wall: %.3f ms  Critical path: %.3f ms  Workers: %u", report.WallMs, report.CriticalPathMs, (uint32_t)systems.GetWorkerCount());
+				for (size_t ix = 0; ix < report.Systems.size(); ix++) {
+					const SystemScheduler::SystemTiming& timing = report.Systems[ix];
+					const bool isCritical = std::find(report.CriticalPath.begin(), report.CriticalPath.end(), ix) != report.CriticalPath.end();
+					ImGui::Text("%c %-16s %7.3f ms (+%.3f)%s", isCritical ? '*' : ' ', timing.Name.c_str(), timing.DurationMs, timing.StartMs, timing.OnMainThread ? " [main]" : "");
+				}
+				if (Application::Instance().ActiveScene != nullptr) {
+					const BehaviourBinding::RateStats rates = BehaviourBinding::GetRateStats(Application::Instance().ActiveScene->Registry());
+					ImGui::Text("Behaviour updates: %llu run, %llu skipped", (unsigned long long)rates.Invoked, (unsigned long long)rates.Skipped);
+				}
+				for (const std::string& violation : report.AccessViolations) {
+					ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", violation.c_str());
+				}
+			}
 			});
 
 		#pragma endregion 
@@ -273,9 +522,21 @@ int main() {
 		
 		// We need to tell our scene system what extra component types we want to support
 		GameScene::RegisterComponentType<RendererComponent>();
-		GameScene::RegisterComponentType<BehaviourBinding>();
 		GameScene::RegisterComponentType<Camera>();
 
+		// Anything we want to save with the scene needs to be registered with the serializer as well
+		SceneSerializer::RegisterType<RendererComponent>("Renderer");
+		SceneSerializer::RegisterType<Camera>("Camera");
+		SceneSerializer::RegisterBehaviour<CameraControlBehaviour>("CameraControl");
+		SceneSerializer::RegisterBehaviour<FollowPathBehaviour>("FollowPath");
+		SceneSerializer::RegisterBehaviour<SimpleMoveBehaviour>("SimpleMove");
+
+		// Meshes are loaded through the asset library, so each model is only loaded once, and renderers can be saved
+		// as the path to their mesh. The buffers have to be made on the thread that owns the context
+		AssetLibrary<VertexArrayObject>::SetLoader([](const std::string& path) {
+			return RenderThread::Call([&path]() { return ObjLoader::LoadFromFile(path); });
+		});
+
 		// Create a scene, and set it to be the active scene in the application
 		GameScene::sptr scene = GameScene::Create("test");
 		Application::Instance().ActiveScene = scene;
@@ -287,7 +548,7 @@ int main() {
 
 		// Create a material and set some properties for it
 		ShaderMaterial::sptr stoneMat = ShaderMaterial::Create();  
-		stoneMat->Shader = shader;
+		stoneMat->SetShader(shader);
 		stoneMat->Set("s_Diffuse", stone);
 		stoneMat->Set("s_Specular", stoneSpec);
 		stoneMat->Set("u_Shininess", 2.0f);
@@ -296,7 +557,7 @@ int main() {
 		mats.push_back(stoneMat);
 
 		ShaderMaterial::sptr grassMat = ShaderMaterial::Create();
-		grassMat->Shader = shader;
+		grassMat->SetShader(shader);
 		grassMat->Set("s_Diffuse", grass);
 		grassMat->Set("s_Specular", noSpec);
 		grassMat->Set("u_Shininess", 2.0f);
@@ -305,7 +566,7 @@ int main() {
 
 
 		ShaderMaterial::sptr boxMat = ShaderMaterial::Create();
-		boxMat->Shader = shader;
+		boxMat->SetShader(shader);
 		boxMat->Set("s_Diffuse", box);
 		boxMat->Set("s_Specular", boxSpec);
 		boxMat->Set("u_Shininess", 8.0f);
@@ -313,7 +574,7 @@ int main() {
 		mats.push_back(boxMat);
 
 		ShaderMaterial::sptr simpleFloraMat = ShaderMaterial::Create();
-		simpleFloraMat->Shader = shader;
+		simpleFloraMat->SetShader(shader);
 		simpleFloraMat->Set("s_Diffuse", simpleFlora);
 		simpleFloraMat->Set("s_Specular", noSpec);
 		simpleFloraMat->Set("u_Shininess", 8.0f);
@@ -321,7 +582,7 @@ int main() {
 		mats.push_back(simpleFloraMat);
 
 		ShaderMaterial::sptr shrineMat = ShaderMaterial::Create();
-		shrineMat->Shader = shader;
+		shrineMat->SetShader(shader);
 		shrineMat->Set("s_Diffuse", shrineCol);
 		shrineMat->Set("s_Specular", noSpec);
 		shrineMat->Set("u_Shininess", 8.0f);
@@ -329,7 +590,7 @@ int main() {
 		mats.push_back(shrineMat);
 
 		ShaderMaterial::sptr dcrystalMat = ShaderMaterial::Create();
-		dcrystalMat->Shader = shader;
+		dcrystalMat->SetShader(shader);
 		dcrystalMat->Set("s_Diffuse", crystalNor);
 		dcrystalMat->Set("s_Diffuse2", crystalGlow);
 		dcrystalMat->Set("s_Specular", crystalDif);
@@ -338,7 +599,7 @@ int main() {
 		mats.push_back(dcrystalMat);
 
 		ShaderMaterial::sptr crystalMat = ShaderMaterial::Create();
-		crystalMat->Shader = shader;
+		crystalMat->SetShader(shader);
 		crystalMat->Set("s_Diffuse", crystalNor);
 		crystalMat->Set("s_Diffuse2", crystalDif);
 		crystalMat->Set("s_Specular", crystalGlow);
@@ -346,11 +607,20 @@ int main() {
 		crystalMat->Set("u_TextureMix", 0.7f);
 		mats.push_back(crystalMat);
 
+		// Materials are made in code, so they are saved with scenes by name
+		AssetLibrary<ShaderMaterial>::Add("stone", stoneMat);
+		AssetLibrary<ShaderMaterial>::Add("grass", grassMat);
+		AssetLibrary<ShaderMaterial>::Add("box", boxMat);
+		AssetLibrary<ShaderMaterial>::Add("simple_flora", simpleFloraMat);
+		AssetLibrary<ShaderMaterial>::Add("shrine", shrineMat);
+		AssetLibrary<ShaderMaterial>::Add("dark_crystal", dcrystalMat);
+		AssetLibrary<ShaderMaterial>::Add("crystal", crystalMat);
+
 		int spin = 0;
 
 		GameObject obj1 = scene->CreateEntity("Ground"); 
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/plane.obj");
+			VertexArrayObject::sptr vao = AssetLibrary<VertexArrayObject>::Load("models/plane.obj");
 			obj1.emplace<RendererComponent>().SetMesh(vao).SetMaterial(stoneMat);
 			obj1.get<Transform>().SetLocalScale(0.35f, 0.35f, 1.0f);
 
@@ -358,7 +628,7 @@ int main() {
 
 		GameObject obj2 = scene->CreateEntity("shrine");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/shrine.obj");
+			VertexArrayObject::sptr vao = AssetLibrary<VertexArrayObject>::Load("models/shrine.obj");
 			obj2.emplace<RendererComponent>().SetMesh(vao).SetMaterial(shrineMat);
 			obj2.get<Transform>().SetLocalPosition(0.0f, 0.0f, 0.0f);
 			obj2.get<Transform>().SetLocalRotation(90.0f, 0.0f, -90.0f);
@@ -366,7 +636,7 @@ int main() {
 		}
 		GameObject obj3 = scene->CreateEntity("crystal_mid");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/crystal.obj");
+			VertexArrayObject::sptr vao = AssetLibrary<VertexArrayObject>::Load("models/crystal.obj");
 			obj3.emplace<RendererComponent>().SetMesh(vao).SetMaterial(crystalMat);
 			obj3.get<Transform>().SetLocalPosition(0.0f, 0.0f, 5.0f);
 			obj3.get<Transform>().SetLocalRotation(90.0f, 0.0f, -90.0f);
@@ -381,12 +651,14 @@ int main() {
 		
 		GameObject obj5 = scene->CreateEntity("crystal_left");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/crystal.obj");
+			VertexArrayObject::sptr vao = AssetLibrary<VertexArrayObject>::Load("models/crystal.obj");
 			obj5.emplace<RendererComponent>().SetMesh(vao).SetMaterial(dcrystalMat);
 			obj5.get<Transform>().SetLocalPosition(4.5f, -4.0f, 1.0f);
 			obj5.get<Transform>().SetLocalRotation(90.0f, 0.0f, -90.0f);
 			
 			auto pathing = BehaviourBinding::Bind<FollowPathBehaviour>(obj5);
+			// The path followers only need a few ticks a second once they're far from the camera
+			pathing->Rate = UpdateRate::ByDistance(12.0f, 4);
 			pathing->Points.push_back({ 4.5f, 4.0f, 1.0f });
 			pathing->Points.push_back({ 4.5f, -4.0f, 1.0f });
 
@@ -394,12 +666,13 @@ int main() {
 		}
 		GameObject obj6 = scene->CreateEntity("crystal_up");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/crystal.obj");
+			VertexArrayObject::sptr vao = AssetLibrary<VertexArrayObject>::Load("models/crystal.obj");
 			obj6.emplace<RendererComponent>().SetMesh(vao).SetMaterial(dcrystalMat);
 			obj6.get<Transform>().SetLocalPosition(4.5f, 4.0f, 1.0f);
 			obj6.get<Transform>().SetLocalRotation(90.0f, 0.0f, -90.0f);
 
 			auto pathing = BehaviourBinding::Bind<FollowPathBehaviour>(obj6);
+			pathing->Rate = UpdateRate::ByDistance(12.0f, 4);
 			pathing->Points.push_back({ -4.25f, 4.0f, 1.0f });
 			pathing->Points.push_back({ 4.5f, 4.0f, 1.0f });
 
@@ -407,12 +680,13 @@ int main() {
 		}
 		GameObject obj7 = scene->CreateEntity("crystal_right");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/crystal.obj");
+			VertexArrayObject::sptr vao = AssetLibrary<VertexArrayObject>::Load("models/crystal.obj");
 			obj7.emplace<RendererComponent>().SetMesh(vao).SetMaterial(dcrystalMat);
 			obj7.get<Transform>().SetLocalPosition(-4.25f, -4.25f, 1.0f);
 			obj7.get<Transform>().SetLocalRotation(90.0f, 0.0f, -90.0f);
 
 			auto pathing = BehaviourBinding::Bind<FollowPathBehaviour>(obj7);
+			pathing->Rate = UpdateRate::ByDistance(12.0f, 4);
 			pathing->Points.push_back({ 4.5f, -4.0f, 1.0f });
 			pathing->Points.push_back({ -4.25f, -4.25f, 1.0f });
 
@@ -421,12 +695,13 @@ int main() {
 
 		GameObject obj8 = scene->CreateEntity("crystal_down");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/crystal.obj");
+			VertexArrayObject::sptr vao = AssetLibrary<VertexArrayObject>::Load("models/crystal.obj");
 			obj8.emplace<RendererComponent>().SetMesh(vao).SetMaterial(dcrystalMat);
 			obj8.get<Transform>().SetLocalPosition(-4.25f, 4.0f, 1.0f);
 			obj8.get<Transform>().SetLocalRotation(90.0f, 0.0f, -90.0f);
 
 			auto pathing = BehaviourBinding::Bind<FollowPathBehaviour>(obj8);
+			pathing->Rate = UpdateRate::ByDistance(12.0f, 4);
 			pathing->Points.push_back({ -4.25f, -4.25f, 1.0f });
 			pathing->Points.push_back({ -4.25f, 4.0f, 1.0f });
 
@@ -482,7 +757,7 @@ int main() {
 			skybox->Link();
 
 			ShaderMaterial::sptr skyboxMat = ShaderMaterial::Create();
-			skyboxMat->Shader = skybox;  
+			skyboxMat->SetShader(skybox);
 			skyboxMat->Set("s_Environment", environmentMap);
 			skyboxMat->Set("u_EnvironmentRotation", glm::mat3(glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(1, 0, 0))));
 			skyboxMat->RenderLayer = 100;
@@ -499,25 +774,35 @@ int main() {
 		////////////////////////////////////////////////////////////////////////////////////////
 
 
-		// We'll use a vector to store all our key press events for now (this should probably be a behaviour eventually)
+		// We'll use a vector to store all our key press events for now. Each watcher is a coroutine owned by the camera,
+		// resumed by the Behaviours system on the frame it's key is pressed
 		std::vector<KeyPressWatcher> keyToggles;
 		{
+			// We'll make sure our UI isn't focused before we handle input for our game
+			auto addToggle = [&](int key, const std::function<void()>& onPressed) {
+				keyToggles.emplace_back(cameraObject, key, [onPressed]() {
+					if (!ImGui::IsAnyWindowFocused()) {
+						onPressed();
+					}
+				});
+			};
+
 			// This is an example of a key press handling helper. Look at InputHelpers.h an .cpp to see
 			// how this is implemented. Note that the ampersand here is capturing the variables within
 			// the scope. If you wanted to do some method on the class, your best bet would be to give it a method and
 			// use std::bind
-			keyToggles.emplace_back(GLFW_KEY_T, [&]() { cameraObject.get<Camera>().ToggleOrtho(); });
+			addToggle(GLFW_KEY_T, [&]() { cameraObject.get<Camera>().ToggleOrtho(); });
 
 			controllables.push_back(obj2);
 
-			keyToggles.emplace_back(GLFW_KEY_KP_ADD, [&]() {
+			addToggle(GLFW_KEY_KP_ADD, [&]() {
 				BehaviourBinding::Get<SimpleMoveBehaviour>(controllables[selectedVao])->Enabled = false;
 				selectedVao++;
 				if (selectedVao >= controllables.size())
 					selectedVao = 0;
 				BehaviourBinding::Get<SimpleMoveBehaviour>(controllables[selectedVao])->Enabled = true;
 				});
-			keyToggles.emplace_back(GLFW_KEY_KP_SUBTRACT, [&]() {
+			addToggle(GLFW_KEY_KP_SUBTRACT, [&]() {
 				BehaviourBinding::Get<SimpleMoveBehaviour>(controllables[selectedVao])->Enabled = false;
 				selectedVao--;
 				if (selectedVao < 0)
@@ -525,58 +810,118 @@ int main() {
 				BehaviourBinding::Get<SimpleMoveBehaviour>(controllables[selectedVao])->Enabled = true;
 				});
 
-			keyToggles.emplace_back(GLFW_KEY_Y, [&]() {
+			addToggle(GLFW_KEY_Y, [&]() {
 				auto behaviour = BehaviourBinding::Get<SimpleMoveBehaviour>(controllables[selectedVao]);
 				behaviour->Relative = !behaviour->Relative;
 				});
 		}
 
-		// Initialize our timing instance and grab a reference for our use
-		Timing& time = Timing::Instance();
-		time.LastFrame = glfwGetTime();
-
-		///// Game loop /////
-		while (!glfwWindowShouldClose(BackendHandler::window)) {
-			glfwPollEvents();
-
-			// Update the timing
-			time.CurrentFrame = glfwGetTime();
-			time.DeltaTime = static_cast<float>(time.CurrentFrame - time.LastFrame);
-
-			time.DeltaTime = time.DeltaTime > 1.0f ? 1.0f : time.DeltaTime;
-
-			obj3.get<Transform>().SetLocalRotation(90.0f, 0.0f, spin % 360);
-			obj5.get<Transform>().SetLocalRotation(90.0f, 0.0f, -(2*spin % 360));
-			obj6.get<Transform>().SetLocalRotation(90.0f, 0.0f, -(2*spin % 360));
-			obj7.get<Transform>().SetLocalRotation(90.0f, 0.0f, -(2*spin % 360));
-			obj8.get<Transform>().SetLocalRotation(90.0f, 0.0f, -(2*spin % 360));
-			spin++;
+		// Set up the per-frame systems. Systems that don't share any written components can run at the same time,
+		// anything that talks to OpenGL or GLFW has to stay on the main thread. Materials live in their ResourcePool
+		// rather than the registry, but systems still declare ShaderMaterial so they are ordered against each other.
+		// Behaviours can add renderers and edit materials, so the systems that run them write both. The key toggles
+		// are resumed from the Behaviours system, and they change the camera
+		systems.AddSystem("Fixed Update", [&](SystemContext& context) {
+			// Run the simulation at a fixed rate, the transform store remembers where things were before each tick
+			// so we can interpolate between ticks when rendering
+			TransformStore& transforms = TransformStore::Get(context.Registry);
+			// Behaviour update rates are based on how far things are from the camera
+			BehaviourBinding::SetLodOrigin(context.Registry, glm::vec3(cameraObject.get<Transform>().WorldTransform()[3]));
+			const int steps = Timing::Instance().ConsumeFixedSteps();
+			for (int ix = 0; ix < steps; ix++) {
+				transforms.BeginFixedStep();
+				BehaviourBinding::FixedUpdate(context.Registry);
+				CoroutineScheduler::Get(context.Registry).FixedTick();
+
+				obj3.get<Transform>().SetLocalRotation(90.0f, 0.0f, spin % 360);
+				obj5.get<Transform>().SetLocalRotation(90.0f, 0.0f, -(2*spin % 360));
+				obj6.get<Transform>().SetLocalRotation(90.0f, 0.0f, -(2*spin % 360));
+				obj7.get<Transform>().SetLocalRotation(90.0f, 0.0f, -(2*spin % 360));
+				obj8.get<Transform>().SetLocalRotation(90.0f, 0.0f, -(2*spin % 360));
+				spin++;
+
+				transforms.EndFixedStep();
+			}
+		}).Writes<Transform, RendererComponent, ShaderMaterial>().MainThread();
+
+		systems.AddSystem("Behaviours", [&](SystemContext& context) {
+			// Update all the behaviours, one behaviour type at a time, then resume any coroutines that are due
+			BehaviourBinding::Update(context.Registry);
+			CoroutineScheduler::Get(context.Registry).Update();
+		}).Writes<Transform, RendererComponent, ShaderMaterial, Camera>().MainThread();
+
+		systems.AddSystem("Transforms", [&](SystemContext& context) {
+			// Update the world matrices of anything that moved this frame
+			TransformStore::Get(context.Registry).UpdateWorldMatrices();
+		}).Writes<Transform>();
+
+		systems.AddSystem("Late Update", [&](SystemContext& context) {
+			// Late updates can see this frame's world matrices, anything they move gets picked up by a second pass
+			BehaviourBinding::LateUpdate(context.Registry);
+			TransformStore& transforms = TransformStore::Get(context.Registry);
+			transforms.UpdateWorldMatrices();
+			transforms.Interpolate(Timing::Instance().FixedAlpha);
+		}).Writes<Transform, RendererComponent, ShaderMaterial>().MainThread();
+
+		// A sort key for each material, indexed by the material's handle, so sorting never has to look at the materials
+		std::vector<uint64_t> materialKeys;
+
+		systems.AddSystem("Sort Renderers", [&](SystemContext&) {
+			// Sort the renderers by shader and material, we will go for a minimizing context switches approach here,
+			// but you could for instance sort front to back to optimize for fill rate if you have intensive fragment shaders
+			materialKeys.assign(ResourcePool<ShaderMaterial>::GetSlotCount(), 0);
+			ResourcePool<ShaderMaterial>::ForEach([&](MaterialHandle handle, ShaderMaterial& material) {
+				if (handle.Index() >= materialKeys.size()) {
+					return;
+				}
+				// Render layer first (higher numbers get drawn last), then shader (so materials using the same shader run
+				// sequentially where possible), then material (so we can minimize switching between materials)
+				const uint64_t layer = static_cast<uint16_t>(material.RenderLayer + 0x8000);
+				materialKeys[handle.Index()] = (layer << 40) | (uint64_t(material.GetShaderHandle().Index()) << 20) | handle.Index();
+			});
+			auto keyOf = [&](const RendererComponent& renderer) {
+				return renderer.Material.Index() < materialKeys.size() ? materialKeys[renderer.Material.Index()] : UINT64_MAX;
+			};
+
+			renderGroup.sort<RendererComponent>([&](const RendererComponent& l, const RendererComponent& r) {
+				const uint64_t lKey = keyOf(l);
+				const uint64_t rKey = keyOf(r);
+				if (lKey != rKey) return lKey < rKey;
+				// Keep renderers with the same mesh together as well
+				return l.Mesh.Index() < r.Mesh.Index();
+			});
+		}).Reads<ShaderMaterial>().Writes<RendererComponent>();
 
-			// Update our FPS tracker data
-			fpsBuffer[frameIx] = 1.0f / time.DeltaTime;
-			frameIx++;
-			if (frameIx >= 128)
-				frameIx = 0;
+		// Each frame is built into one snapshot while the render thread draws the last one from the other, so the
+		// render thread never has to look at the scene
+		RenderSnapshot snapshots[2];
+		RenderSnapshot* buildSnapshot = &snapshots[0];
 
-			// We'll make sure our UI isn't focused before we start handling input for our game
-			if (!ImGui::IsAnyWindowFocused()) {
-				// We need to poll our key watchers so they can do their logic with the GLFW state
-				// Note that since we want to make sure we don't copy our key handlers, we need a const
-				// reference!
-				for (const KeyPressWatcher& watcher : keyToggles) {
-					watcher.Poll(BackendHandler::window);
-				}
-			}
+		systems.AddSystem("Build Snapshot", [&](SystemContext&) {
+			// Grab out camera info from the camera object
+			buildSnapshot->View = cameraObject.get<Transform>().WorldInverse();
+			buildSnapshot->Projection = cameraObject.get<Camera>().GetProjection();
 
-			// Iterate over all the behaviour binding components
-			scene->Registry().view<BehaviourBinding>().each([&](entt::entity entity, BehaviourBinding& binding) {
-				// Iterate over all the behaviour scripts attached to the entity, and update them in sequence (if enabled)
-				for (const auto& behaviour : binding.Behaviours) {
-					if (behaviour->Enabled) {
-						behaviour->Update(entt::handle(scene->Registry(), entity));
-					}
-				}
+			// Copy out everything we need to draw the renderers, they're already sorted so the render thread can draw
+			// them in order
+			renderGroup.each([&](RendererComponent& renderer, Transform& transform) {
+				buildSnapshot->AddPacket(renderer.Mesh, renderer.Material, transform.RenderTransform(), transform.RenderNormalMatrix());
 			});
+		}).Reads<Transform, RendererComponent, Camera>();
+
+		// Does all of the OpenGL work for a frame, this runs on the render thread when there is one
+		auto renderFrame = [&](RenderSnapshot& snapshot) {
+			// Don't let the GPU fall too far behind, or everything we draw will be showing old input
+			FramePacer::WaitForGpu();
+			// Get through some of the deferred GL work (like resizing buffers) before anything is drawn with it
+			BackendHandler::renderTasks.Update(snapshot.TaskBudgetMs);
+			GL_TRACE_BEGIN_FRAME();
+			GpuProfiler::BeginFrame();
+
+			// Apply this frame's post processing settings
+			bloomEffect->SetThreshold(snapshot.Post.BloomThreshold);
+			bloomEffect->SetPasses(snapshot.Post.BloomPasses);
+			PostEffect* activeEffect = effects[snapshot.Post.ActiveEffect];
 
 			// Clear the screen
 			basicEffect->Clear();
@@ -593,79 +938,228 @@ int main() {
 			glClearDepth(1.0f);
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-			// Update all world matrices for this frame
-			scene->Registry().view<Transform>().each([](entt::entity entity, Transform& t) {
-				t.UpdateWorldMatrix();
-			});
-			
-			// Grab out camera info from the camera object
-			Transform& camTransform = cameraObject.get<Transform>();
-			glm::mat4 view = glm::inverse(camTransform.LocalTransform());
-			glm::mat4 projection = cameraObject.get<Camera>().GetProjection();
-			glm::mat4 viewProjection = projection * view;
-						
-			// Sort the renderers by shader and material, we will go for a minimizing context switches approach here,
-			// but you could for instance sort front to back to optimize for fill rate if you have intensive fragment shaders
-			renderGroup.sort<RendererComponent>([](const RendererComponent& l, const RendererComponent& r) {
-				// Sort by render layer first, higher numbers get drawn last
-				if (l.Material->RenderLayer < r.Material->RenderLayer) return true;
-				if (l.Material->RenderLayer > r.Material->RenderLayer) return false;
-
-				// Sort by shader pointer next (so materials using the same shader run sequentially where possible)
-				if (l.Material->Shader < r.Material->Shader) return true;
-				if (l.Material->Shader > r.Material->Shader) return false;
-
-				// Sort by material pointer last (so we can minimize switching between materials)
-				if (l.Material < r.Material) return true;
-				if (l.Material > r.Material) return false;
-				
-				return false;
-			});
+			glm::mat4 viewProjection = snapshot.Projection * snapshot.View;
 
 			// Start by assuming no shader or material is applied
-			Shader::sptr current = nullptr;
-			ShaderMaterial::sptr currentMat = nullptr;
+			Shader* current = nullptr;
+			ShaderMaterial* currentMat = nullptr;
 
+			GpuProfiler::BeginRegion("Scene");
 			basicEffect->BindBuffer(0);
 
-			// Iterate over the render group components and draw them
-			renderGroup.each( [&](entt::entity e, RendererComponent& renderer, Transform& transform) {
+			// Each render layer gets it's own GPU timing region
+			int currentLayer = 0;
+			bool isLayerOpen = false;
+
+			// Draw everything in the snapshot
+			for (const DrawPacket& packet : snapshot.Packets) {
+				GL_TRACE_SCOPE("Scene Render");
+				if (!isLayerOpen || currentLayer != packet.Material->RenderLayer) {
+					if (isLayerOpen) {
+						GpuProfiler::EndRegion();
+					}
+					currentLayer = packet.Material->RenderLayer;
+					GpuProfiler::BeginRegion("Layer " + std::to_string(currentLayer));
+					isLayerOpen = true;
+				}
 				// If the shader has changed, set up it's uniforms
-				if (current != renderer.Material->Shader) {
-					current = renderer.Material->Shader;
+				if (current != packet.Material->GetShader()) {
+					current = packet.Material->GetShader();
 					current->Bind();
-					BackendHandler::SetupShaderForFrame(current, view, projection);
+					BackendHandler::SetupShaderForFrame(*current, snapshot.View, snapshot.Projection);
 				}
 				// If the material has changed, apply it
-				if (currentMat != renderer.Material) {
-					currentMat = renderer.Material;
+				if (currentMat != packet.Material) {
+					currentMat = packet.Material;
 					currentMat->Apply();
 				}
 				// Render the mesh
-				BackendHandler::RenderVAO(renderer.Material->Shader, renderer.Mesh, viewProjection, transform);
-			});
+				BackendHandler::RenderVAO(*current, *packet.Mesh, viewProjection, packet.Model, packet.NormalMatrix);
+			}
 
+			if (isLayerOpen) {
+				GpuProfiler::EndRegion();
+			}
 			basicEffect->UnbindBuffer();
+			GpuProfiler::EndRegion();
 
-			effects[activeEffect]->ApplyEffect(basicEffect);
-			
-			effects[activeEffect]->DrawToScreen();
+			{
+				GL_TRACE_SCOPE("Post Effects");
+				{
+					GPU_PROFILE_SCOPE("Post Effects");
+					activeEffect->Apply(basicEffect);
+				}
+				{
+					GPU_PROFILE_SCOPE("Draw To Screen");
+					activeEffect->DrawToScreen();
+				}
+			}
 			
 			// Draw our ImGui content
-			BackendHandler::RenderImGui();
+			{
+				GPU_PROFILE_SCOPE("ImGui");
+				BackendHandler::DrawImGui(snapshot.Gui.GetDrawData());
+			}
 
-			scene->Poll();
+			GpuProfiler::EndFrame();
 			glfwSwapBuffers(BackendHandler::window);
-			time.LastFrame = time.CurrentFrame;
+			FramePacer::EndFrame(snapshot.FrameId);
+			// Release any GPU resources that were dropped a few frames ago and are no longer in use
+			GpuDeletionQueue::EndFrame();
+			GL_TRACE_END_FRAME();
+		};
+
+		// The pools hold on to resources until they are removed, so once renderers go away we look for anything that
+		// nothing refers to any more. Materials are marked before they are removed, so their shaders and textures are
+		// only picked up once the materials have actually been released
+		auto removeUnusedResources = [&]() {
+			std::vector<bool> meshes(ResourcePool<VertexArrayObject>::GetSlotCount(), false);
+			std::vector<bool> materials(ResourcePool<ShaderMaterial>::GetSlotCount(), false);
+			auto markRenderers = [&](entt::registry& registry) {
+				registry.view<RendererComponent>().each([&](const RendererComponent& renderer) {
+					if (!renderer.Mesh.IsNull() && renderer.Mesh.Index() < meshes.size()) meshes[renderer.Mesh.Index()] = true;
+					if (!renderer.Material.IsNull() && renderer.Material.Index() < materials.size()) materials[renderer.Material.Index()] = true;
+				});
+			};
+			markRenderers(scene->Registry());
+			markRenderers(GameScene::Prefabs());
+
+			std::vector<bool> shaders(ResourcePool<Shader>::GetSlotCount(), false);
+			std::vector<bool> textures(ResourcePool<ITexture>::GetSlotCount(), false);
+			ResourcePool<ShaderMaterial>::ForEach([&](MaterialHandle, ShaderMaterial& material) {
+				for (ShaderHandle shader : { material.GetShaderHandle(), material.GetBaseShaderHandle() }) {
+					if (!shader.IsNull() && shader.Index() < shaders.size()) shaders[shader.Index()] = true;
+				}
+				for (const auto& kvp : material.Textures) {
+					if (!kvp.second.IsNull() && kvp.second.Index() < textures.size()) textures[kvp.second.Index()] = true;
+				}
+			});
+
+			ResourcePool<VertexArrayObject>::RemoveUnused(meshes);
+			ResourcePool<ShaderMaterial>::RemoveUnused(materials);
+			ResourcePool<Shader>::RemoveUnused(shaders);
+			ResourcePool<ITexture>::RemoveUnused(textures);
+		};
+		// Counts the resources released at the start of the frame, their shaders and textures may be unused now
+		size_t releasedResources = 0;
+		uint64_t collectedDestroyedEntities = 0;
+
+		// Initialize our timing instance and grab a reference for our use
+		Timing& time = Timing::Instance();
+		time.LastFrame = glfwGetTime();
+		// The scene was tuned at 60 FPS, so simulate at the same rate
+		time.SetFixedRate(60.0f);
+
+		///// Game loop /////
+		// Hand the context over to the render thread, from here on anything that touches OpenGL has to go through it
+		if (BackendHandler::useRenderThread) {
+			RenderThread::Start(BackendHandler::window);
 		}
+		// Listen for a few of the engine's events, the cells are loaded on the streamer's loader thread
+		EventBus::Subscribe<EntityDestroyedEvent>([&](const EntityDestroyedEvent&) {
+			destroyedEntities++;
+		}, EventPhase::FrameEnd);
+		EventBus::Subscribe<WorldCellLoadedEvent>([&](const WorldCellLoadedEvent& e) {
+			if (e.IsOk) {
+				loadedCells++;
+				loadedCellBytes += e.Bytes;
+			} else {
+				failedCells++;
+			}
+		});
+
+		while (!glfwWindowShouldClose(BackendHandler::window)) {
+			// Wait until the frame is due before we look at input, so the input is as fresh as it can be
+			const uint64_t frameId = FramePacer::BeginFrame(BackendHandler::window);
+			glfwPollEvents();
+
+			// Update the timing
+			time.CurrentFrame = glfwGetTime();
+			time.DeltaTime = static_cast<float>(time.CurrentFrame - time.LastFrame);
+
+			time.DeltaTime = time.DeltaTime > 1.0f ? 1.0f : time.DeltaTime;
 
+			// Build this frame's input snapshot from the events GLFW just gave us (this also applies recorded frame
+			// times when replaying input)
+			InputSystem::BeginFrame();
+			// Deliver anything that was published since last frame (ex: from other threads)
+			EventBus::Dispatch(EventPhase::FrameStart);
+
+			// Update our FPS tracker data
+			fpsBuffer[frameIx] = 1.0f / time.DeltaTime;
+			frameIx++;
+			if (frameIx >= 128)
+				frameIx = 0;
+
+			// Stream world cells in and out around the camera, this creates and removes entities so it happens
+			// before the systems run
+			if (worldStreamer != nullptr) {
+				worldStreamer->Update(glm::vec3(cameraObject.get<Transform>().WorldTransform()[3]));
+			}
+
+			// Work on anything that's been spread over multiple frames, this can also create and remove entities
+			tasks.Update(taskBudgetMs);
+
+			// Wait for a free snapshot, the render thread can only be one frame behind us
+			RenderSnapshot* snapshot = &snapshots[RenderThread::BeginFrame()];
+			buildSnapshot = snapshot;
+			// Let go of anything that was removed from the pools before a frame that has finished rendering
+			releasedResources = ResourcePool<VertexArrayObject>::ReleaseRetired() + ResourcePool<ShaderMaterial>::ReleaseRetired() +
+				ResourcePool<Shader>::ReleaseRetired() + ResourcePool<ITexture>::ReleaseRetired();
+			snapshot->Clear();
+			snapshot->FrameId = frameId;
+			snapshot->TaskBudgetMs = renderTaskBudgetMs;
+
+			// Run all of our per-frame systems (fixed and variable updates, transforms, sorting and building the snapshot)
+			systems.Run(scene->Registry());
+			EventBus::Dispatch(EventPhase::PostUpdate);
+			snapshot->Post = postSettings;
+
+			// Build our ImGui content, ImGui re-uses it's buffers next frame so we keep a copy for the render thread
+			BackendHandler::BuildImGui();
+			snapshot->Gui.Capture(ImGui::GetDrawData());
+
+			scene->Poll();
+			EventBus::Dispatch(EventPhase::FrameEnd);
+			if (destroyedEntities != collectedDestroyedEntities || releasedResources > 0) {
+				removeUnusedResources();
+				collectedDestroyedEntities = destroyedEntities;
+			}
+
+			// Draw the frame, this runs right away if there is no render thread
+			RenderThread::SubmitFrame([&renderFrame, snapshot]() { renderFrame(*snapshot); });
+			time.LastFrame = time.CurrentFrame;
+		}
+		// Let the render thread finish up and give the context back, the clean up below needs it
+		RenderThread::Stop();
+		// Anything that's still waiting is referencing things that are about to go away
+		BackendHandler::renderTasks.CancelAll();
+		tasks.CancelAll();
+		// The handlers reference the locals in here
+		EventBus::Clear();
+
+		// The streamer holds on to the scene as well
+		worldStreamer.reset();
 		// Nullify scene so that we can release references
 		Application::Instance().ActiveScene = nullptr;
 		//Clean up the environment generator so we can release references
 		EnvironmentGenerator::CleanUpPointers();
+		//The pools own the meshes, materials, shaders and textures, so release them while we still have a context
+		ResourcePool<VertexArrayObject>::Clear();
+		ResourcePool<ShaderMaterial>::Clear();
+		ResourcePool<Shader>::Clear();
+		ResourcePool<ITexture>::Clear();
 		BackendHandler::ShutdownImGui();
 	}	
 
+	// Finish off any jobs that are still running before we start tearing things down
+	JobSystem::Shutdown();
+
+	// Release everything that's still waiting in the deletion queue while we still have a context
+	GpuProfiler::Shutdown();
+	FramePacer::Shutdown();
+	GpuDeletionQueue::Flush();
+
 	// Clean up the toolkit logger so we don't leak memory
 	Logger::Uninitialize();
 	return 0;